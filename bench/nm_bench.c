@@ -0,0 +1,251 @@
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "nmsearch.h"
+#include "nm_bench.h"
+
+/* nm_bench [-s sizes] [-r reps] [-t threads] [-f filter] [-j] [-l]
+ *
+ * -s	Comma separated container sizes (default 1000,100000).
+ * -r	Runs per benchmark and size, the fastest is kept (default 3).
+ * -t	Threads of the parallel benchmarks (default 0, one per CPU).
+ * -f	Only run the benchmarks whose name contains 'filter'.
+ * -j	Print the results as JSON instead of a table.
+ * -l	List the benchmarks and exit. */
+
+#define NB_MAX_SIZES 16
+
+volatile uintptr_t nb_sink;
+
+static unsigned long nb_allocs;
+
+static const nb_bench *const nb_tables[] = {
+	nb_list_benches,
+	nb_vect_benches,
+	nb_tree_benches,
+	nb_queue_benches,
+	nb_misc_benches,
+	NULL
+};
+
+static void *nb_count_malloc(void *ctx, size_t size)
+{
+	(*(unsigned long*) ctx)++;
+	return malloc(size);
+}
+
+static void *nb_count_calloc(void *ctx, size_t nmemb, size_t size)
+{
+	(*(unsigned long*) ctx)++;
+	return calloc(nmemb, size);
+}
+
+static void *nb_count_realloc(void *ctx, void *ptr, size_t size)
+{
+	(*(unsigned long*) ctx)++;
+	return realloc(ptr, size);
+}
+
+static void nb_count_free(void *ctx, void *ptr)
+{
+	(void) ctx;
+	free(ptr);
+}
+
+static const nm_allocator nb_counting_allocator = {
+	nb_count_malloc, nb_count_calloc, nb_count_realloc, nb_count_free,
+	&nb_allocs
+};
+
+static double nb_now(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+void nb_start(nb_run *run)
+{
+	run->allocs_start = nb_allocs;
+	run->start = nb_now();
+}
+
+void nb_stop(nb_run *run, unsigned long ops)
+{
+	run->ns = nb_now() - run->start;
+	run->allocs = nb_allocs - run->allocs_start;
+	run->ops = ops;
+}
+
+unsigned int nb_slow_ops(const nb_run *run)
+{
+	return (run->n < NB_SLOW_OPS) ? run->n : NB_SLOW_OPS;
+}
+
+void nb_nop(void *data)
+{
+	(void) data;
+}
+
+int nb_cmp(const void *e1, const void *e2)
+{
+	return (NB_VAL(e1) > NB_VAL(e2)) - (NB_VAL(e1) < NB_VAL(e2));
+}
+
+int nb_qsort_cmp(const void *e1, const void *e2)
+{
+	return nb_cmp(*(void *const*) e1, *(void *const*) e2);
+}
+
+/* xorshift64, fixed seed so runs are reproducible. */
+static uint64_t nb_random(uint64_t *state)
+{
+	*state ^= *state << 13;
+	*state ^= *state >> 7;
+	*state ^= *state << 17;
+	return *state;
+}
+
+static int nb_keys(nb_run *run)
+{
+	uint64_t state = 0x9e3779b97f4a7c15ull;
+	unsigned int i, j;
+	void *tmp;
+	run->keys = malloc(run->n * sizeof(*run->keys));
+	run->sorted = malloc(run->n * sizeof(*run->sorted));
+	if (run->keys == NULL || run->sorted == NULL) {
+		return (-1);
+	}
+	for (i = 0; i < run->n; i++) {
+		run->sorted[i] = run->keys[i] = NB_KEY(i + 1);
+	}
+	for (i = run->n; i > 1; i--) {
+		j = (unsigned int) (nb_random(&state) % i);
+		tmp = run->keys[i - 1];
+		run->keys[i - 1] = run->keys[j];
+		run->keys[j] = tmp;
+	}
+	return (0);
+}
+
+static void nb_usage(const char *prog)
+{
+	fprintf(stderr, "usage: %s [-s sizes] [-r reps] [-t threads] "
+	        "[-f filter] [-j] [-l]\n", prog);
+}
+
+int main(int argc, char *argv[])
+{
+	unsigned int sizes[NB_MAX_SIZES] = { 1000, 100000 };
+	unsigned int nsizes = 2, reps = 3, threads = 0, s, r, t, b;
+	const char *filter = NULL, *sep = "";
+	int json = 0, list = 0, i;
+	char *p;
+	const nb_bench *bench;
+	nb_run run, best;
+	for (i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "-j") == 0) {
+			json = 1;
+		} else if (strcmp(argv[i], "-l") == 0) {
+			list = 1;
+		} else if (i + 1 < argc && strcmp(argv[i], "-s") == 0) {
+			for (nsizes = 0, p = argv[++i]; *p != '\0' && nsizes < NB_MAX_SIZES; ) {
+				if ((sizes[nsizes] = (unsigned int) strtoul(p, &p, 10)) > 0) {
+					nsizes++;
+				}
+				p += (*p == ',');
+			}
+		} else if (i + 1 < argc && strcmp(argv[i], "-r") == 0) {
+			reps = (unsigned int) strtoul(argv[++i], NULL, 10);
+		} else if (i + 1 < argc && strcmp(argv[i], "-t") == 0) {
+			threads = (unsigned int) strtoul(argv[++i], NULL, 10);
+		} else if (i + 1 < argc && strcmp(argv[i], "-f") == 0) {
+			filter = argv[++i];
+		} else {
+			nb_usage(argv[0]);
+			return EXIT_FAILURE;
+		}
+	}
+	memset(&best, 0, sizeof(best));
+	if (nsizes == 0 || reps == 0) {
+		nb_usage(argv[0]);
+		return EXIT_FAILURE;
+	}
+	if (list) {
+		for (t = 0; nb_tables[t] != NULL; t++) {
+			for (bench = nb_tables[t]; bench->name != NULL; bench++) {
+				printf("%s\n", bench->name);
+			}
+		}
+		return EXIT_SUCCESS;
+	}
+	if (threads == 0) {
+		/* One per CPU, as 'nmtpool_alloc(0)' does. */
+		threads = (sysconf(_SC_NPROCESSORS_ONLN) > 0) ?
+		          (unsigned int) sysconf(_SC_NPROCESSORS_ONLN) : 1;
+	}
+	if (json) {
+		printf("{\n  \"isa\": \"%s\",\n  \"threads\": %u,\n  \"results\": [",
+		       nmsearch_isa(), threads);
+	} else {
+		printf("# isa %s, %u threads\n", nmsearch_isa(), threads);
+		printf("%-40s %10s %12s %12s\n", "benchmark", "n", "ns/op", "allocs/op");
+	}
+	for (s = 0; s < nsizes; s++) {
+		memset(&run, 0, sizeof(run));
+		run.n = sizes[s];
+		run.allocator = &nb_counting_allocator;
+		run.threads = threads;
+		if (nb_keys(&run) != 0) {
+			fprintf(stderr, "nm_bench: out of memory for n=%u\n", run.n);
+			return EXIT_FAILURE;
+		}
+		for (t = 0; nb_tables[t] != NULL; t++) {
+			for (bench = nb_tables[t]; bench->name != NULL; bench++) {
+				if (filter != NULL && strstr(bench->name, filter) == NULL) {
+					continue;
+				}
+				for (r = 0, b = 0; r < reps; r++) {
+					run.ops = 0;
+					bench->fn(&run);
+					if (run.ops > 0 && (b == 0 || run.ns < best.ns)) {
+						best = run;
+						b = 1;
+					}
+				}
+				if (b == 0) {
+					continue;
+				}
+				if (json) {
+					printf("%s\n    {\"name\": \"%s\", \"n\": %u, \"ops\": %lu, "
+					       "\"ns_per_op\": %.3f, \"allocs_per_op\": ",
+					       sep, bench->name, run.n, best.ops, best.ns / best.ops);
+					if (bench->flags & NB_ALLOCS) {
+						printf("%.4f}", (double) best.allocs / best.ops);
+					} else {
+						printf("null}");
+					}
+					sep = ",";
+				} else {
+					printf("%-40s %10u %12.2f ", bench->name, run.n,
+					       best.ns / best.ops);
+					if (bench->flags & NB_ALLOCS) {
+						printf("%12.4f\n", (double) best.allocs / best.ops);
+					} else {
+						printf("%12s\n", "-");
+					}
+				}
+				fflush(stdout);
+			}
+		}
+		free(run.keys);
+		free(run.sorted);
+	}
+	if (json) {
+		printf("\n  ]\n}\n");
+	}
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,68 @@
+#ifndef __NM__BENCH__H__
+#define __NM__BENCH__H__
+#include <stdint.h>
+#include "nmaux.h"
+
+/* Micro-benchmark harness.
+ *
+ * A benchmark is a function timing one operation on a container of
+ * 'run->n' elements: it builds what it needs, brackets the measured
+ * loop with 'nb_start' / 'nb_stop' and tears everything down. The
+ * harness calls it several times per size and keeps the fastest run.
+ *
+ * Allocations are counted through 'run->allocator' (a counting
+ * 'nm_allocator' on top of malloc), so only benchmarks building their
+ * containers with the '_alloc_with' constructors report them
+ * (NB_ALLOCS); for the others allocations/op is unknown. */
+
+/* Cap on the operations of benchmarks whose single operation is
+ * O(n) (list indexing, vector front insertion, ...). */
+#define NB_SLOW_OPS 1000
+
+/* 'nb_bench' flags. */
+#define NB_ALLOCS 0x1
+
+typedef struct nb_run_s {
+	/* Set up by the harness. */
+	unsigned int n;
+	void **keys;
+	void **sorted;
+	const nm_allocator *allocator;
+	unsigned int threads;
+	/* Filled by 'nb_start' / 'nb_stop'. */
+	double start;
+	unsigned long allocs_start;
+	double ns;
+	unsigned long ops;
+	unsigned long allocs;
+} nb_run;
+
+typedef struct nb_bench_s {
+	const char *name;
+	void (*fn)(nb_run *run);
+	unsigned int flags;
+} nb_bench;
+
+/* Benchmark tables, terminated by a NULL 'name'. */
+extern const nb_bench nb_list_benches[];
+extern const nb_bench nb_vect_benches[];
+extern const nb_bench nb_tree_benches[];
+extern const nb_bench nb_queue_benches[];
+extern const nb_bench nb_misc_benches[];
+
+/* Keeps results alive so the compiler can't drop the measured code. */
+extern volatile uintptr_t nb_sink;
+
+void nb_start(nb_run *run);
+void nb_stop(nb_run *run, unsigned long ops);
+unsigned int nb_slow_ops(const nb_run *run);
+
+/* Keys are the distinct non-NULL pointer values 1..n. */
+#define NB_KEY(k) ((void*) (uintptr_t) (k))
+#define NB_VAL(p) ((uintptr_t) (p))
+
+void nb_nop(void *data);
+int nb_cmp(const void *e1, const void *e2);
+int nb_qsort_cmp(const void *e1, const void *e2);
+
+#endif
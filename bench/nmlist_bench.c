@@ -0,0 +1,258 @@
+#include <stdlib.h>
+#include "nmlist.h"
+#include "nm_bench.h"
+
+/* Builds a list holding 'run->keys', untimed. */
+static nmlist *nb_list_fill(nb_run *run)
+{
+	nmlist *list;
+	unsigned int i;
+	if ((list = nmlist_alloc_with(nb_nop, run->allocator)) == NULL) {
+		return NULL;
+	}
+	for (i = 0; i < run->n; i++) {
+		if (nmlist_insert_next(list, NULL, run->keys[i]) != 0) {
+			nmlist_free(list);
+			return NULL;
+		}
+	}
+	return list;
+}
+
+static void nb_list_alloc_free(nb_run *run)
+{
+	unsigned int i;
+	nb_start(run);
+	for (i = 0; i < run->n; i++) {
+		nmlist_free(nmlist_alloc_with(nb_nop, run->allocator));
+	}
+	nb_stop(run, run->n);
+}
+
+static void nb_list_insert_head(nb_run *run)
+{
+	nmlist *list;
+	unsigned int i;
+	if ((list = nmlist_alloc_with(nb_nop, run->allocator)) == NULL) {
+		return;
+	}
+	nb_start(run);
+	for (i = 0; i < run->n; i++) {
+		nmlist_insert_next(list, NULL, run->keys[i]);
+	}
+	nb_stop(run, run->n);
+	nmlist_free(list);
+}
+
+static void nb_list_insert_tail(nb_run *run)
+{
+	nmlist *list;
+	unsigned int i;
+	if ((list = nmlist_alloc_with(nb_nop, run->allocator)) == NULL) {
+		return;
+	}
+	nb_start(run);
+	for (i = 0; i < run->n; i++) {
+		nmlist_insert_next(list, nmlist_tail(list), run->keys[i]);
+	}
+	nb_stop(run, run->n);
+	nmlist_free(list);
+}
+
+static void nb_list_insert_index(nb_run *run)
+{
+	nmlist *list;
+	unsigned int i, ops = nb_slow_ops(run);
+	if ((list = nb_list_fill(run)) == NULL) {
+		return;
+	}
+	nb_start(run);
+	for (i = 0; i < ops; i++) {
+		nmlist_insert_index(list, nmlist_size(list) / 2, run->keys[i]);
+	}
+	nb_stop(run, ops);
+	nmlist_free(list);
+}
+
+static void nb_list_remove_head(nb_run *run)
+{
+	nmlist *list;
+	unsigned int i;
+	if ((list = nb_list_fill(run)) == NULL) {
+		return;
+	}
+	nb_start(run);
+	for (i = 0; i < run->n; i++) {
+		nb_sink += NB_VAL(nmlist_remove_next(list, NULL));
+	}
+	nb_stop(run, run->n);
+	nmlist_free(list);
+}
+
+static void nb_list_purge_head(nb_run *run)
+{
+	nmlist *list;
+	unsigned int i;
+	if ((list = nb_list_fill(run)) == NULL) {
+		return;
+	}
+	nb_start(run);
+	for (i = 0; i < run->n; i++) {
+		nmlist_purge_next(list, NULL);
+	}
+	nb_stop(run, run->n);
+	nmlist_free(list);
+}
+
+static void nb_list_remove_index(nb_run *run)
+{
+	nmlist *list;
+	unsigned int i, ops = nb_slow_ops(run);
+	if ((list = nb_list_fill(run)) == NULL) {
+		return;
+	}
+	nb_start(run);
+	for (i = 0; i < ops; i++) {
+		nb_sink += NB_VAL(nmlist_remove_index(list, nmlist_size(list) / 2));
+	}
+	nb_stop(run, ops);
+	nmlist_free(list);
+}
+
+static void nb_list_purge_index(nb_run *run)
+{
+	nmlist *list;
+	unsigned int i, ops = nb_slow_ops(run);
+	if ((list = nb_list_fill(run)) == NULL) {
+		return;
+	}
+	nb_start(run);
+	for (i = 0; i < ops; i++) {
+		nmlist_purge_index(list, nmlist_size(list) / 2);
+	}
+	nb_stop(run, ops);
+	nmlist_free(list);
+}
+
+static void nb_list_get_index(nb_run *run)
+{
+	nmlist *list;
+	unsigned int i, ops = nb_slow_ops(run);
+	if ((list = nb_list_fill(run)) == NULL) {
+		return;
+	}
+	nb_start(run);
+	for (i = 0; i < ops; i++) {
+		nb_sink += NB_VAL(nmlist_get_index(list, NB_VAL(run->keys[i]) - 1));
+	}
+	nb_stop(run, ops);
+	nmlist_free(list);
+}
+
+static void nb_list_set_index(nb_run *run)
+{
+	nmlist *list;
+	unsigned int i, ops = nb_slow_ops(run);
+	if ((list = nb_list_fill(run)) == NULL) {
+		return;
+	}
+	nb_start(run);
+	for (i = 0; i < ops; i++) {
+		nmlist_set_index(list, NB_VAL(run->keys[i]) - 1, run->keys[i]);
+	}
+	nb_stop(run, ops);
+	nmlist_free(list);
+}
+
+static void nb_list_iterate(nb_run *run)
+{
+	nmlist *list;
+	nmlist_element *element;
+	uintptr_t sum = 0;
+	if ((list = nb_list_fill(run)) == NULL) {
+		return;
+	}
+	nb_start(run);
+	for (element = nmlist_head(list); element != NULL; element = nmlist_next(element)) {
+		sum += NB_VAL(nmlist_get_data(element));
+	}
+	nb_stop(run, run->n);
+	nb_sink += sum;
+	nmlist_free(list);
+}
+
+/* 'nmlist_index' walk followed by the O(1) accessors on the found
+ * element, one op per key. */
+static void nb_list_access(nb_run *run)
+{
+	nmlist *list;
+	nmlist_element *element;
+	unsigned int i, ops = nb_slow_ops(run);
+	if ((list = nb_list_fill(run)) == NULL) {
+		return;
+	}
+	nb_start(run);
+	for (i = 0; i < ops; i++) {
+		element = nmlist_index(list, NB_VAL(run->keys[i]) - 1);
+		nmlist_set_data(element, run->keys[i]);
+		if (nmlist_next(element) != NULL) {
+			nmlist_set_next(element, nmlist_get_next(element));
+		}
+		nmlist_set_head(list, nmlist_get_head(list));
+		nmlist_set_tail(list, nmlist_get_tail(list));
+		nb_sink += NB_VAL(nmlist_get_destructor(list) == nb_nop);
+	}
+	nb_stop(run, ops);
+	nmlist_set_destructor(list, nb_nop);
+	nmlist_free(list);
+}
+
+/* Fills the list and drains it again, one op per insertion or
+ * removal. Compares per-element malloc/free with a list pool. */
+static void nb_list_churn(nb_run *run, nmlist *list)
+{
+	unsigned int i;
+	nb_start(run);
+	for (i = 0; i < run->n; i++) {
+		nmlist_insert_next(list, NULL, run->keys[i]);
+	}
+	for (i = 0; i < run->n; i++) {
+		nmlist_purge_next(list, NULL);
+	}
+	nb_stop(run, 2ul * run->n);
+	nmlist_free(list);
+}
+
+static void nb_list_churn_malloc(nb_run *run)
+{
+	nmlist *list;
+	if ((list = nmlist_alloc_with(nb_nop, run->allocator)) != NULL) {
+		nb_list_churn(run, list);
+	}
+}
+
+static void nb_list_churn_pool(nb_run *run)
+{
+	nmlist *list;
+	if ((list = nmlist_alloc_pool(nb_nop, NULL)) != NULL) {
+		nb_list_churn(run, list);
+	}
+}
+
+const nb_bench nb_list_benches[] = {
+	{ "nmlist.alloc_free", nb_list_alloc_free, NB_ALLOCS },
+	{ "nmlist.insert_next.head", nb_list_insert_head, NB_ALLOCS },
+	{ "nmlist.insert_next.tail", nb_list_insert_tail, NB_ALLOCS },
+	{ "nmlist.insert_index.mid", nb_list_insert_index, NB_ALLOCS },
+	{ "nmlist.remove_next.head", nb_list_remove_head, NB_ALLOCS },
+	{ "nmlist.purge_next.head", nb_list_purge_head, NB_ALLOCS },
+	{ "nmlist.remove_index.mid", nb_list_remove_index, NB_ALLOCS },
+	{ "nmlist.purge_index.mid", nb_list_purge_index, NB_ALLOCS },
+	{ "nmlist.get_index", nb_list_get_index, NB_ALLOCS },
+	{ "nmlist.set_index", nb_list_set_index, NB_ALLOCS },
+	{ "nmlist.iterate", nb_list_iterate, NB_ALLOCS },
+	{ "nmlist.access", nb_list_access, NB_ALLOCS },
+	{ "nmlist.churn.malloc", nb_list_churn_malloc, NB_ALLOCS },
+	{ "nmlist.churn.pool", nb_list_churn_pool, 0 },
+	{ NULL, NULL, 0 }
+};
@@ -0,0 +1,525 @@
+#include <stdlib.h>
+#include <string.h>
+#include "nmvect.h"
+#include "nmhash.h"
+#include "nmheap.h"
+#include "nmarray.h"
+#include "nmgen.h"
+#include "nmsearch.h"
+#include "nmsort.h"
+#include "nmtpool.h"
+#include "nm_bench.h"
+
+#define NB_UCMP(a, b) (((a) > (b)) - ((a) < (b)))
+
+NMVECT_DEFINE(nb_uvect, uintptr_t, NB_UCMP)
+NMLIST_DEFINE(nb_ulist, uintptr_t, NB_UCMP)
+NMHEAP_DEFINE(nb_uheap, uintptr_t, NB_UCMP)
+
+/* The nmhash benches run at fixed load factors, given in eighths of
+ * the capacity: 2, 4, 6 and 7 (0.875, the most a table holds before
+ * growing). As the capacity is a power of two, a bench uses the
+ * biggest table whose load fits in 'run->n' keys, so it works on
+ * between n/2 and n keys (fewer for tables under 16 slots). */
+
+/* Number of slots of the table loaded to 'eighths' / 8. */
+static unsigned int nb_hash_cap(const nb_run *run, unsigned int eighths)
+{
+	unsigned int cap = 16;
+	while (cap / 4 * eighths <= run->n) {
+		cap *= 2;
+	}
+	return cap;
+}
+
+/* Number of keys in a 'cap' slots table loaded to 'eighths' / 8. */
+static unsigned int nb_hash_count(const nb_run *run, unsigned int cap,
+                                  unsigned int eighths)
+{
+	return (cap / 8 * eighths < run->n) ? cap / 8 * eighths : run->n;
+}
+
+/* An empty table of exactly 'cap' slots. */
+static nmhash *nb_hash_alloc(unsigned int cap)
+{
+	return nmhash_alloc(cap - cap / 8, nmhash_ptr, nb_nop, nb_cmp);
+}
+
+/* A 'cap' slots table holding the first 'count' keys, untimed. */
+static nmhash *nb_hash_fill(nb_run *run, unsigned int cap, unsigned int count)
+{
+	nmhash *map;
+	unsigned int i;
+	if ((map = nb_hash_alloc(cap)) == NULL) {
+		return NULL;
+	}
+	for (i = 0; i < count; i++) {
+		nmhash_insert(map, run->keys[i]);
+	}
+	return map;
+}
+
+/* Fills an empty table up to the load factor. */
+static void nb_hash_insert_lf(nb_run *run, unsigned int eighths)
+{
+	nmhash *map;
+	unsigned int i, cap = nb_hash_cap(run, eighths);
+	unsigned int count = nb_hash_count(run, cap, eighths);
+	if ((map = nb_hash_alloc(cap)) == NULL) {
+		return;
+	}
+	nb_start(run);
+	for (i = 0; i < count; i++) {
+		nmhash_insert(map, run->keys[i]);
+	}
+	nb_stop(run, count);
+	nb_sink += nmhash_capacity(map);
+	nmhash_free(map);
+}
+
+/* Lookups of present keys, or of keys past all of them, in a table
+ * loaded to the load factor. */
+static void nb_hash_find_lf(nb_run *run, unsigned int eighths, uintptr_t offset)
+{
+	nmhash *map;
+	unsigned int i, cap = nb_hash_cap(run, eighths);
+	unsigned int count = nb_hash_count(run, cap, eighths);
+	uintptr_t sum = 0;
+	if ((map = nb_hash_fill(run, cap, count)) == NULL) {
+		return;
+	}
+	nb_start(run);
+	for (i = 0; i < count; i++) {
+		sum += NB_VAL(nmhash_find(map, NB_KEY(NB_VAL(run->keys[i]) + offset)));
+	}
+	nb_stop(run, count);
+	nb_sink += sum + nmhash_size(map) + nmhash_capacity(map);
+	nmhash_free(map);
+}
+
+/* Drains a table loaded to the load factor. */
+static void nb_hash_remove_lf(nb_run *run, unsigned int eighths)
+{
+	nmhash *map;
+	unsigned int i, cap = nb_hash_cap(run, eighths);
+	unsigned int count = nb_hash_count(run, cap, eighths);
+	if ((map = nb_hash_fill(run, cap, count)) == NULL) {
+		return;
+	}
+	nb_start(run);
+	for (i = 0; i < count; i++) {
+		nb_sink += NB_VAL(nmhash_remove(map, run->keys[i]));
+	}
+	nb_stop(run, count);
+	nmhash_free(map);
+}
+
+/* The benches at 'eighths' / 8, named after the load percentage. */
+#define NB_HASH_LF(lf, eighths) \
+	static void nb_hash_insert_lf##lf(nb_run *run) \
+	{ \
+		nb_hash_insert_lf(run, eighths); \
+	} \
+	static void nb_hash_find_lf##lf(nb_run *run) \
+	{ \
+		nb_hash_find_lf(run, eighths, 0); \
+	} \
+	static void nb_hash_find_miss_lf##lf(nb_run *run) \
+	{ \
+		nb_hash_find_lf(run, eighths, run->n); \
+	} \
+	static void nb_hash_remove_lf##lf(nb_run *run) \
+	{ \
+		nb_hash_remove_lf(run, eighths); \
+	}
+
+NB_HASH_LF(25, 2)
+NB_HASH_LF(50, 4)
+NB_HASH_LF(75, 6)
+NB_HASH_LF(87, 7)
+
+/* Inserts into a table created for one element, growing as it goes. */
+static void nb_hash_insert_grow(nb_run *run)
+{
+	nmhash *map;
+	unsigned int i;
+	if ((map = nmhash_alloc(1, nmhash_ptr, nb_nop, nb_cmp)) == NULL) {
+		return;
+	}
+	nb_start(run);
+	for (i = 0; i < run->n; i++) {
+		nmhash_insert(map, run->keys[i]);
+	}
+	nb_stop(run, run->n);
+	nmhash_free(map);
+}
+
+/* Push everything, pop everything, one op per call. */
+static void nb_heap_push_pop(nb_run *run)
+{
+	nmheap *heap;
+	unsigned int i;
+	if ((heap = nmheap_alloc(16, nb_nop, nb_cmp)) == NULL) {
+		return;
+	}
+	nb_start(run);
+	for (i = 0; i < run->n; i++) {
+		nmheap_push(heap, run->keys[i]);
+	}
+	for (i = 0; i < run->n; i++) {
+		nb_sink += NB_VAL(nmheap_pop(heap));
+	}
+	nb_stop(run, 2ul * run->n);
+	nmheap_free(heap);
+}
+
+static void nb_heap_heapify(nb_run *run)
+{
+	nmvect *vect;
+	nmheap *heap;
+	unsigned int i;
+	if ((vect = nmvect_alloc(run->n, nb_nop, nb_cmp)) == NULL) {
+		return;
+	}
+	for (i = 0; i < run->n; i++) {
+		nmvect_append(vect, run->keys[i]);
+	}
+	nb_start(run);
+	heap = nmheap_heapify(vect);
+	nb_stop(run, run->n);
+	if (heap != NULL) {
+		nb_sink += NB_VAL(nmheap_peek(heap));
+		nmheap_free(heap);
+	} else {
+		nmvect_free(vect);
+	}
+}
+
+/* nmgen type specialized heap, same loop as 'nmheap.push_pop'. */
+static void nb_gen_heap_push_pop(nb_run *run)
+{
+	nb_uheap *heap;
+	unsigned int i;
+	uintptr_t data = 0;
+	if ((heap = nb_uheap_alloc(16)) == NULL) {
+		return;
+	}
+	nb_start(run);
+	for (i = 0; i < run->n; i++) {
+		nb_uheap_push(heap, NB_VAL(run->keys[i]));
+	}
+	for (i = 0; i < run->n; i++) {
+		nb_uheap_pop(heap, &data);
+		nb_sink += data;
+	}
+	nb_stop(run, 2ul * run->n);
+	nb_uheap_free(heap);
+}
+
+static void nb_gen_vect_append(nb_run *run)
+{
+	nb_uvect *vect;
+	unsigned int i;
+	if ((vect = nb_uvect_alloc(1)) == NULL) {
+		return;
+	}
+	nb_start(run);
+	for (i = 0; i < run->n; i++) {
+		nb_uvect_append(vect, NB_VAL(run->keys[i]));
+	}
+	nb_stop(run, run->n);
+	nb_uvect_free(vect);
+}
+
+/* Same searches as 'nmvect.contains'. */
+static void nb_gen_vect_contains(nb_run *run)
+{
+	nb_uvect *vect;
+	unsigned int i, ops = nb_slow_ops(run);
+	int rc = 0;
+	if ((vect = nb_uvect_alloc(run->n)) == NULL) {
+		return;
+	}
+	for (i = 0; i < run->n; i++) {
+		nb_uvect_append(vect, NB_VAL(run->keys[i]));
+	}
+	nb_start(run);
+	for (i = 0; i < ops; i++) {
+		rc += nb_uvect_contains(vect, NB_VAL(run->sorted[i]));
+	}
+	nb_stop(run, ops);
+	nb_sink += (uintptr_t) rc;
+	nb_uvect_free(vect);
+}
+
+static void nb_gen_list_churn(nb_run *run)
+{
+	nb_ulist *list;
+	unsigned int i;
+	uintptr_t data = 0;
+	if ((list = nb_ulist_alloc()) == NULL) {
+		return;
+	}
+	nb_start(run);
+	for (i = 0; i < run->n; i++) {
+		nb_ulist_insert_next(list, NULL, NB_VAL(run->keys[i]));
+	}
+	for (i = 0; i < run->n; i++) {
+		nb_ulist_remove_next(list, NULL, &data);
+		nb_sink += data;
+	}
+	nb_stop(run, 2ul * run->n);
+	nb_ulist_free(list);
+}
+
+static nmarray *nb_array_fill(nb_run *run)
+{
+	nmarray *array;
+	unsigned int i;
+	uint32_t elem;
+	if ((array = nmarray_alloc(run->n, sizeof(elem), NULL, NULL)) == NULL) {
+		return NULL;
+	}
+	for (i = 0; i < run->n; i++) {
+		elem = (uint32_t) NB_VAL(run->keys[i]);
+		nmarray_append(array, &elem);
+	}
+	return array;
+}
+
+static void nb_array_append(nb_run *run)
+{
+	nmarray *array;
+	unsigned int i;
+	uint32_t elem;
+	if ((array = nmarray_alloc(1, sizeof(elem), NULL, NULL)) == NULL) {
+		return;
+	}
+	nb_start(run);
+	for (i = 0; i < run->n; i++) {
+		elem = (uint32_t) NB_VAL(run->keys[i]);
+		nmarray_append(array, &elem);
+	}
+	nb_stop(run, run->n);
+	nmarray_free(array);
+}
+
+/* Searches for keys spread over the whole array, one op per search. */
+static void nb_array_find(nb_run *run)
+{
+	nmarray *array;
+	unsigned int i, ops = nb_slow_ops(run);
+	uint32_t elem;
+	int rc = 0;
+	if ((array = nb_array_fill(run)) == NULL) {
+		return;
+	}
+	nb_start(run);
+	for (i = 0; i < ops; i++) {
+		elem = (uint32_t) NB_VAL(run->sorted[i]);
+		rc += nmarray_find(array, &elem);
+	}
+	nb_stop(run, ops);
+	nb_sink += (uintptr_t) rc;
+	nmarray_free(array);
+}
+
+static void nb_array_find_all(nb_run *run)
+{
+	nmarray *array;
+	unsigned int i, ops = nb_slow_ops(run), count = 0;
+	uint32_t elem;
+	if ((array = nb_array_fill(run)) == NULL) {
+		return;
+	}
+	nb_start(run);
+	for (i = 0; i < ops; i++) {
+		elem = (uint32_t) NB_VAL(run->sorted[i]);
+		count += nmarray_find_all(array, &elem, NULL, 0);
+	}
+	nb_stop(run, ops);
+	nb_sink += count;
+	nmarray_free(array);
+}
+
+/* Scans for a missing key, one op per element scanned. The plain
+ * loop is the baseline of the SIMD kernels. */
+static void nb_search_scan(nb_run *run, int mode)
+{
+	uint32_t *array;
+	unsigned int i, j, reps = 1 + 1000000 / run->n;
+	uint32_t key;
+	int rc = 0;
+	if ((array = malloc(run->n * sizeof(*array))) == NULL) {
+		return;
+	}
+	for (i = 0; i < run->n; i++) {
+		array[i] = (uint32_t) NB_VAL(run->keys[i]);
+	}
+	nb_start(run);
+	for (i = 0; i < reps; i++) {
+		/* Keys are 1..n: this one is never found. */
+		key = run->n + 1 + i;
+		switch (mode) {
+		case 0:
+			rc += nmsearch_find32(array, run->n, key);
+			break;
+		case 1:
+			rc += (int) nmsearch_all32(array, run->n, key, NULL, 0);
+			break;
+		default:
+			for (j = 0; j < run->n && array[j] != key; j++)
+				;
+			rc += (j < run->n) ? (int) j : -1;
+			break;
+		}
+	}
+	nb_stop(run, (unsigned long) reps * run->n);
+	nb_sink += (uintptr_t) rc;
+	free(array);
+}
+
+static void nb_search_find32(nb_run *run)
+{
+	nb_search_scan(run, 0);
+}
+
+static void nb_search_all32(nb_run *run)
+{
+	nb_search_scan(run, 1);
+}
+
+static void nb_search_scalar(nb_run *run)
+{
+	nb_search_scan(run, 2);
+}
+
+/* Sorts a copy of 'run->keys', one op per element. */
+static void nb_sort_with(nb_run *run, int mode)
+{
+	void **array;
+	if ((array = malloc(run->n * sizeof(*array))) == NULL) {
+		return;
+	}
+	memcpy(array, run->keys, run->n * sizeof(*array));
+	nb_start(run);
+	switch (mode) {
+	case 0:
+		qsort(array, run->n, sizeof(*array), nb_qsort_cmp);
+		break;
+	case 1:
+		nmsort_intro(array, run->n, nb_cmp);
+		break;
+	case 2:
+		nmsort_stable(array, run->n, nb_cmp);
+		break;
+	default:
+		nmsort_parallel(array, run->n, nb_cmp, run->threads);
+		break;
+	}
+	nb_stop(run, run->n);
+	nb_sink += NB_VAL(array[0]);
+	free(array);
+}
+
+static void nb_sort_qsort(nb_run *run)
+{
+	nb_sort_with(run, 0);
+}
+
+static void nb_sort_intro(nb_run *run)
+{
+	nb_sort_with(run, 1);
+}
+
+static void nb_sort_stable(nb_run *run)
+{
+	nb_sort_with(run, 2);
+}
+
+static void nb_sort_parallel(nb_run *run)
+{
+	nb_sort_with(run, 3);
+}
+
+static void nb_tpool_body(void *arg, unsigned int lo, unsigned int hi,
+                          unsigned int worker)
+{
+	(void) arg;
+	(void) worker;
+	nb_sink += hi - lo;
+}
+
+static void nb_tpool_job(void *arg, unsigned int worker)
+{
+	(void) arg;
+	(void) worker;
+}
+
+/* 'nmtpool_for' over an empty body, one op per index. */
+static void nb_tpool_for(nb_run *run)
+{
+	nmtpool *pool;
+	if ((pool = nmtpool_alloc(run->threads)) == NULL) {
+		return;
+	}
+	nb_start(run);
+	nmtpool_for(pool, run->n, 0, nb_tpool_body, NULL);
+	nb_stop(run, run->n);
+	nmtpool_free(pool);
+}
+
+/* Wakes the workers for an empty job, one op per 'nmtpool_run'. */
+static void nb_tpool_run(nb_run *run)
+{
+	nmtpool *pool;
+	unsigned int i, ops = nb_slow_ops(run);
+	if ((pool = nmtpool_alloc(run->threads)) == NULL) {
+		return;
+	}
+	nb_start(run);
+	for (i = 0; i < ops; i++) {
+		nmtpool_run(pool, nb_tpool_job, NULL);
+	}
+	nb_stop(run, ops);
+	nmtpool_free(pool);
+}
+
+const nb_bench nb_misc_benches[] = {
+	{ "nmhash.insert.lf25", nb_hash_insert_lf25, 0 },
+	{ "nmhash.insert.lf50", nb_hash_insert_lf50, 0 },
+	{ "nmhash.insert.lf75", nb_hash_insert_lf75, 0 },
+	{ "nmhash.insert.lf87", nb_hash_insert_lf87, 0 },
+	{ "nmhash.insert.grow", nb_hash_insert_grow, 0 },
+	{ "nmhash.find.lf25", nb_hash_find_lf25, 0 },
+	{ "nmhash.find.lf50", nb_hash_find_lf50, 0 },
+	{ "nmhash.find.lf75", nb_hash_find_lf75, 0 },
+	{ "nmhash.find.lf87", nb_hash_find_lf87, 0 },
+	{ "nmhash.find.miss.lf25", nb_hash_find_miss_lf25, 0 },
+	{ "nmhash.find.miss.lf50", nb_hash_find_miss_lf50, 0 },
+	{ "nmhash.find.miss.lf75", nb_hash_find_miss_lf75, 0 },
+	{ "nmhash.find.miss.lf87", nb_hash_find_miss_lf87, 0 },
+	{ "nmhash.remove.lf25", nb_hash_remove_lf25, 0 },
+	{ "nmhash.remove.lf50", nb_hash_remove_lf50, 0 },
+	{ "nmhash.remove.lf75", nb_hash_remove_lf75, 0 },
+	{ "nmhash.remove.lf87", nb_hash_remove_lf87, 0 },
+	{ "nmheap.push_pop", nb_heap_push_pop, 0 },
+	{ "nmheap.heapify", nb_heap_heapify, 0 },
+	{ "nmgen.heap.push_pop", nb_gen_heap_push_pop, 0 },
+	{ "nmgen.vect.append", nb_gen_vect_append, 0 },
+	{ "nmgen.vect.contains", nb_gen_vect_contains, 0 },
+	{ "nmgen.list.churn", nb_gen_list_churn, 0 },
+	{ "nmarray.append", nb_array_append, 0 },
+	{ "nmarray.find", nb_array_find, 0 },
+	{ "nmarray.find_all", nb_array_find_all, 0 },
+	{ "nmsearch.find32", nb_search_find32, 0 },
+	{ "nmsearch.all32", nb_search_all32, 0 },
+	{ "nmsearch.scalar_loop", nb_search_scalar, 0 },
+	{ "nmsort.qsort", nb_sort_qsort, 0 },
+	{ "nmsort.intro", nb_sort_intro, 0 },
+	{ "nmsort.stable", nb_sort_stable, 0 },
+	{ "nmsort.parallel", nb_sort_parallel, 0 },
+	{ "nmtpool.for", nb_tpool_for, 0 },
+	{ "nmtpool.run", nb_tpool_run, 0 },
+	{ NULL, NULL, 0 }
+};
@@ -0,0 +1,432 @@
+#define _POSIX_C_SOURCE 200809L
+#include <stdlib.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <sched.h>
+#include "nmqueue.h"
+#include "nmstack.h"
+#include "nmmpmc.h"
+#include "nmspsc.h"
+#include "nmwsdeque.h"
+#include "nmtpool.h"
+#include "nm_bench.h"
+
+/* Fills the queue and drains it again, one op per enqueue or
+ * dequeue. */
+static void nb_queue_churn(nb_run *run, nmqueue *queue)
+{
+	unsigned int i;
+	if (queue == NULL) {
+		return;
+	}
+	nb_start(run);
+	for (i = 0; i < run->n; i++) {
+		nmqueue_enqueue(queue, run->keys[i]);
+	}
+	for (i = 0; i < run->n; i++) {
+		nb_sink += NB_VAL(nmqueue_dequeue(queue));
+	}
+	nb_stop(run, 2ul * run->n);
+	nmqueue_free(queue);
+}
+
+static void nb_queue_list(nb_run *run)
+{
+	nb_queue_churn(run, nmqueue_alloc_with(nb_nop, run->allocator));
+}
+
+static void nb_queue_pool(nb_run *run)
+{
+	nb_queue_churn(run, nmqueue_alloc_pool(nb_nop, NULL));
+}
+
+static void nb_queue_ring(nb_run *run)
+{
+	nb_queue_churn(run, nmqueue_alloc_ring_with(16, nb_nop, run->allocator));
+}
+
+/* Enqueue / peek / dequeue at a constant size of 'n'. */
+static void nb_queue_steady(nb_run *run, nmqueue *queue)
+{
+	unsigned int i;
+	if (queue == NULL) {
+		return;
+	}
+	for (i = 0; i < run->n; i++) {
+		nmqueue_enqueue(queue, run->keys[i]);
+	}
+	nb_start(run);
+	for (i = 0; i < run->n; i++) {
+		nmqueue_enqueue(queue, run->keys[i]);
+		nb_sink += NB_VAL(nmqueue_peek(queue)) + nmqueue_size(queue);
+		nmqueue_purge(queue);
+	}
+	nb_stop(run, run->n);
+	nmqueue_free(queue);
+}
+
+static void nb_queue_list_steady(nb_run *run)
+{
+	nb_queue_steady(run, nmqueue_alloc_with(nb_nop, run->allocator));
+}
+
+static void nb_queue_ring_steady(nb_run *run)
+{
+	nb_queue_steady(run, nmqueue_alloc_ring_with(16, nb_nop, run->allocator));
+}
+
+/* Fills the stack and drains it again, one op per push or pop. */
+static void nb_stack_churn(nb_run *run, nmstack *stack)
+{
+	unsigned int i;
+	if (stack == NULL) {
+		return;
+	}
+	nb_start(run);
+	for (i = 0; i < run->n; i++) {
+		nmstack_push(stack, run->keys[i]);
+	}
+	for (i = 0; i < run->n; i++) {
+		nb_sink += NB_VAL(nmstack_peek(stack)) + nmstack_size(stack);
+		if (i % 2 == 0) {
+			nb_sink += NB_VAL(nmstack_pop(stack));
+		} else {
+			nmstack_purge(stack);
+		}
+	}
+	nb_stop(run, 2ul * run->n);
+	nmstack_free(stack);
+}
+
+static void nb_stack_list(nb_run *run)
+{
+	nb_stack_churn(run, nmstack_alloc_with(nb_nop, run->allocator));
+}
+
+static void nb_stack_pool(nb_run *run)
+{
+	nb_stack_churn(run, nmstack_alloc_pool(nb_nop, NULL));
+}
+
+static void nb_stack_vect(nb_run *run)
+{
+	nb_stack_churn(run, nmstack_alloc_vect_with(16, nb_nop, run->allocator));
+}
+
+/* Single threaded enqueue / dequeue pairs, the uncontended cost. */
+static void nb_mpmc_pair(nb_run *run)
+{
+	nmmpmc *queue;
+	unsigned int i;
+	void *data;
+	if ((queue = nmmpmc_alloc(1024, nb_nop)) == NULL) {
+		return;
+	}
+	nb_start(run);
+	for (i = 0; i < run->n; i++) {
+		nmmpmc_try_enqueue(queue, run->keys[i]);
+		if (nmmpmc_try_dequeue(queue, &data) == 0) {
+			nb_sink += NB_VAL(data);
+		}
+	}
+	nb_stop(run, run->n);
+	nmmpmc_free(queue);
+}
+
+typedef struct nb_mpmc_arg_s {
+	nmmpmc *queue;
+	void **keys;
+	unsigned int count;
+} nb_mpmc_arg;
+
+static void *nb_mpmc_producer(void *arg)
+{
+	nb_mpmc_arg *a = arg;
+	unsigned int i;
+	for (i = 0; i < a->count; i++) {
+		nmmpmc_enqueue(a->queue, a->keys[i]);
+	}
+	return NULL;
+}
+
+static void *nb_mpmc_consumer(void *arg)
+{
+	nb_mpmc_arg *a = arg;
+	unsigned int i;
+	uintptr_t sum = 0;
+	for (i = 0; i < a->count; i++) {
+		sum += NB_VAL(nmmpmc_dequeue(a->queue));
+	}
+	return (void*) sum;
+}
+
+/* 'threads / 2' producers against as many consumers (at least one
+ * of each), one op per element going through the queue. */
+static void nb_mpmc_threads(nb_run *run)
+{
+	nmmpmc *queue;
+	nb_mpmc_arg *args;
+	pthread_t *tids;
+	unsigned int i, side, per, total, started = 0;
+	void *sum;
+	side = (run->threads / 2 > 0) ? run->threads / 2 : 1;
+	per = run->n / side;
+	total = per * side;
+	if (per == 0 || (queue = nmmpmc_alloc(1024, nb_nop)) == NULL) {
+		return;
+	}
+	args = malloc(2 * side * sizeof(*args));
+	tids = malloc(2 * side * sizeof(*tids));
+	for (i = 0; args != NULL && tids != NULL && i < side; i++) {
+		args[i].queue = queue;
+		args[i].keys = run->keys + i * per;
+		args[i].count = per;
+		args[side + i].queue = queue;
+		args[side + i].keys = NULL;
+		args[side + i].count = total / side + (i < total % side);
+	}
+	nb_start(run);
+	for (i = 0; args != NULL && tids != NULL && i < 2 * side; i++, started++) {
+		if (pthread_create(&tids[i], NULL, (i < side) ? nb_mpmc_producer :
+		                   nb_mpmc_consumer, &args[i]) != 0) {
+			break;
+		}
+	}
+	for (i = 0; i < started; i++) {
+		pthread_join(tids[i], &sum);
+		nb_sink += NB_VAL(sum);
+	}
+	if (started == 2 * side) {
+		nb_stop(run, total);
+	}
+	free(args);
+	free(tids);
+	nmmpmc_free(queue);
+}
+
+static void nb_spsc_pair(nb_run *run)
+{
+	nmspsc *queue;
+	unsigned int i;
+	void *data;
+	if ((queue = nmspsc_alloc(1024, nb_nop)) == NULL) {
+		return;
+	}
+	nb_start(run);
+	for (i = 0; i < run->n; i++) {
+		nmspsc_enqueue(queue, run->keys[i]);
+		if (nmspsc_dequeue(queue, &data) == 0) {
+			nb_sink += NB_VAL(data);
+		}
+	}
+	nb_stop(run, run->n);
+	nmspsc_free(queue);
+}
+
+/* Batches of 64, one op per element. */
+static void nb_spsc_batch(nb_run *run)
+{
+	nmspsc *queue;
+	unsigned int i, k, got;
+	void *batch[64];
+	if ((queue = nmspsc_alloc(1024, nb_nop)) == NULL) {
+		return;
+	}
+	nb_start(run);
+	for (i = 0; i + 64 <= run->n; i += 64) {
+		nmspsc_enqueue_batch(queue, run->keys + i, 64);
+		got = nmspsc_dequeue_batch(queue, batch, 64);
+		for (k = 0; k < got; k++) {
+			nb_sink += NB_VAL(batch[k]);
+		}
+	}
+	nb_stop(run, i);
+	nmspsc_free(queue);
+}
+
+typedef struct nb_spsc_arg_s {
+	nmspsc *queue;
+	void **keys;
+	unsigned int count;
+} nb_spsc_arg;
+
+static void *nb_spsc_producer(void *arg)
+{
+	nb_spsc_arg *a = arg;
+	unsigned int i;
+	for (i = 0; i < a->count; i++) {
+		while (nmspsc_enqueue(a->queue, a->keys[i]) != 0) {
+			sched_yield();
+		}
+	}
+	return NULL;
+}
+
+/* A producer thread against the calling thread as consumer. */
+static void nb_spsc_threads(nb_run *run)
+{
+	nb_spsc_arg arg;
+	pthread_t tid;
+	unsigned int i;
+	void *data;
+	if ((arg.queue = nmspsc_alloc(1024, nb_nop)) == NULL) {
+		return;
+	}
+	arg.keys = run->keys;
+	arg.count = run->n;
+	nb_start(run);
+	if (pthread_create(&tid, NULL, nb_spsc_producer, &arg) == 0) {
+		for (i = 0; i < run->n; i++) {
+			while (nmspsc_dequeue(arg.queue, &data) != 0) {
+				sched_yield();
+			}
+			nb_sink += NB_VAL(data);
+		}
+		pthread_join(tid, NULL);
+		nb_stop(run, run->n);
+	}
+	nmspsc_free(arg.queue);
+}
+
+/* Owner side push / pop, one op per call. */
+static void nb_wsdeque_push_pop(nb_run *run)
+{
+	nmwsdeque *deque;
+	unsigned int i;
+	void *data;
+	if ((deque = nmwsdeque_alloc(16, nb_nop)) == NULL) {
+		return;
+	}
+	nb_start(run);
+	for (i = 0; i < run->n; i++) {
+		nmwsdeque_push(deque, run->keys[i]);
+	}
+	while (nmwsdeque_pop(deque, &data) == 0) {
+		nb_sink += NB_VAL(data);
+	}
+	nb_stop(run, 2ul * run->n);
+	nmwsdeque_free(deque);
+}
+
+/* Uncontended steals, one op per element. */
+static void nb_wsdeque_steal(nb_run *run)
+{
+	nmwsdeque *deque;
+	unsigned int i;
+	void *data;
+	if ((deque = nmwsdeque_alloc(run->n, nb_nop)) == NULL) {
+		return;
+	}
+	for (i = 0; i < run->n; i++) {
+		nmwsdeque_push(deque, run->keys[i]);
+	}
+	nb_start(run);
+	while (nmwsdeque_size(deque) > 0) {
+		if (nmwsdeque_steal(deque, &data) == 0) {
+			nb_sink += NB_VAL(data);
+		}
+	}
+	nb_stop(run, run->n);
+	nmwsdeque_free(deque);
+}
+
+/* Naive fork/join fib(k): every call is a task (stored as k + 1),
+ * pushed on the deque of the worker spawning it and stolen by the
+ * idle ones. */
+typedef struct nb_fib_s {
+	nmwsdeque **deques;
+	unsigned int workers;
+	atomic_long pending;
+	atomic_ulong sum;
+} nb_fib;
+
+static void nb_fib_job(void *arg, unsigned int worker)
+{
+	nb_fib *fib = arg;
+	nmwsdeque *own = fib->deques[worker];
+	unsigned int victim = worker;
+	uintptr_t k, sum = 0;
+	void *task;
+	while (atomic_load(&fib->pending) > 0) {
+		if (nmwsdeque_pop(own, &task) != 0) {
+			victim = (victim + 1) % fib->workers;
+			if (victim == worker || nmwsdeque_steal(fib->deques[victim], &task) != 0) {
+				sched_yield();
+				continue;
+			}
+		}
+		k = NB_VAL(task) - 1;
+		if (k < 2) {
+			sum += k;
+			atomic_fetch_sub(&fib->pending, 1);
+		} else {
+			atomic_fetch_add(&fib->pending, 1);
+			nmwsdeque_push(own, NB_KEY(k));
+			nmwsdeque_push(own, NB_KEY(k - 1));
+		}
+	}
+	atomic_fetch_add(&fib->sum, sum);
+}
+
+/* fib(k) for the smallest k spawning at least 'n' tasks, one op
+ * per task. */
+static void nb_wsdeque_fib(nb_run *run)
+{
+	nb_fib fib;
+	nmtpool *pool;
+	unsigned long calls[2] = { 1, 1 }, tmp;
+	uintptr_t k = 1;
+	unsigned int i, ok = 1;
+	while (calls[1] < run->n) {
+		tmp = calls[0] + calls[1] + 1;
+		calls[0] = calls[1];
+		calls[1] = tmp;
+		k++;
+	}
+	if ((pool = nmtpool_alloc(run->threads)) == NULL) {
+		return;
+	}
+	fib.workers = nmtpool_size(pool);
+	if ((fib.deques = calloc(fib.workers, sizeof(*fib.deques))) == NULL) {
+		nmtpool_free(pool);
+		return;
+	}
+	for (i = 0; i < fib.workers; i++) {
+		ok &= (fib.deques[i] = nmwsdeque_alloc(64, nb_nop)) != NULL;
+	}
+	atomic_init(&fib.pending, 1);
+	atomic_init(&fib.sum, 0);
+	if (ok && nmwsdeque_push(fib.deques[0], NB_KEY(k + 1)) == 0) {
+		nb_start(run);
+		nmtpool_run(pool, nb_fib_job, &fib);
+		nb_stop(run, calls[1]);
+		nb_sink += atomic_load(&fib.sum);
+	}
+	for (i = 0; i < fib.workers; i++) {
+		if (fib.deques[i] != NULL) {
+			nmwsdeque_free(fib.deques[i]);
+		}
+	}
+	free(fib.deques);
+	nmtpool_free(pool);
+}
+
+const nb_bench nb_queue_benches[] = {
+	{ "nmqueue.list.churn", nb_queue_list, NB_ALLOCS },
+	{ "nmqueue.pool.churn", nb_queue_pool, 0 },
+	{ "nmqueue.ring.churn", nb_queue_ring, NB_ALLOCS },
+	{ "nmqueue.list.steady", nb_queue_list_steady, NB_ALLOCS },
+	{ "nmqueue.ring.steady", nb_queue_ring_steady, NB_ALLOCS },
+	{ "nmstack.list.churn", nb_stack_list, NB_ALLOCS },
+	{ "nmstack.pool.churn", nb_stack_pool, 0 },
+	{ "nmstack.vect.churn", nb_stack_vect, NB_ALLOCS },
+	{ "nmmpmc.pair", nb_mpmc_pair, 0 },
+	{ "nmmpmc.threads", nb_mpmc_threads, 0 },
+	{ "nmspsc.pair", nb_spsc_pair, 0 },
+	{ "nmspsc.batch", nb_spsc_batch, 0 },
+	{ "nmspsc.threads", nb_spsc_threads, 0 },
+	{ "nmwsdeque.push_pop", nb_wsdeque_push_pop, 0 },
+	{ "nmwsdeque.steal", nb_wsdeque_steal, 0 },
+	{ "nmwsdeque.fib", nb_wsdeque_fib, 0 },
+	{ NULL, NULL, 0 }
+};
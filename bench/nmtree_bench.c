@@ -0,0 +1,534 @@
+#include <stdlib.h>
+#include "nmlist.h"
+#include "nmvect.h"
+#include "nmbintree.h"
+#include "nmitree.h"
+#include "nmbtree.h"
+#include "nm_bench.h"
+
+/* Builds a tree holding 'run->keys' (inserted in shuffled order, so
+ * the unbalanced tree stays O(log n) deep on average), untimed. */
+static nmbintree *nb_bintree_fill(nb_run *run, int arena)
+{
+	nmbintree *tree;
+	unsigned int i;
+	tree = arena ? nmbintree_alloc_arena_with(nb_nop, nb_cmp, 0, run->allocator) :
+	       nmbintree_alloc_with(nb_nop, nb_cmp, run->allocator);
+	if (tree == NULL) {
+		return NULL;
+	}
+	for (i = 0; i < run->n; i++) {
+		nmbintree_insert(tree, run->keys[i]);
+	}
+	return tree;
+}
+
+static void nb_bintree_alloc_free(nb_run *run)
+{
+	unsigned int i;
+	nb_start(run);
+	for (i = 0; i < run->n; i++) {
+		nmbintree_free(nmbintree_alloc_with(nb_nop, nb_cmp, run->allocator), SOFT);
+	}
+	nb_stop(run, run->n);
+}
+
+static void nb_bintree_insert_with(nb_run *run, int arena)
+{
+	nmbintree *tree;
+	unsigned int i;
+	tree = arena ? nmbintree_alloc_arena_with(nb_nop, nb_cmp, 0, run->allocator) :
+	       nmbintree_alloc_with(nb_nop, nb_cmp, run->allocator);
+	if (tree == NULL) {
+		return;
+	}
+	nb_start(run);
+	for (i = 0; i < run->n; i++) {
+		nmbintree_insert(tree, run->keys[i]);
+	}
+	nb_stop(run, run->n);
+	nmbintree_free(tree, SOFT);
+}
+
+static void nb_bintree_insert(nb_run *run)
+{
+	nb_bintree_insert_with(run, 0);
+}
+
+static void nb_bintree_insert_arena(nb_run *run)
+{
+	nb_bintree_insert_with(run, 1);
+}
+
+static void nb_bintree_lookup(nb_run *run, int mode)
+{
+	nmbintree *tree;
+	unsigned int i;
+	uintptr_t sum = 0;
+	if ((tree = nb_bintree_fill(run, 0)) == NULL) {
+		return;
+	}
+	nb_start(run);
+	for (i = 0; i < run->n; i++) {
+		switch (mode) {
+		case 0:
+			sum += NB_VAL(nmbintree_find(tree, run->keys[i]));
+			break;
+		case 1:
+			sum += NB_VAL(nmbintree_lower_bound(tree, run->keys[i]));
+			break;
+		default:
+			sum += NB_VAL(nmbintree_upper_bound(tree, run->keys[i]));
+			break;
+		}
+	}
+	nb_stop(run, run->n);
+	nb_sink += sum;
+	nmbintree_free(tree, SOFT);
+}
+
+static void nb_bintree_find(nb_run *run)
+{
+	nb_bintree_lookup(run, 0);
+}
+
+static void nb_bintree_lower_bound(nb_run *run)
+{
+	nb_bintree_lookup(run, 1);
+}
+
+static void nb_bintree_upper_bound(nb_run *run)
+{
+	nb_bintree_lookup(run, 2);
+}
+
+static void nb_bintree_erase(nb_run *run)
+{
+	nmbintree *tree;
+	unsigned int i;
+	if ((tree = nb_bintree_fill(run, 0)) == NULL) {
+		return;
+	}
+	nb_start(run);
+	for (i = 0; i < run->n; i++) {
+		nb_sink += NB_VAL(nmbintree_erase(tree, run->sorted[i]));
+	}
+	nb_stop(run, run->n);
+	nmbintree_free(tree, SOFT);
+}
+
+/* Releases a whole tree, one op per node. */
+static void nb_bintree_free_with(nb_run *run, int arena, nm_free_mode mode)
+{
+	nmbintree *tree;
+	if ((tree = nb_bintree_fill(run, arena)) == NULL) {
+		return;
+	}
+	nb_start(run);
+	nmbintree_free(tree, mode);
+	nb_stop(run, run->n);
+}
+
+static void nb_bintree_free_soft(nb_run *run)
+{
+	nb_bintree_free_with(run, 0, SOFT);
+}
+
+static void nb_bintree_free_hard(nb_run *run)
+{
+	nb_bintree_free_with(run, 0, HARD);
+}
+
+static void nb_bintree_free_soft_arena(nb_run *run)
+{
+	nb_bintree_free_with(run, 1, SOFT);
+}
+
+/* Purges both subtrees of the root, one op per node. */
+static void nb_bintree_purge(nb_run *run)
+{
+	nmbintree *tree;
+	if ((tree = nb_bintree_fill(run, 0)) == NULL) {
+		return;
+	}
+	nb_start(run);
+	nmbintree_purge_left(tree, nmbintree_root(tree), SOFT);
+	nmbintree_purge_right(tree, nmbintree_root(tree), SOFT);
+	nb_stop(run, run->n);
+	nmbintree_free(tree, SOFT);
+}
+
+/* Grows a zig-zag path with the manual placement functions. */
+static void nb_bintree_add(nb_run *run)
+{
+	nmbintree *tree;
+	nmbintree_node *node = NULL;
+	unsigned int i;
+	if ((tree = nmbintree_alloc_with(nb_nop, nb_cmp, run->allocator)) == NULL) {
+		return;
+	}
+	nb_start(run);
+	for (i = 0; i < run->n; i++) {
+		if (i % 2 == 0) {
+			nmbintree_add_left(tree, node, run->keys[i]);
+			node = (node == NULL) ? nmbintree_root(tree) : nmbintree_left(node);
+		} else {
+			nmbintree_add_right(tree, node, run->keys[i]);
+			node = nmbintree_right(node);
+		}
+	}
+	nb_stop(run, run->n);
+	nmbintree_free(tree, SOFT);
+}
+
+/* O(1) accessors, one op per key. */
+static void nb_bintree_access(nb_run *run)
+{
+	nmbintree *tree;
+	nmbintree_node *root;
+	unsigned int i;
+	if ((tree = nb_bintree_fill(run, 0)) == NULL) {
+		return;
+	}
+	root = nmbintree_root(tree);
+	nb_start(run);
+	for (i = 0; i < run->n; i++) {
+		nmbintree_set_root(tree, nmbintree_get_root(tree));
+		nmbintree_set_data(root, nmbintree_get_data(root));
+		if (nmbintree_left(root) != NULL) {
+			nmbintree_set_left(root, nmbintree_get_left(root));
+		}
+		if (nmbintree_right(root) != NULL) {
+			nmbintree_set_right(root, nmbintree_get_right(root));
+		}
+		nb_sink += nmbintree_size(tree);
+	}
+	nb_stop(run, run->n);
+	nmbintree_free(tree, SOFT);
+}
+
+static int nb_bintree_visit(void *data, void *arg)
+{
+	*(uintptr_t*) arg += NB_VAL(data);
+	return (0);
+}
+
+/* Whole tree walks, one op per node. */
+static void nb_bintree_walk(nb_run *run, int mode)
+{
+	nmbintree *tree;
+	nmlist *list = NULL;
+	uintptr_t sum = 0;
+	if ((tree = nb_bintree_fill(run, 0)) == NULL) {
+		return;
+	}
+	if (mode < 3 && (list = nmlist_alloc(nb_nop)) == NULL) {
+		nmbintree_free(tree, SOFT);
+		return;
+	}
+	nb_start(run);
+	switch (mode) {
+	case 0:
+		nmbintree_preoder(nmbintree_root(tree), list);
+		break;
+	case 1:
+		nmbintree_inorder(nmbintree_root(tree), list);
+		break;
+	case 2:
+		nmmbintree_postorder(nmbintree_root(tree), list);
+		break;
+	case 3:
+		nmbintree_preorder_visit(nmbintree_root(tree), nb_bintree_visit, &sum);
+		break;
+	case 4:
+		nmbintree_inorder_visit(nmbintree_root(tree), nb_bintree_visit, &sum);
+		break;
+	default:
+		nmbintree_postorder_visit(nmbintree_root(tree), nb_bintree_visit, &sum);
+		break;
+	}
+	nb_stop(run, run->n);
+	nb_sink += sum;
+	if (list != NULL) {
+		nmlist_free(list);
+	}
+	nmbintree_free(tree, SOFT);
+}
+
+static void nb_bintree_preorder(nb_run *run)
+{
+	nb_bintree_walk(run, 0);
+}
+
+static void nb_bintree_inorder(nb_run *run)
+{
+	nb_bintree_walk(run, 1);
+}
+
+static void nb_bintree_postorder(nb_run *run)
+{
+	nb_bintree_walk(run, 2);
+}
+
+static void nb_bintree_preorder_visit(nb_run *run)
+{
+	nb_bintree_walk(run, 3);
+}
+
+static void nb_bintree_inorder_visit(nb_run *run)
+{
+	nb_bintree_walk(run, 4);
+}
+
+static void nb_bintree_postorder_visit(nb_run *run)
+{
+	nb_bintree_walk(run, 5);
+}
+
+/* Intrusive AVL tree node, keyed like the other trees. */
+typedef struct nb_inode_s {
+	nmitree_link link;
+	uintptr_t key;
+} nb_inode;
+
+static int nb_itree_cmp(const nmitree_link *l1, const nmitree_link *l2)
+{
+	uintptr_t k1 = NM_CONTAINER_OF(l1, nb_inode, link)->key;
+	uintptr_t k2 = NM_CONTAINER_OF(l2, nb_inode, link)->key;
+	return (k1 > k2) - (k1 < k2);
+}
+
+static nb_inode *nb_itree_fill(nb_run *run, nmitree *tree, int timed)
+{
+	nb_inode *nodes;
+	unsigned int i;
+	if ((nodes = malloc(run->n * sizeof(*nodes))) == NULL) {
+		return NULL;
+	}
+	for (i = 0; i < run->n; i++) {
+		nodes[i].key = NB_VAL(run->keys[i]);
+	}
+	nmitree_init(tree, nb_itree_cmp);
+	if (timed) {
+		nb_start(run);
+	}
+	for (i = 0; i < run->n; i++) {
+		nmitree_insert(tree, &nodes[i].link);
+	}
+	if (timed) {
+		nb_stop(run, run->n);
+	}
+	return nodes;
+}
+
+static void nb_itree_insert(nb_run *run)
+{
+	nmitree tree;
+	free(nb_itree_fill(run, &tree, 1));
+}
+
+static void nb_itree_find(nb_run *run)
+{
+	nmitree tree;
+	nb_inode *nodes, key;
+	unsigned int i;
+	uintptr_t sum = 0;
+	if ((nodes = nb_itree_fill(run, &tree, 0)) == NULL) {
+		return;
+	}
+	nb_start(run);
+	for (i = 0; i < run->n; i++) {
+		key.key = NB_VAL(run->sorted[i]);
+		sum += NB_VAL(nmitree_find(&tree, &key.link));
+	}
+	nb_stop(run, run->n);
+	nb_sink += sum;
+	free(nodes);
+}
+
+static void nb_itree_erase(nb_run *run)
+{
+	nmitree tree;
+	nb_inode *nodes, key;
+	unsigned int i;
+	if ((nodes = nb_itree_fill(run, &tree, 0)) == NULL) {
+		return;
+	}
+	nb_start(run);
+	for (i = 0; i < run->n; i++) {
+		key.key = NB_VAL(run->sorted[i]);
+		nb_sink += NB_VAL(nmitree_erase(&tree, &key.link));
+	}
+	nb_stop(run, run->n);
+	free(nodes);
+}
+
+static void nb_itree_iterate(nb_run *run)
+{
+	nmitree tree;
+	nmitree_link *link;
+	nb_inode *nodes;
+	uintptr_t sum = 0;
+	if ((nodes = nb_itree_fill(run, &tree, 0)) == NULL) {
+		return;
+	}
+	nb_start(run);
+	for (link = nmitree_first(&tree); link != NULL; link = nmitree_next(&tree, link)) {
+		sum += NM_CONTAINER_OF(link, nb_inode, link)->key;
+	}
+	nb_stop(run, run->n);
+	nb_sink += sum + nmitree_size(&tree);
+	free(nodes);
+}
+
+static nmbtree *nb_btree_fill(nb_run *run)
+{
+	nmbtree *tree;
+	unsigned int i;
+	if ((tree = nmbtree_alloc(nb_nop, nb_cmp)) == NULL) {
+		return NULL;
+	}
+	for (i = 0; i < run->n; i++) {
+		nmbtree_insert(tree, run->keys[i]);
+	}
+	return tree;
+}
+
+static void nb_btree_insert(nb_run *run)
+{
+	nmbtree *tree;
+	unsigned int i;
+	if ((tree = nmbtree_alloc(nb_nop, nb_cmp)) == NULL) {
+		return;
+	}
+	nb_start(run);
+	for (i = 0; i < run->n; i++) {
+		nmbtree_insert(tree, run->keys[i]);
+	}
+	nb_stop(run, run->n);
+	nmbtree_free(tree, SOFT);
+}
+
+/* Bulk load from a sorted vector, one op per element. */
+static void nb_btree_load(nb_run *run)
+{
+	nmbtree *tree;
+	nmvect *vect;
+	unsigned int i;
+	if ((vect = nmvect_alloc(run->n, nb_nop, nb_cmp)) == NULL) {
+		return;
+	}
+	for (i = 0; i < run->n; i++) {
+		nmvect_append(vect, run->sorted[i]);
+	}
+	if ((tree = nmbtree_alloc(nb_nop, nb_cmp)) != NULL) {
+		nb_start(run);
+		nmbtree_load(tree, vect);
+		nb_stop(run, run->n);
+		nmbtree_free(tree, SOFT);
+	}
+	nmvect_free(vect);
+}
+
+static void nb_btree_find(nb_run *run)
+{
+	nmbtree *tree;
+	unsigned int i;
+	uintptr_t sum = 0;
+	if ((tree = nb_btree_fill(run)) == NULL) {
+		return;
+	}
+	nb_start(run);
+	for (i = 0; i < run->n; i++) {
+		sum += NB_VAL(nmbtree_find(tree, run->sorted[i]));
+	}
+	nb_stop(run, run->n);
+	nb_sink += sum;
+	nmbtree_free(tree, SOFT);
+}
+
+static void nb_btree_lower_bound(nb_run *run)
+{
+	nmbtree *tree;
+	nmbtree_iter iter;
+	unsigned int i;
+	uintptr_t sum = 0;
+	if ((tree = nb_btree_fill(run)) == NULL) {
+		return;
+	}
+	nb_start(run);
+	for (i = 0; i < run->n; i++) {
+		if (nmbtree_lower_bound(tree, run->keys[i], &iter) == 0) {
+			sum += NB_VAL(nmbtree_iter_get(&iter));
+		}
+	}
+	nb_stop(run, run->n);
+	nb_sink += sum;
+	nmbtree_free(tree, SOFT);
+}
+
+static void nb_btree_remove(nb_run *run)
+{
+	nmbtree *tree;
+	unsigned int i;
+	if ((tree = nb_btree_fill(run)) == NULL) {
+		return;
+	}
+	nb_start(run);
+	for (i = 0; i < run->n; i++) {
+		nb_sink += NB_VAL(nmbtree_remove(tree, run->sorted[i]));
+	}
+	nb_stop(run, run->n);
+	nmbtree_free(tree, SOFT);
+}
+
+static void nb_btree_iterate(nb_run *run)
+{
+	nmbtree *tree;
+	nmbtree_iter iter;
+	uintptr_t sum = 0;
+	int rc;
+	if ((tree = nb_btree_fill(run)) == NULL) {
+		return;
+	}
+	nb_start(run);
+	for (rc = nmbtree_first(tree, &iter); rc == 0; rc = nmbtree_iter_next(&iter)) {
+		sum += NB_VAL(nmbtree_iter_get(&iter));
+	}
+	nb_stop(run, run->n);
+	nb_sink += sum + nmbtree_size(tree);
+	nmbtree_free(tree, SOFT);
+}
+
+const nb_bench nb_tree_benches[] = {
+	{ "nmbintree.alloc_free", nb_bintree_alloc_free, NB_ALLOCS },
+	{ "nmbintree.insert", nb_bintree_insert, NB_ALLOCS },
+	{ "nmbintree.insert.arena", nb_bintree_insert_arena, NB_ALLOCS },
+	{ "nmbintree.find", nb_bintree_find, NB_ALLOCS },
+	{ "nmbintree.lower_bound", nb_bintree_lower_bound, NB_ALLOCS },
+	{ "nmbintree.upper_bound", nb_bintree_upper_bound, NB_ALLOCS },
+	{ "nmbintree.erase", nb_bintree_erase, NB_ALLOCS },
+	{ "nmbintree.free.soft", nb_bintree_free_soft, NB_ALLOCS },
+	{ "nmbintree.free.hard", nb_bintree_free_hard, NB_ALLOCS },
+	{ "nmbintree.free.soft_arena", nb_bintree_free_soft_arena, NB_ALLOCS },
+	{ "nmbintree.purge_left_right", nb_bintree_purge, NB_ALLOCS },
+	{ "nmbintree.add_left_right", nb_bintree_add, NB_ALLOCS },
+	{ "nmbintree.access", nb_bintree_access, NB_ALLOCS },
+	{ "nmbintree.preorder", nb_bintree_preorder, 0 },
+	{ "nmbintree.inorder", nb_bintree_inorder, 0 },
+	{ "nmbintree.postorder", nb_bintree_postorder, 0 },
+	{ "nmbintree.preorder_visit", nb_bintree_preorder_visit, 0 },
+	{ "nmbintree.inorder_visit", nb_bintree_inorder_visit, 0 },
+	{ "nmbintree.postorder_visit", nb_bintree_postorder_visit, 0 },
+	{ "nmitree.insert", nb_itree_insert, 0 },
+	{ "nmitree.find", nb_itree_find, 0 },
+	{ "nmitree.erase", nb_itree_erase, 0 },
+	{ "nmitree.iterate", nb_itree_iterate, 0 },
+	{ "nmbtree.insert", nb_btree_insert, 0 },
+	{ "nmbtree.load", nb_btree_load, 0 },
+	{ "nmbtree.find", nb_btree_find, 0 },
+	{ "nmbtree.lower_bound", nb_btree_lower_bound, 0 },
+	{ "nmbtree.remove", nb_btree_remove, 0 },
+	{ "nmbtree.iterate", nb_btree_iterate, 0 },
+	{ NULL, NULL, 0 }
+};
@@ -0,0 +1,558 @@
+#include <stdlib.h>
+#include <string.h>
+#include "nmlist.h"
+#include "nmvect.h"
+#include "nmtpool.h"
+#include "nm_bench.h"
+
+/* Builds a vector holding 'keys' (run->keys or run->sorted), untimed. */
+static nmvect *nb_vect_fill(nb_run *run, void **keys)
+{
+	nmvect *vect;
+	unsigned int i;
+	if ((vect = nmvect_alloc_with(run->n, nb_nop, nb_cmp, run->allocator)) == NULL) {
+		return NULL;
+	}
+	for (i = 0; i < run->n; i++) {
+		nmvect_append(vect, keys[i]);
+	}
+	return vect;
+}
+
+static void nb_vect_alloc_free(nb_run *run)
+{
+	unsigned int i;
+	nb_start(run);
+	for (i = 0; i < run->n; i++) {
+		nmvect_free(nmvect_alloc_with(16, nb_nop, nb_cmp, run->allocator));
+	}
+	nb_stop(run, run->n);
+}
+
+static void nb_vect_append(nb_run *run)
+{
+	nmvect *vect;
+	unsigned int i;
+	if ((vect = nmvect_alloc_with(1, nb_nop, nb_cmp, run->allocator)) == NULL) {
+		return;
+	}
+	nb_start(run);
+	for (i = 0; i < run->n; i++) {
+		nmvect_append(vect, run->keys[i]);
+	}
+	nb_stop(run, run->n);
+	nmvect_free(vect);
+}
+
+static void nb_vect_append_reserved(nb_run *run)
+{
+	nmvect *vect;
+	unsigned int i;
+	if ((vect = nmvect_alloc_with(1, nb_nop, nb_cmp, run->allocator)) == NULL) {
+		return;
+	}
+	nb_start(run);
+	nmvect_reserve(vect, run->n);
+	for (i = 0; i < run->n; i++) {
+		nmvect_append(vect, run->keys[i]);
+	}
+	nb_stop(run, run->n);
+	nmvect_free(vect);
+}
+
+static void nb_vect_insert_at(nb_run *run, int mid)
+{
+	nmvect *vect;
+	unsigned int i, ops = nb_slow_ops(run);
+	if ((vect = nb_vect_fill(run, run->keys)) == NULL) {
+		return;
+	}
+	nb_start(run);
+	for (i = 0; i < ops; i++) {
+		nmvect_insert(vect, mid ? nmvect_size(vect) / 2 : 0, run->keys[i]);
+	}
+	nb_stop(run, ops);
+	nmvect_free(vect);
+}
+
+static void nb_vect_insert_front(nb_run *run)
+{
+	nb_vect_insert_at(run, 0);
+}
+
+static void nb_vect_insert_mid(nb_run *run)
+{
+	nb_vect_insert_at(run, 1);
+}
+
+static void nb_vect_remove_front(nb_run *run)
+{
+	nmvect *vect;
+	unsigned int i, ops = nb_slow_ops(run);
+	if ((vect = nb_vect_fill(run, run->keys)) == NULL) {
+		return;
+	}
+	nb_start(run);
+	for (i = 0; i < ops; i++) {
+		nb_sink += NB_VAL(nmvect_remove(vect, 0));
+	}
+	nb_stop(run, ops);
+	nmvect_free(vect);
+}
+
+static void nb_vect_remove_last(nb_run *run)
+{
+	nmvect *vect;
+	unsigned int i;
+	if ((vect = nb_vect_fill(run, run->keys)) == NULL) {
+		return;
+	}
+	nb_start(run);
+	for (i = 0; i < run->n; i++) {
+		nb_sink += NB_VAL(nmvect_remove_last(vect));
+	}
+	nb_stop(run, run->n);
+	nmvect_free(vect);
+}
+
+static void nb_vect_purge_last(nb_run *run)
+{
+	nmvect *vect;
+	unsigned int i;
+	if ((vect = nb_vect_fill(run, run->keys)) == NULL) {
+		return;
+	}
+	nb_start(run);
+	for (i = 0; i < run->n; i++) {
+		nmvect_purge(vect, nmvect_size(vect) - 1);
+	}
+	nb_stop(run, run->n);
+	nmvect_free(vect);
+}
+
+static void nb_vect_get_set(nb_run *run)
+{
+	nmvect *vect;
+	unsigned int i, index;
+	if ((vect = nb_vect_fill(run, run->sorted)) == NULL) {
+		return;
+	}
+	nb_start(run);
+	for (i = 0; i < run->n; i++) {
+		index = NB_VAL(run->keys[i]) - 1;
+		nmvect_set(vect, index, nmvect_get(vect, index));
+	}
+	nb_stop(run, run->n);
+	nmvect_free(vect);
+}
+
+/* Searches for keys spread over the whole vector, one op per search. */
+static void nb_vect_search(nb_run *run, int mode)
+{
+	nmvect *vect;
+	unsigned int i, ops = nb_slow_ops(run);
+	int rc = 0;
+	if ((vect = nb_vect_fill(run, run->keys)) == NULL) {
+		return;
+	}
+	nb_start(run);
+	for (i = 0; i < ops; i++) {
+		switch (mode) {
+		case 0:
+			rc += nmvect_contains(vect, run->sorted[i]);
+			break;
+		case 1:
+			rc += nmvect_find_ptr(vect, run->sorted[i]);
+			break;
+		default:
+			rc += nmvect_find_all(vect, run->sorted[i], NULL, 0);
+			break;
+		}
+	}
+	nb_stop(run, ops);
+	nb_sink += (uintptr_t) rc;
+	nmvect_free(vect);
+}
+
+static void nb_vect_contains(nb_run *run)
+{
+	nb_vect_search(run, 0);
+}
+
+static void nb_vect_find_ptr(nb_run *run)
+{
+	nb_vect_search(run, 1);
+}
+
+static void nb_vect_find_all(nb_run *run)
+{
+	nb_vect_search(run, 2);
+}
+
+static void nb_vect_find_all_buf(nb_run *run)
+{
+	nmvect *vect;
+	unsigned int i, ops = nb_slow_ops(run), *buf = NULL, bufcap = 0;
+	if ((vect = nb_vect_fill(run, run->keys)) == NULL) {
+		return;
+	}
+	/* Every other slot holds the same key. */
+	for (i = 0; i < run->n; i += 2) {
+		nmvect_set(vect, i, run->keys[0]);
+	}
+	nb_start(run);
+	for (i = 0; i < ops; i++) {
+		nb_sink += (uintptr_t) nmvect_find_all_buf(vect, run->keys[0], &buf, &bufcap, 0);
+	}
+	nb_stop(run, ops);
+	free(buf);
+	nmvect_free(vect);
+}
+
+/* Same as 'find_all_buf', through the list building 'nmvect_occurence'. */
+static void nb_vect_occurence(nb_run *run)
+{
+	nmvect *vect;
+	unsigned int i, ops = nb_slow_ops(run) / 10 + 1;
+	if ((vect = nb_vect_fill(run, run->keys)) == NULL) {
+		return;
+	}
+	for (i = 0; i < run->n; i += 2) {
+		nmvect_set(vect, i, run->keys[0]);
+	}
+	nb_start(run);
+	for (i = 0; i < ops; i++) {
+		nmlist_free(nmvect_occurence(vect, run->keys[0]));
+	}
+	nb_stop(run, ops);
+	nmvect_free(vect);
+}
+
+/* Sorts of 'run->keys', one op per element. */
+static void nb_vect_sort_with(nb_run *run, int mode)
+{
+	nmvect *vect;
+	if ((vect = nb_vect_fill(run, run->keys)) == NULL) {
+		return;
+	}
+	nb_start(run);
+	switch (mode) {
+	case 0:
+		nmvect_sort(vect);
+		break;
+	case 1:
+		nmvect_stable_sort(vect);
+		break;
+	default:
+		nmvect_sort_parallel(vect, run->threads);
+		break;
+	}
+	nb_stop(run, run->n);
+	nmvect_free(vect);
+}
+
+static void nb_vect_sort(nb_run *run)
+{
+	nb_vect_sort_with(run, 0);
+}
+
+static void nb_vect_stable_sort(nb_run *run)
+{
+	nb_vect_sort_with(run, 1);
+}
+
+static void nb_vect_sort_parallel(nb_run *run)
+{
+	nb_vect_sort_with(run, 2);
+}
+
+static void nb_vect_bound(nb_run *run, int mode)
+{
+	nmvect *vect;
+	unsigned int i;
+	int rc = 0;
+	if ((vect = nb_vect_fill(run, run->sorted)) == NULL) {
+		return;
+	}
+	nb_start(run);
+	for (i = 0; i < run->n; i++) {
+		switch (mode) {
+		case 0:
+			rc += nmvect_bsearch(vect, run->keys[i]);
+			break;
+		case 1:
+			rc += nmvect_lower_bound(vect, run->keys[i]);
+			break;
+		default:
+			rc += nmvect_upper_bound(vect, run->keys[i]);
+			break;
+		}
+	}
+	nb_stop(run, run->n);
+	nb_sink += (uintptr_t) rc;
+	nmvect_free(vect);
+}
+
+static void nb_vect_bsearch(nb_run *run)
+{
+	nb_vect_bound(run, 0);
+}
+
+static void nb_vect_lower_bound(nb_run *run)
+{
+	nb_vect_bound(run, 1);
+}
+
+static void nb_vect_upper_bound(nb_run *run)
+{
+	nb_vect_bound(run, 2);
+}
+
+static void nb_vect_insert_sorted(nb_run *run)
+{
+	nmvect *vect;
+	unsigned int i, ops = nb_slow_ops(run);
+	if ((vect = nb_vect_fill(run, run->sorted)) == NULL) {
+		return;
+	}
+	nb_start(run);
+	for (i = 0; i < ops; i++) {
+		nmvect_insert_sorted(vect, run->keys[i]);
+	}
+	nb_stop(run, ops);
+	nmvect_free(vect);
+}
+
+/* Inserts a 16 element vector in the middle, one op per call. */
+static void nb_vect_insert_range(nb_run *run)
+{
+	nmvect *vect, *addvect;
+	unsigned int i, ops = nb_slow_ops(run);
+	if ((vect = nb_vect_fill(run, run->keys)) == NULL) {
+		return;
+	}
+	if ((addvect = nmvect_alloc(16, nb_nop, nb_cmp)) == NULL) {
+		nmvect_free(vect);
+		return;
+	}
+	for (i = 0; i < 16; i++) {
+		nmvect_append(addvect, run->keys[i % run->n]);
+	}
+	nb_start(run);
+	for (i = 0; i < ops; i++) {
+		nmvect_insert_range(vect, nmvect_size(vect) / 2, addvect);
+	}
+	nb_stop(run, ops);
+	nmvect_free(addvect);
+	nmvect_free(vect);
+}
+
+/* Appends a whole vector to an empty one, one op per element. */
+static void nb_vect_append_range(nb_run *run)
+{
+	nmvect *vect, *appvect;
+	if ((appvect = nb_vect_fill(run, run->keys)) == NULL) {
+		return;
+	}
+	if ((vect = nmvect_alloc_with(1, nb_nop, nb_cmp, run->allocator)) == NULL) {
+		nmvect_free(appvect);
+		return;
+	}
+	nb_start(run);
+	nmvect_append_range(vect, 0, appvect);
+	nb_stop(run, run->n);
+	nmvect_free(vect);
+	nmvect_free(appvect);
+}
+
+/* Takes 16 elements out of the middle, one op per call. */
+static void nb_vect_range_out(nb_run *run, int purge)
+{
+	nmvect *vect;
+	unsigned int i, mid, ops = nb_slow_ops(run) / 16;
+	if (run->n < 32 || (vect = nb_vect_fill(run, run->keys)) == NULL) {
+		return;
+	}
+	nb_start(run);
+	for (i = 0; i < ops; i++) {
+		mid = nmvect_size(vect) / 2;
+		if (purge) {
+			nmvect_purge_range(vect, mid, mid + 16);
+		} else {
+			nmvect_free(nmvect_remove_range(vect, mid, mid + 16));
+		}
+	}
+	nb_stop(run, ops);
+	nmvect_free(vect);
+}
+
+static void nb_vect_remove_range(nb_run *run)
+{
+	nb_vect_range_out(run, 0);
+}
+
+static void nb_vect_purge_range(nb_run *run)
+{
+	nb_vect_range_out(run, 1);
+}
+
+/* Appends and removes around the point where the vector grows:
+ * without hysteresis every op re-allocates. */
+static void nb_vect_boundary(nb_run *run)
+{
+	nmvect *vect;
+	unsigned int i;
+	if ((vect = nb_vect_fill(run, run->keys)) == NULL) {
+		return;
+	}
+	nmvect_shrink_to_fit(vect);
+	nb_start(run);
+	for (i = 0; i < run->n; i++) {
+		nmvect_append(vect, run->keys[i]);
+		nmvect_remove_last(vect);
+	}
+	nb_stop(run, 2ul * run->n);
+	nmvect_free(vect);
+}
+
+/* Explicit capacity management, one op per call. */
+static void nb_vect_capacity(nb_run *run)
+{
+	nmvect *vect;
+	unsigned int i, ops = nb_slow_ops(run);
+	if ((vect = nb_vect_fill(run, run->keys)) == NULL) {
+		return;
+	}
+	nmvect_set_policy(vect, &nmvect_policy_noshrink);
+	nb_start(run);
+	for (i = 0; i < ops; i++) {
+		switch (i % 4) {
+		case 0:
+			nmvect_expand(vect);
+			break;
+		case 1:
+			nmvect_contract(vect);
+			break;
+		case 2:
+			nmvect_modcap(vect, 16);
+			break;
+		default:
+			nmvect_shrink_to_fit(vect);
+			break;
+		}
+		nb_sink += nmvect_capacity(vect);
+	}
+	nb_stop(run, ops);
+	nb_sink += NB_VAL(nmvect_get_destructor(vect) == nb_nop);
+	nb_sink += NB_VAL(nmvect_get_cmp(vect) == nb_cmp);
+	nmvect_free(vect);
+}
+
+static void nb_vect_par_each(void *data, void *arg)
+{
+	(void) data;
+	(void) arg;
+}
+
+static void *nb_vect_par_map(const void *data, void *arg)
+{
+	(void) arg;
+	return NB_KEY(NB_VAL(data) * 2);
+}
+
+static void *nb_vect_par_reduce(void *acc, void *data, void *arg)
+{
+	(void) arg;
+	return NB_KEY(NB_VAL(acc) + NB_VAL(data));
+}
+
+static void *nb_vect_par_combine(void *acc1, void *acc2, void *arg)
+{
+	(void) arg;
+	return NB_KEY(NB_VAL(acc1) + NB_VAL(acc2));
+}
+
+static void nb_vect_parallel(nb_run *run, int mode)
+{
+	nmvect *vect;
+	nmtpool *pool;
+	void *result;
+	uintptr_t acc = 0;
+	if ((vect = nb_vect_fill(run, run->keys)) == NULL) {
+		return;
+	}
+	if ((pool = nmtpool_alloc(run->threads)) == NULL) {
+		nmvect_free(vect);
+		return;
+	}
+	nb_start(run);
+	switch (mode) {
+	case 0:
+		nmvect_parallel_for_each(vect, pool, nb_vect_par_each, NULL);
+		break;
+	case 1:
+		nmvect_free(nmvect_parallel_map(vect, pool, nb_vect_par_map, NULL,
+		                                nb_nop, nb_cmp));
+		break;
+	default:
+		if (nmvect_parallel_reduce(vect, pool, nb_vect_par_reduce,
+		                           nb_vect_par_combine, NB_KEY(0), NULL,
+		                           &result) == 0) {
+			acc = NB_VAL(result);
+		}
+		break;
+	}
+	nb_stop(run, run->n);
+	nb_sink += acc;
+	nmtpool_free(pool);
+	nmvect_free(vect);
+}
+
+static void nb_vect_parallel_for_each(nb_run *run)
+{
+	nb_vect_parallel(run, 0);
+}
+
+static void nb_vect_parallel_map(nb_run *run)
+{
+	nb_vect_parallel(run, 1);
+}
+
+static void nb_vect_parallel_reduce(nb_run *run)
+{
+	nb_vect_parallel(run, 2);
+}
+
+const nb_bench nb_vect_benches[] = {
+	{ "nmvect.alloc_free", nb_vect_alloc_free, NB_ALLOCS },
+	{ "nmvect.append", nb_vect_append, NB_ALLOCS },
+	{ "nmvect.append.reserved", nb_vect_append_reserved, NB_ALLOCS },
+	{ "nmvect.insert.front", nb_vect_insert_front, NB_ALLOCS },
+	{ "nmvect.insert.mid", nb_vect_insert_mid, NB_ALLOCS },
+	{ "nmvect.remove.front", nb_vect_remove_front, NB_ALLOCS },
+	{ "nmvect.remove_last", nb_vect_remove_last, NB_ALLOCS },
+	{ "nmvect.purge.last", nb_vect_purge_last, NB_ALLOCS },
+	{ "nmvect.get_set", nb_vect_get_set, NB_ALLOCS },
+	{ "nmvect.contains", nb_vect_contains, NB_ALLOCS },
+	{ "nmvect.find_ptr", nb_vect_find_ptr, NB_ALLOCS },
+	{ "nmvect.find_all", nb_vect_find_all, NB_ALLOCS },
+	{ "nmvect.find_all_buf", nb_vect_find_all_buf, NB_ALLOCS },
+	{ "nmvect.occurence", nb_vect_occurence, 0 },
+	{ "nmvect.sort", nb_vect_sort, NB_ALLOCS },
+	{ "nmvect.stable_sort", nb_vect_stable_sort, 0 },
+	{ "nmvect.sort_parallel", nb_vect_sort_parallel, 0 },
+	{ "nmvect.bsearch", nb_vect_bsearch, NB_ALLOCS },
+	{ "nmvect.lower_bound", nb_vect_lower_bound, NB_ALLOCS },
+	{ "nmvect.upper_bound", nb_vect_upper_bound, NB_ALLOCS },
+	{ "nmvect.insert_sorted", nb_vect_insert_sorted, NB_ALLOCS },
+	{ "nmvect.insert_range.mid", nb_vect_insert_range, NB_ALLOCS },
+	{ "nmvect.append_range", nb_vect_append_range, NB_ALLOCS },
+	{ "nmvect.remove_range.mid", nb_vect_remove_range, NB_ALLOCS },
+	{ "nmvect.purge_range.mid", nb_vect_purge_range, NB_ALLOCS },
+	{ "nmvect.append_remove.boundary", nb_vect_boundary, NB_ALLOCS },
+	{ "nmvect.capacity", nb_vect_capacity, NB_ALLOCS },
+	{ "nmvect.parallel_for_each", nb_vect_parallel_for_each, 0 },
+	{ "nmvect.parallel_map", nb_vect_parallel_map, NB_ALLOCS },
+	{ "nmvect.parallel_reduce", nb_vect_parallel_reduce, 0 },
+	{ NULL, NULL, 0 }
+};
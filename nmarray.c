@@ -0,0 +1,451 @@
+#include <limits.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include "nmsearch.h"
+#include "nmarray.h"
+
+/* Vector storing its elements by value: 'data' is a contiguous block
+ * of 'capacity * elem_size' bytes, the 'index'th element starting at
+ * 'data + index * elem_size'. */
+struct nmarray_s {
+	void (*destructor)(void *elem);
+	int (*cmp)(const void *e1, const void *e2);
+	size_t elem_size;
+	unsigned int capacity;
+	unsigned int size;
+	unsigned char *data;
+};
+
+/**
+ * Allocates memory for a new empty array of 'elem_size' bytes
+ * elements.
+ *
+ * Unlike 'nmvect' the elements are copied into the array, so
+ * numeric or small structure elements need no allocation of their
+ * own, and are read sequentially.
+ *
+ * INPUT:
+ * 'icap'			Initial capacity.
+ * 'elem_size'		Size of an element (eg. 'sizeof(int)').
+ * 'destructor'		Called with a pointer to every element being
+ * 					purged (may be NULL if elements own no memory).
+ * 'cmp'			Function needed to compare two elements, called
+ * 					with pointers to the elements. If NULL the
+ * 					elements are compared bytewise (only
+ * 					meaningful for types without padding).
+ *
+ * RETURNS:
+ * NULL				If memory allocation fails or 'elem_size' is 0.
+ * A new array.
+ **/
+nmarray *nmarray_alloc(unsigned int icap, size_t elem_size,
+                       void (*destructor)(void *elem),
+                       int (*cmp)(const void *e1, const void *e2))
+{
+	nmarray *array = NULL;
+	if (elem_size == 0) {
+		return NULL;
+	}
+	if ((array = calloc(1, sizeof(*array))) == NULL) {
+		return NULL;
+	}
+	if (icap == 0) {
+		icap = 1;
+	}
+	if ((array->data = malloc(icap * elem_size)) == NULL) {
+		free(array);
+		return NULL;
+	}
+	array->destructor = destructor;
+	array->cmp = cmp;
+	array->elem_size = elem_size;
+	array->capacity = icap;
+	array->size = 0;
+	return array;
+}
+
+/**
+ * De-allocates memory for 'array', calling the destructor (if any)
+ * for every element.
+ *
+ * RETURNS:
+ * 0				If memory de-allocation was succesful.
+ * -1				If array is NULL.
+ **/
+int nmarray_free(nmarray *array)
+{
+	unsigned int i;
+	if (array == NULL) {
+		return (-1);
+	}
+	if (array->destructor != NULL) {
+		for (i = 0; i < array->size; i++) {
+			array->destructor(array->data + i * array->elem_size);
+		}
+	}
+	free(array->data);
+	free(array);
+	return (0);
+}
+
+/**
+ * THIS FUNCTION IS PRIVATE.
+ * Re-allocates the element block to hold exactly 'cap' elements.
+ **/
+static int nmarray_setcap(nmarray *array, unsigned int cap)
+{
+	unsigned char *tmp_data;
+	if (cap == 0) {
+		cap = 1;
+	}
+	if (cap == array->capacity) {
+		return (0);
+	}
+	if ((tmp_data = realloc(array->data, cap * array->elem_size)) == NULL) {
+		return (-1);
+	}
+	array->data = tmp_data;
+	array->capacity = cap;
+	return (0);
+}
+
+/**
+ * THIS FUNCTION IS PRIVATE.
+ * Makes room for one more element, growing the capacity by half.
+ *
+ * '*elem' may point inside the element block (eg. it was returned
+ * by 'nmarray_get'), in which case it is rebased after the block
+ * was re-allocated.
+ *
+ * RETURNS:
+ * 0				If there is room for one more element.
+ * -1				If the capacity can't grow any more or memory
+ * 					re-allocation failed.
+ **/
+static int nmarray_grow(nmarray *array, const void **elem)
+{
+	unsigned int cap;
+	uintptr_t offset, begin = (uintptr_t) array->data;
+	int inside;
+	if (array->size < array->capacity) {
+		return (0);
+	}
+	if (array->capacity == ~0u) {
+		return (-1);
+	}
+	cap = array->capacity / 2 + 1;
+	cap = (array->capacity > ~0u - cap) ? ~0u : array->capacity + cap;
+	offset = (uintptr_t) *elem - begin;
+	inside = (uintptr_t) *elem >= begin &&
+	         offset < (uintptr_t) array->size * array->elem_size;
+	if (nmarray_setcap(array, cap) != 0) {
+		return (-1);
+	}
+	if (inside) {
+		*elem = array->data + offset;
+	}
+	return (0);
+}
+
+/**
+ * Makes sure 'array' can hold at least 'cap' elements without
+ * re-allocating memory.
+ *
+ * RETURNS:
+ * 0				If the capacity is big enough.
+ * -1				If array is NULL or memory re-allocation failed.
+ **/
+int nmarray_reserve(nmarray *array, unsigned int cap)
+{
+	if (array == NULL) {
+		return (-1);
+	}
+	return (cap <= array->capacity) ? 0 : nmarray_setcap(array, cap);
+}
+
+/**
+ * Reduces 'array' capacity to its size.
+ *
+ * RETURNS:
+ * 0				If the capacity was reduced.
+ * -1				If array is NULL or memory re-allocation failed.
+ **/
+int nmarray_shrink_to_fit(nmarray *array)
+{
+	if (array == NULL) {
+		return (-1);
+	}
+	return nmarray_setcap(array, array->size);
+}
+
+/**
+ * Copies the element pointed by 'elem' at the 'index'th position,
+ * shifting the following elements.
+ *
+ * RETURNS:
+ * 0				If insertion was succesful.
+ * -1				If array or elem are NULL, index is out of bounds
+ * 					or memory re-allocation failed.
+ **/
+int nmarray_insert(nmarray *array, unsigned int index, const void *elem)
+{
+	unsigned char *slot, *end;
+	const unsigned char *src;
+	if (array == NULL || elem == NULL || index > array->size) {
+		return (-1);
+	}
+	if (nmarray_grow(array, &elem) != 0) {
+		return (-1);
+	}
+	slot = array->data + index * array->elem_size;
+	end = array->data + array->size * array->elem_size;
+	src = elem;
+	memmove(slot + array->elem_size, slot,
+	        (array->size - index) * array->elem_size);
+	/* An element of the array at or after 'slot' was just shifted. */
+	if ((uintptr_t) src >= (uintptr_t) slot && (uintptr_t) src < (uintptr_t) end) {
+		src += array->elem_size;
+	}
+	memcpy(slot, src, array->elem_size);
+	array->size++;
+	return (0);
+}
+
+/**
+ * Copies the element pointed by 'elem' at the end of the array.
+ *
+ * RETURNS:
+ * 0				If insertion was succesful.
+ * -1				If array or elem are NULL or memory
+ * 					re-allocation failed.
+ **/
+int nmarray_append(nmarray *array, const void *elem)
+{
+	if (array == NULL || elem == NULL) {
+		return (-1);
+	}
+	if (nmarray_grow(array, &elem) != 0) {
+		return (-1);
+	}
+	memcpy(array->data + array->size * array->elem_size, elem, array->elem_size);
+	array->size++;
+	return (0);
+}
+
+/**
+ * Removes the 'index'th element, shifting the following ones.
+ *
+ * INPUT:
+ * 'array'			The array.
+ * 'index'			Index to be removed.
+ * 'elem'			If not NULL, the removed element is copied here.
+ *
+ * RETURNS:
+ * 0				If the element was removed.
+ * -1				If array is NULL or index is out of bounds.
+ **/
+int nmarray_remove(nmarray *array, unsigned int index, void *elem)
+{
+	unsigned char *slot;
+	if (array == NULL || index >= array->size) {
+		return (-1);
+	}
+	slot = array->data + index * array->elem_size;
+	if (elem != NULL) {
+		memcpy(elem, slot, array->elem_size);
+	}
+	array->size--;
+	memmove(slot, slot + array->elem_size,
+	        (array->size - index) * array->elem_size);
+	return (0);
+}
+
+/**
+ * Removes the 'index'th element, calling the destructor (if any)
+ * on it first.
+ *
+ * RETURNS:
+ * 0				If the element was purged.
+ * -1				If array is NULL or index is out of bounds.
+ **/
+int nmarray_purge(nmarray *array, unsigned int index)
+{
+	if (array == NULL || index >= array->size) {
+		return (-1);
+	}
+	if (array->destructor != NULL) {
+		array->destructor(array->data + index * array->elem_size);
+	}
+	return nmarray_remove(array, index, NULL);
+}
+
+/**
+ * Returns the position of the first element equal to '*elem'.
+ *
+ * Arrays compared bytewise ('cmp' == NULL) of 4 or 8 bytes
+ * elements are searched with the 'nmsearch' kernels, comparing
+ * 8-16 keys per instruction where the CPU supports it.
+ *
+ * RETURNS:
+ * The index of the first matching element.
+ * -1				If not found, array or elem are NULL or the
+ * 					array holds more than INT_MAX elements.
+ **/
+int nmarray_find(nmarray *array, const void *elem)
+{
+	unsigned int i;
+	const unsigned char *slot;
+	uint32_t key32;
+	uint64_t key64;
+	if (array == NULL || elem == NULL || array->size > INT_MAX) {
+		return (-1);
+	}
+	if (array->cmp == NULL && array->elem_size == sizeof(key32)) {
+		memcpy(&key32, elem, sizeof(key32));
+		return nmsearch_find32((const uint32_t*) array->data, array->size, key32);
+	}
+	if (array->cmp == NULL && array->elem_size == sizeof(key64)) {
+		memcpy(&key64, elem, sizeof(key64));
+		return nmsearch_find64((const uint64_t*) array->data, array->size, key64);
+	}
+	for (i = 0, slot = array->data; i < array->size; i++, slot += array->elem_size) {
+		if ((array->cmp != NULL) ? array->cmp(slot, elem) == 0 :
+		        memcmp(slot, elem, array->elem_size) == 0) {
+			return (int) i;
+		}
+	}
+	return (-1);
+}
+
+/**
+ * Writes the positions of the elements equal to '*elem' to
+ * 'indices', in increasing order. Uses the same kernels as
+ * 'nmarray_find'.
+ *
+ * INPUT:
+ * 'array'			The array to search.
+ * 'elem'			Pointer to the element to look for.
+ * 'indices'		Output buffer, NULL to only count the matches.
+ * 'limit'			Capacity of 'indices': the search stops after
+ * 					'limit' matches (ignored if 'indices' is NULL).
+ *
+ * RETURNS:
+ * The number of matches (written to 'indices', if not NULL).
+ * 0				If array or elem are NULL.
+ **/
+unsigned int nmarray_find_all(nmarray *array, const void *elem,
+                              unsigned int *indices, unsigned int limit)
+{
+	unsigned int i, count = 0;
+	const unsigned char *slot;
+	uint32_t key32;
+	uint64_t key64;
+	if (array == NULL || elem == NULL) {
+		return 0;
+	}
+	if (array->cmp == NULL && array->elem_size == sizeof(key32)) {
+		memcpy(&key32, elem, sizeof(key32));
+		return nmsearch_all32((const uint32_t*) array->data, array->size, key32,
+		                      indices, limit);
+	}
+	if (array->cmp == NULL && array->elem_size == sizeof(key64)) {
+		memcpy(&key64, elem, sizeof(key64));
+		return nmsearch_all64((const uint64_t*) array->data, array->size, key64,
+		                      indices, limit);
+	}
+	for (i = 0, slot = array->data; i < array->size; i++, slot += array->elem_size) {
+		if (indices != NULL && count == limit) {
+			break;
+		}
+		if ((array->cmp != NULL) ? array->cmp(slot, elem) == 0 :
+		        memcmp(slot, elem, array->elem_size) == 0) {
+			if (indices != NULL) {
+				indices[count] = i;
+			}
+			count++;
+		}
+	}
+	return count;
+}
+
+/**
+ * Test if an element equal to '*elem' is contained by the array.
+ *
+ * RETURNS:
+ * 1				If the array contains the element.
+ * 0				If it doesn't.
+ * -1				If array or elem are NULL.
+ **/
+int nmarray_contains(nmarray *array, const void *elem)
+{
+	if (array == NULL || elem == NULL) {
+		return (-1);
+	}
+	return (nmarray_find(array, elem) >= 0) ? (1) : (0);
+}
+
+/**
+ * Returns a pointer to the 'index'th element, valid until the
+ * array is modified.
+ *
+ * RETURNS:
+ * NULL				If array is NULL or index is out of bounds.
+ * A pointer to the element.
+ **/
+void *nmarray_get(nmarray *array, unsigned int index)
+{
+	if (array == NULL || index >= array->size) {
+		return NULL;
+	}
+	return array->data + index * array->elem_size;
+}
+
+/**
+ * Overwrites the 'index'th element with a copy of '*elem'.
+ *
+ * RETURNS:
+ * 0				If the element was updated.
+ * -1				If array or elem are NULL, or index is out
+ * 					of bounds.
+ **/
+int nmarray_set(nmarray *array, unsigned int index, const void *elem)
+{
+	if (array == NULL || elem == NULL || index >= array->size) {
+		return (-1);
+	}
+	memmove(array->data + index * array->elem_size, elem, array->elem_size);
+	return (0);
+}
+
+/**
+ * Returns the element block, valid until the array is modified.
+ **/
+void *nmarray_data(nmarray *array)
+{
+	return (array == NULL) ? NULL : array->data;
+}
+
+/**
+ * Returns array size.
+ **/
+unsigned int nmarray_size(nmarray *array)
+{
+	return (array == NULL) ? 0 : array->size;
+}
+
+/**
+ * Returns array capacity.
+ **/
+unsigned int nmarray_capacity(nmarray *array)
+{
+	return (array == NULL) ? 0 : array->capacity;
+}
+
+/**
+ * Returns the size of an element.
+ **/
+size_t nmarray_elem_size(nmarray *array)
+{
+	return (array == NULL) ? 0 : array->elem_size;
+}
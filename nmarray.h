@@ -0,0 +1,33 @@
+#ifndef __NM__ARRAY__H__
+#define __NM__ARRAY__H__
+#include <stddef.h>
+#include "nmaux.h"
+
+typedef struct nmarray_s nmarray;
+
+/* Direct access to the 'index'th element of an array of 'type'
+ * (no bounds checking). */
+#define NMARRAY_AT(array, type, index) (((type*) nmarray_data(array))[index])
+
+nmarray *nmarray_alloc(unsigned int icap, size_t elem_size,
+                       void (*destructor)(void *elem),
+                       int (*cmp)(const void *e1, const void *e2));
+int nmarray_free(nmarray *array);
+int nmarray_reserve(nmarray *array, unsigned int cap);
+int nmarray_shrink_to_fit(nmarray *array);
+int nmarray_insert(nmarray *array, unsigned int index, const void *elem);
+int nmarray_append(nmarray *array, const void *elem);
+int nmarray_remove(nmarray *array, unsigned int index, void *elem);
+int nmarray_purge(nmarray *array, unsigned int index);
+int nmarray_contains(nmarray *array, const void *elem);
+int nmarray_find(nmarray *array, const void *elem);
+unsigned int nmarray_find_all(nmarray *array, const void *elem,
+                              unsigned int *indices, unsigned int limit);
+void *nmarray_get(nmarray *array, unsigned int index);
+int nmarray_set(nmarray *array, unsigned int index, const void *elem);
+void *nmarray_data(nmarray *array);
+unsigned int nmarray_size(nmarray *array);
+unsigned int nmarray_capacity(nmarray *array);
+size_t nmarray_elem_size(nmarray *array);
+
+#endif
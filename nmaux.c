@@ -8,4 +8,49 @@
 void nmaux_primitive_destructor(void *data)
 {
 	free(data);
-}
\ No newline at end of file
+}
+
+/**
+ * Tells if the library was built with the instrumentation
+ * counters (NM_STATS).
+ *
+ * RETURNS:
+ * 1				If the counters are recorded.
+ * 0				If they are compiled out.
+ **/
+int nm_stats_enabled(void)
+{
+#ifdef NM_STATS
+	return (1);
+#else
+	return (0);
+#endif
+}
+
+/**
+ * Prints the counters of an instance on one line:
+ *
+ *	name: allocs=12 reallocs=3 shifted=0 cmps=40 traversed=7
+ *
+ * INPUT:
+ * 'stream'			Where to print (e.g. stderr).
+ * 'name'			Label of the instance (NULL for none).
+ * 'stats'			The counters, see the '_stats' functions.
+ *
+ * RETURNS:
+ * 0				If the counters were printed.
+ * -1				If 'stream' or 'stats' is NULL, or printing failed.
+ **/
+int nm_stats_dump(FILE *stream, const char *name, const nm_stats *stats)
+{
+	if (stream == NULL || stats == NULL) {
+		return (-1);
+	}
+	if (fprintf(stream, "%s%sallocs=%lu reallocs=%lu shifted=%lu cmps=%lu "
+	            "traversed=%lu\n", (name != NULL) ? name : "",
+	            (name != NULL) ? ": " : "", stats->allocs, stats->reallocs,
+	            stats->shifted, stats->cmps, stats->traversed) < 0) {
+		return (-1);
+	}
+	return (0);
+}
@@ -1,7 +1,93 @@
 #ifndef __NM__COM__H__
 #define __NM__COM__H__
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
 
 void nmaux_primitive_destructor(void *data);
 typedef enum nm_free_mode_e { SOFT, HARD } nm_free_mode;
 
+/* Size of a cache line, used to pad data shared between threads
+ * so unrelated fields don't end up on the same line. */
+#ifndef NM_CACHE_LINE
+#define NM_CACHE_LINE 64
+#endif
+
+/* Memory allocator used by a container instance (see the
+ * '_alloc_with' constructors). Every function gets 'ctx' as its
+ * first argument, so an allocator can route memory to an arena,
+ * a per-thread cache, a hugepage pool, etc. The allocator must
+ * outlive the containers using it.
+ *
+ * A NULL allocator stands for the C library; the 'nm_*' helpers
+ * below then call 'malloc' & co directly. */
+typedef struct nm_allocator_s {
+	void *(*malloc_fn)(void *ctx, size_t size);
+	void *(*calloc_fn)(void *ctx, size_t nmemb, size_t size);
+	void *(*realloc_fn)(void *ctx, void *ptr, size_t size);
+	void (*free_fn)(void *ctx, void *ptr);
+	void *ctx;
+} nm_allocator;
+
+static inline void *nm_malloc(const nm_allocator *allocator, size_t size)
+{
+	return (allocator == NULL) ? malloc(size) :
+	       allocator->malloc_fn(allocator->ctx, size);
+}
+
+static inline void *nm_calloc(const nm_allocator *allocator, size_t nmemb, size_t size)
+{
+	return (allocator == NULL) ? calloc(nmemb, size) :
+	       allocator->calloc_fn(allocator->ctx, nmemb, size);
+}
+
+static inline void *nm_realloc(const nm_allocator *allocator, void *ptr, size_t size)
+{
+	return (allocator == NULL) ? realloc(ptr, size) :
+	       allocator->realloc_fn(allocator->ctx, ptr, size);
+}
+
+static inline void nm_free(const nm_allocator *allocator, void *ptr)
+{
+	if (allocator == NULL) {
+		free(ptr);
+	} else {
+		allocator->free_fn(allocator->ctx, ptr);
+	}
+}
+
+/* Returns a pointer to the 'type' structure whose 'member' field
+ * is pointed by 'ptr'. Used with the intrusive containers to get
+ * from a link back to the structure embedding it. */
+#define NM_CONTAINER_OF(ptr, type, member) \
+	((type*) ((char*) (ptr) - offsetof(type, member)))
+
+/* Instrumentation counters of a container instance. They are only
+ * recorded when the library is built with NM_STATS defined (cmake
+ * -DNM_STATS=ON); otherwise the 'NM_STAT_*' macros expand to nothing
+ * and the '_stats' query functions return -1.
+ *
+ * 'allocs'		Memory blocks requested for elements, nodes or arrays.
+ * 'reallocs'	Re-allocations of an array (growing or shrinking).
+ * 'shifted'	Elements moved to open or close a gap.
+ * 'cmps'		Calls to the 'cmp' function.
+ * 'traversed'	Elements / nodes walked through to reach a position. */
+typedef struct nm_stats_s {
+	unsigned long allocs;
+	unsigned long reallocs;
+	unsigned long shifted;
+	unsigned long cmps;
+	unsigned long traversed;
+} nm_stats;
+
+#ifdef NM_STATS
+#define NM_STAT_ADD(stats, field, n) ((stats).field += (n))
+#else
+#define NM_STAT_ADD(stats, field, n) ((void) 0)
+#endif
+#define NM_STAT_INC(stats, field) NM_STAT_ADD(stats, field, 1)
+
+int nm_stats_enabled(void);
+int nm_stats_dump(FILE *stream, const char *name, const nm_stats *stats);
+
 #endif
@@ -1,21 +1,58 @@
 #include <stdlib.h>
+#include <string.h>
 #include "nmbintree.h"
 
 struct nmbintree_node_s {
 	void *data;
 	struct nmbintree_node_s *right;
 	struct nmbintree_node_s *left;
+	int height;
 };
 
+/* Upper bound for the height of a tree built with 'nmbintree_insert'.
+ * An AVL tree with 2^32 nodes is less than 47 levels deep. */
+#define NMBINTREE_MAX_HEIGHT 64
+
+/* Explicit stack used by the iterative traversals. It starts on
+ * 'local' (enough for any balanced tree) and only moves to the heap
+ * for deeper, degenerated trees. */
+typedef struct nmbintree_stack_s {
+	nmbintree_node **nodes;
+	unsigned int size;
+	unsigned int capacity;
+	nmbintree_node *local[NMBINTREE_MAX_HEIGHT];
+} nmbintree_stack;
+
+/* Block of 'chunk' nodes carved out by an arena. */
+typedef struct nmbintree_chunk_s {
+	struct nmbintree_chunk_s *next;
+	nmbintree_node nodes[];
+} nmbintree_chunk;
+
+/* Node arena of a tree created with 'nmbintree_alloc_arena'. Nodes
+ * are bump allocated from the newest chunk; released nodes are kept
+ * on 'free' (linked through 'right') and handed out first. */
+typedef struct nmbintree_arena_s {
+	unsigned int chunk;
+	unsigned int used;
+	nmbintree_node *free;
+	nmbintree_chunk *chunks;
+} nmbintree_arena;
+
 struct nmbintree_s {
 	unsigned int size;
 	int (*cmp)(const void *e1, const void *e2);
 	void (*destructor)(void *data);
 	nmbintree_node *root;
+	nmbintree_arena *arena;
+	const nm_allocator *allocator;
+#ifdef NM_STATS
+	nm_stats stats;
+#endif
 };
 
-unsigned int nmbintree_purge(nmbintree_node *treenode,
-                             void (*destructor)(void *data), nm_free_mode mode);
+static unsigned int nmbintree_purge(nmbintree *tree, nmbintree_node *treenode,
+                                    nm_free_mode mode);
 
 /**
  * Allocates memory for a new binary tree.
@@ -31,17 +68,153 @@ unsigned int nmbintree_purge(nmbintree_node *treenode,
  **/
 nmbintree *nmbintree_alloc(void (*destructor)(void *data),
                            int (*cmp)(const void *e1, const void *e2))
+{
+	return nmbintree_alloc_with(destructor, cmp, NULL);
+}
+
+/**
+ * Allocates memory for a new binary tree, whose memory (the
+ * tree and its nodes) comes from 'allocator'.
+ *
+ * INPUT:
+ * 'destructor'			Used to free data being held by nmbintree_node->data.
+ * 'cmp'				Function used to compare to binary tree elements.
+ * 'allocator'			The allocator (NULL for malloc / free).
+ *
+ * RETURNS
+ * NULL					If memory allocation fails.
+ * A new binary tree.
+ **/
+nmbintree *nmbintree_alloc_with(void (*destructor)(void *data),
+                                int (*cmp)(const void *e1, const void *e2),
+                                const nm_allocator *allocator)
 {
 	nmbintree* tree = NULL;
-	if ((tree = malloc(sizeof(*tree))) != NULL) {
+	if ((tree = nm_malloc(allocator, sizeof(*tree))) != NULL) {
 		tree->size = 0;
 		tree->root = NULL;
 		tree->destructor = destructor;
 		tree->cmp = cmp;
+		tree->arena = NULL;
+		tree->allocator = allocator;
+#ifdef NM_STATS
+		memset(&tree->stats, 0, sizeof(tree->stats));
+#endif
 	}
 	return tree;
 }
 
+/**
+ * Allocates memory for a new binary tree whose nodes come from
+ * an arena: they are carved out of blocks of 'chunk' nodes, instead
+ * of being allocated one by one.
+ *
+ * Building the tree calls 'malloc' once per 'chunk' nodes, and
+ * 'nmbintree_free(tree, SOFT)' releases the whole tree with one
+ * 'free' per block, without visiting the nodes. Nodes removed
+ * from the tree are recycled by later insertions, the blocks are
+ * only released with the tree.
+ *
+ * INPUT:
+ * 'destructor'			Used to free data being held by nmbintree_node->data.
+ * 'cmp'				Function used to compare to binary tree elements.
+ * 'chunk'				Number of nodes per block (0 for
+ * 						NMBINTREE_ARENA_CHUNK).
+ *
+ * RETURNS
+ * NULL					If memory allocation fails.
+ * A new binary tree.
+ **/
+nmbintree *nmbintree_alloc_arena(void (*destructor)(void *data),
+                                 int (*cmp)(const void *e1, const void *e2),
+                                 unsigned int chunk)
+{
+	return nmbintree_alloc_arena_with(destructor, cmp, chunk, NULL);
+}
+
+/**
+ * Allocates memory for a new arena binary tree (see
+ * 'nmbintree_alloc_arena'), whose memory (the tree, the arena
+ * and its blocks) comes from 'allocator'.
+ *
+ * INPUT:
+ * 'destructor'			Used to free data being held by nmbintree_node->data.
+ * 'cmp'				Function used to compare to binary tree elements.
+ * 'chunk'				Number of nodes per block (0 for
+ * 						NMBINTREE_ARENA_CHUNK).
+ * 'allocator'			The allocator (NULL for malloc / free).
+ *
+ * RETURNS
+ * NULL					If memory allocation fails.
+ * A new binary tree.
+ **/
+nmbintree *nmbintree_alloc_arena_with(void (*destructor)(void *data),
+                                      int (*cmp)(const void *e1, const void *e2),
+                                      unsigned int chunk,
+                                      const nm_allocator *allocator)
+{
+	nmbintree *tree = NULL;
+	if ((tree = nmbintree_alloc_with(destructor, cmp, allocator)) == NULL) {
+		return NULL;
+	}
+	if ((tree->arena = nm_malloc(tree->allocator, sizeof(*tree->arena))) == NULL) {
+		nm_free(tree->allocator, tree);
+		return NULL;
+	}
+	tree->arena->chunk = (chunk > 0) ? chunk : NMBINTREE_ARENA_CHUNK;
+	tree->arena->used = tree->arena->chunk;
+	tree->arena->free = NULL;
+	tree->arena->chunks = NULL;
+	return tree;
+}
+
+/**
+ * THIS FUNCTION IS PRIVATE.
+ * Allocates a node, from the arena of the tree if it has one.
+ **/
+static nmbintree_node *nmbintree_node_alloc(nmbintree *tree)
+{
+	nmbintree_arena *arena = tree->arena;
+	nmbintree_chunk *chunk;
+	nmbintree_node *node;
+	if (arena == NULL) {
+		if ((node = nm_malloc(tree->allocator, sizeof(nmbintree_node))) != NULL) {
+			NM_STAT_INC(tree->stats, allocs);
+		}
+		return node;
+	}
+	if ((node = arena->free) != NULL) {
+		arena->free = node->right;
+		return node;
+	}
+	if (arena->used == arena->chunk) {
+		chunk = nm_malloc(tree->allocator,
+		                  sizeof(*chunk) + arena->chunk * sizeof(nmbintree_node));
+		if (chunk == NULL) {
+			return NULL;
+		}
+		NM_STAT_INC(tree->stats, allocs);
+		chunk->next = arena->chunks;
+		arena->chunks = chunk;
+		arena->used = 0;
+	}
+	return &arena->chunks->nodes[arena->used++];
+}
+
+/**
+ * THIS FUNCTION IS PRIVATE.
+ * Releases a node allocated by 'nmbintree_node_alloc'.
+ **/
+static void nmbintree_node_release(nmbintree *tree, nmbintree_node *node)
+{
+	if (tree->arena == NULL) {
+		nm_free(tree->allocator, node);
+	} else {
+		node->right = tree->arena->free;
+		tree->arena->free = node;
+	}
+}
+
 /**
  * Free data structure.
  * If tree is NULL, returns (-1).
@@ -55,16 +228,26 @@ nmbintree *nmbintree_alloc(void (*destructor)(void *data),
  **/
 int nmbintree_free(nmbintree *tree, nm_free_mode mode)
 {
+	nmbintree_chunk *chunk, *next;
 	if (tree == NULL) {
 		return (-1);
 	}
-	if (tree->size != 0) {
-		if (mode == HARD && tree->destructor == NULL){
-			return (-1);
+	if (mode == HARD && tree->size != 0 && tree->destructor == NULL) {
+		return (-1);
+	}
+	/* With an arena, the nodes only need to be visited to free
+	 * their data, the blocks are released all at once */
+	if (tree->arena == NULL || mode == HARD) {
+		nmbintree_purge(tree, tree->root, mode);
+	}
+	if (tree->arena != NULL) {
+		for (chunk = tree->arena->chunks; chunk != NULL; chunk = next) {
+			next = chunk->next;
+			nm_free(tree->allocator, chunk);
 		}
-		nmbintree_purge_left(tree, NULL, mode);
+		nm_free(tree->allocator, tree->arena);
 	}
-	free(tree);
+	nm_free(tree->allocator, tree);
 	return (0);
 }
 
@@ -104,13 +287,14 @@ int nmbintree_add_left(nmbintree *tree, nmbintree_node *treenode,
 		}
 		where_to = &treenode->left;
 	}
-	new_node = malloc(sizeof(*new_node));
+	new_node = nmbintree_node_alloc(tree);
 	if (new_node == NULL) {
 		return (-1);
 	}
 	new_node->data = (void*) data;
 	new_node->left = NULL;
 	new_node->right = NULL;
+	new_node->height = 1;
 	*where_to = new_node;
 	tree->size++;
 	return (0);
@@ -152,13 +336,14 @@ int nmbintree_add_right(nmbintree *tree, nmbintree_node *treenode,
 		}
 		where_to = &treenode->right;
 	}
-	new_node = malloc(sizeof(*new_node));
+	new_node = nmbintree_node_alloc(tree);
 	if (new_node == NULL) {
 		return (-1);
 	}
 	new_node->data = (void*) data;
 	new_node->left = NULL;
 	new_node->right = NULL;
+	new_node->height = 1;
 	*where_to = new_node;
 	tree->size++;
 	return (0);
@@ -166,39 +351,340 @@ int nmbintree_add_right(nmbintree *tree, nmbintree_node *treenode,
 
 /**
  * THIS FUNCTION IS PRIVATE.
- * TO DO: INVESTIGATE A NON-RECURSIVE ALGORITHM.
+ * Returns the height of the subtree rooted at 'node'.
+ **/
+static int nmbintree_height(nmbintree_node *node)
+{
+	return (node == NULL) ? 0 : node->height;
+}
+
+/**
+ * THIS FUNCTION IS PRIVATE.
+ * Recomputes 'node->height' from its children.
+ **/
+static void nmbintree_update(nmbintree_node *node)
+{
+	int hl = nmbintree_height(node->left);
+	int hr = nmbintree_height(node->right);
+	node->height = ((hl > hr) ? hl : hr) + 1;
+}
+
+/**
+ * THIS FUNCTION IS PRIVATE.
+ * Rotates the subtree rooted at '*link' to the left.
+ **/
+static void nmbintree_rotate_left(nmbintree_node **link)
+{
+	nmbintree_node *node = *link;
+	nmbintree_node *right = node->right;
+	node->right = right->left;
+	right->left = node;
+	nmbintree_update(node);
+	nmbintree_update(right);
+	*link = right;
+}
+
+/**
+ * THIS FUNCTION IS PRIVATE.
+ * Rotates the subtree rooted at '*link' to the right.
+ **/
+static void nmbintree_rotate_right(nmbintree_node **link)
+{
+	nmbintree_node *node = *link;
+	nmbintree_node *left = node->left;
+	node->left = left->right;
+	left->right = node;
+	nmbintree_update(node);
+	nmbintree_update(left);
+	*link = left;
+}
+
+/**
+ * THIS FUNCTION IS PRIVATE.
+ * Restores the AVL balance of the subtree rooted at '*link',
+ * given that both its children are balanced and their heights
+ * differ by at most 2.
+ **/
+static void nmbintree_balance(nmbintree_node **link)
+{
+	nmbintree_node *node = *link;
+	int balance = nmbintree_height(node->left) - nmbintree_height(node->right);
+	if (balance > 1) {
+		if (nmbintree_height(node->left->left) <
+		        nmbintree_height(node->left->right)) {
+			nmbintree_rotate_left(&node->left);
+		}
+		nmbintree_rotate_right(link);
+	} else if (balance < -1) {
+		if (nmbintree_height(node->right->right) <
+		        nmbintree_height(node->right->left)) {
+			nmbintree_rotate_right(&node->right);
+		}
+		nmbintree_rotate_left(link);
+	} else {
+		nmbintree_update(node);
+	}
+}
+
+/**
+ * THIS FUNCTION IS PRIVATE.
+ * Re-balances the nodes on 'path' (from the deepest one up to the
+ * root) after an insertion or a removal. Stops as soon as a subtree
+ * height doesn't change, as nothing above it can be affected.
+ **/
+static void nmbintree_rebalance(nmbintree_node ***path, int depth)
+{
+	int height;
+	while (depth > 0) {
+		depth--;
+		height = (*path[depth])->height;
+		nmbintree_balance(path[depth]);
+		if ((*path[depth])->height == height) {
+			break;
+		}
+	}
+}
+
+/**
+ * THIS FUNCTION IS PRIVATE.
+ * Compares 'data' with the element held by 'node', counting
+ * the visited node when the library is built with NM_STATS.
+ **/
+static inline int nmbintree_cmp(nmbintree *tree, const void *data,
+                                const nmbintree_node *node)
+{
+	NM_STAT_INC(tree->stats, cmps);
+	NM_STAT_INC(tree->stats, traversed);
+	return tree->cmp(data, node->data);
+}
+
+/**
+ * Inserts 'data' in the tree, keeping the elements ordered by
+ * 'tree->cmp' and the tree height balanced (AVL), so every
+ * search is O(log n).
+ *
+ * The ordered functions ('nmbintree_insert', 'nmbintree_find',
+ * 'nmbintree_erase', 'nmbintree_lower_bound', 'nmbintree_upper_bound')
+ * expect a tree built only through 'nmbintree_insert' /
+ * 'nmbintree_erase', and should not be mixed with the 'add' / 'purge'
+ * family of functions.
+ *
+ * INPUT:
+ * 'tree'			The binary tree.
+ * 'data'			Data to be inserted.
+ *
+ * RETURNS:
+ * 0				If insertion is succesful.
+ * 1				If an element equal to 'data' is already in
+ * 					the tree (the tree is not modified).
+ * -1				If tree is NULL, tree->cmp is NULL or memory
+ * 					allocation fails.
+ **/
+int nmbintree_insert(nmbintree *tree, const void *data)
+{
+	nmbintree_node **path[NMBINTREE_MAX_HEIGHT];
+	nmbintree_node **link;
+	nmbintree_node *new_node;
+	int depth = 0, c;
+	if (tree == NULL || tree->cmp == NULL) {
+		return (-1);
+	}
+	link = &tree->root;
+	while (*link != NULL) {
+		if ((c = nmbintree_cmp(tree, data, *link)) == 0) {
+			return (1);
+		}
+		path[depth++] = link;
+		link = (c < 0) ? &(*link)->left : &(*link)->right;
+	}
+	if ((new_node = nmbintree_node_alloc(tree)) == NULL) {
+		return (-1);
+	}
+	new_node->data = (void*) data;
+	new_node->left = NULL;
+	new_node->right = NULL;
+	new_node->height = 1;
+	*link = new_node;
+	tree->size++;
+	nmbintree_rebalance(path, depth);
+	return (0);
+}
+
+/**
+ * Searches the tree for an element equal (by 'tree->cmp')
+ * to 'data'.
+ *
+ * RETURNS:
+ * NULL				If there is no such element (or tree is NULL,
+ * 					tree->cmp is NULL).
+ * The node holding the element.
+ **/
+nmbintree_node *nmbintree_find(nmbintree *tree, const void *data)
+{
+	nmbintree_node *node;
+	int c;
+	if (tree == NULL || tree->cmp == NULL) {
+		return NULL;
+	}
+	node = tree->root;
+	while (node != NULL && (c = nmbintree_cmp(tree, data, node)) != 0) {
+		node = (c < 0) ? node->left : node->right;
+	}
+	return node;
+}
+
+/**
+ * Removes the element equal (by 'tree->cmp') to 'data' from
+ * the tree, and returns the data it was holding. The tree is
+ * re-balanced.
+ *
+ * RETURNS:
+ * NULL				If there is no such element (or tree is NULL,
+ * 					tree->cmp is NULL).
+ * 'data'			The data held by the removed node.
+ **/
+void *nmbintree_erase(nmbintree *tree, const void *data)
+{
+	nmbintree_node **path[NMBINTREE_MAX_HEIGHT];
+	nmbintree_node **link, **succ_link;
+	nmbintree_node *node, *succ;
+	void *rdata;
+	int depth = 0, node_depth, c;
+	if (tree == NULL || tree->cmp == NULL) {
+		return NULL;
+	}
+	link = &tree->root;
+	while (*link != NULL && (c = nmbintree_cmp(tree, data, *link)) != 0) {
+		path[depth++] = link;
+		link = (c < 0) ? &(*link)->left : &(*link)->right;
+	}
+	if ((node = *link) == NULL) {
+		return NULL;
+	}
+	rdata = node->data;
+	if (node->left == NULL) {
+		*link = node->right;
+	} else if (node->right == NULL) {
+		*link = node->left;
+	} else {
+		/* Replace the node by its in-order successor */
+		node_depth = depth;
+		path[depth++] = link;
+		succ_link = &node->right;
+		while ((*succ_link)->left != NULL) {
+			NM_STAT_INC(tree->stats, traversed);
+			path[depth++] = succ_link;
+			succ_link = &(*succ_link)->left;
+		}
+		succ = *succ_link;
+		*succ_link = succ->right;
+		succ->left = node->left;
+		succ->right = node->right;
+		succ->height = node->height;
+		*link = succ;
+		if (depth > node_depth + 1) {
+			path[node_depth + 1] = &succ->right;
+		}
+	}
+	nmbintree_node_release(tree, node);
+	tree->size--;
+	nmbintree_rebalance(path, depth);
+	return rdata;
+}
+
+/**
+ * Returns the node holding the smallest element that
+ * is not less than 'data'.
+ *
+ * RETURNS:
+ * NULL				If all elements are less than 'data' (or
+ * 					tree is NULL, tree->cmp is NULL).
+ * The node.
+ **/
+nmbintree_node *nmbintree_lower_bound(nmbintree *tree, const void *data)
+{
+	nmbintree_node *node, *bound = NULL;
+	if (tree == NULL || tree->cmp == NULL) {
+		return NULL;
+	}
+	node = tree->root;
+	while (node != NULL) {
+		if (nmbintree_cmp(tree, data, node) <= 0) {
+			bound = node;
+			node = node->left;
+		} else {
+			node = node->right;
+		}
+	}
+	return bound;
+}
+
+/**
+ * Returns the node holding the smallest element that
+ * is greater than 'data'.
+ *
+ * RETURNS:
+ * NULL				If no element is greater than 'data' (or
+ * 					tree is NULL, tree->cmp is NULL).
+ * The node.
+ **/
+nmbintree_node *nmbintree_upper_bound(nmbintree *tree, const void *data)
+{
+	nmbintree_node *node, *bound = NULL;
+	if (tree == NULL || tree->cmp == NULL) {
+		return NULL;
+	}
+	node = tree->root;
+	while (node != NULL) {
+		if (nmbintree_cmp(tree, data, node) < 0) {
+			bound = node;
+			node = node->left;
+		} else {
+			node = node->right;
+		}
+	}
+	return bound;
+}
+
+/**
+ * THIS FUNCTION IS PRIVATE.
  * Removes and de-allocate memory for all the nodes
  * bellow treenode (+treenode).
  *
- * All data being held by those node is
- * also being freed.
- *
- * If 'treenode' or 'destructor' are NULL,
- * the function returns (0).
+ * The walk is iterative and needs no extra memory: a node with
+ * a left child is rotated right, until the node at hand has none;
+ * it is then released and the walk goes on with its right child.
  *
  * IF 'mode':
  * SOFT			: Will free only node_elements, data being held
  * 				by the node elements will be preserved.
- * HARD			: Will free also data.
+ * HARD			: Will free also data (with 'tree->destructor',
+ * 				which must not be NULL).
  *
  * Returns:
  * The number of destroyed nodes.
  **/
-unsigned int nmbintree_purge(nmbintree_node *treenode,
-                             void (*destructor)(void *data), nm_free_mode mode)
+static unsigned int nmbintree_purge(nmbintree *tree, nmbintree_node *treenode,
+                                    nm_free_mode mode)
 {
 	nmbintree_node *left, *right;
-	if (treenode == NULL || destructor == NULL) {
-		return (0);
-	}
-	left = treenode->left;
-	right = treenode->right;
-	free(treenode);
-	if (mode == HARD) {
-		destructor(treenode->data);
+	unsigned int count = 0;
+	while (treenode != NULL) {
+		if ((left = treenode->left) != NULL) {
+			treenode->left = left->right;
+			left->right = treenode;
+			treenode = left;
+		} else {
+			right = treenode->right;
+			if (mode == HARD && treenode->data != NULL) {
+				tree->destructor(treenode->data);
+			}
+			nmbintree_node_release(tree, treenode);
+			treenode = right;
+			count++;
+		}
 	}
-	return (nmbintree_purge(left, destructor, mode) +
-	        nmbintree_purge(right, destructor, mode) + 1);
+	return count;
 }
 
 /**
@@ -214,7 +700,6 @@ unsigned int nmbintree_purge(nmbintree_node *treenode,
 int nmbintree_purge_left(nmbintree *tree, nmbintree_node *treenode, nm_free_mode mode)
 {
 	nmbintree_node **start_node = NULL;
-	nmbintree_node *tmp;
 	if (tree == NULL || tree->destructor == NULL) {
 		return (-1);
 	}
@@ -226,7 +711,8 @@ int nmbintree_purge_left(nmbintree *tree, nmbintree_node *treenode, nm_free_mode
 	} else {
 		start_node = &treenode->left;
 	}
-	tree->size -= nmbintree_purge(*start_node, tree->destructor, mode);
+	tree->size -= nmbintree_purge(tree, *start_node, mode);
+	*start_node = NULL;
 	return (0);
 }
 
@@ -243,7 +729,6 @@ int nmbintree_purge_left(nmbintree *tree, nmbintree_node *treenode, nm_free_mode
 int nmbintree_purge_right(nmbintree *tree, nmbintree_node *treenode, nm_free_mode mode)
 {
 	nmbintree_node **start_node = NULL;
-	nmbintree_node *tmp;
 	if (tree == NULL || tree->destructor == NULL) {
 		return (-1);
 	}
@@ -255,7 +740,8 @@ int nmbintree_purge_right(nmbintree *tree, nmbintree_node *treenode, nm_free_mod
 	} else {
 		start_node = &treenode->right;
 	}
-	tree->size -= nmbintree_purge(*start_node, tree->destructor, mode);
+	tree->size -= nmbintree_purge(tree, *start_node, mode);
+	*start_node = NULL;
 	return (0);
 }
 
@@ -430,3 +916,277 @@ int nmbintree_set_right(nmbintree_node *node, const void *data)
 {
 	return (node == NULL) ? (-1) : nmbintree_set_data(node->right, data);
 }
+
+/**
+ * THIS FUNCTION IS PRIVATE.
+ * Initializes an empty traversal stack.
+ **/
+static void nmbintree_stack_init(nmbintree_stack *stack)
+{
+	stack->nodes = stack->local;
+	stack->size = 0;
+	stack->capacity = NMBINTREE_MAX_HEIGHT;
+}
+
+/**
+ * THIS FUNCTION IS PRIVATE.
+ * Releases the heap memory used by a traversal stack (if any).
+ **/
+static void nmbintree_stack_release(nmbintree_stack *stack)
+{
+	if (stack->nodes != stack->local) {
+		free(stack->nodes);
+	}
+}
+
+/**
+ * THIS FUNCTION IS PRIVATE.
+ * Pushes 'node' on the traversal stack, doubling its capacity
+ * if needed.
+ *
+ * RETURNS:
+ * 0				If the node was pushed.
+ * -1				If memory allocation failed.
+ **/
+static int nmbintree_stack_push(nmbintree_stack *stack, nmbintree_node *node)
+{
+	nmbintree_node **tmp_nodes;
+	unsigned int i;
+	if (stack->size == stack->capacity) {
+		if (stack->nodes == stack->local) {
+			tmp_nodes = malloc(2 * stack->capacity * sizeof(*tmp_nodes));
+			if (tmp_nodes != NULL) {
+				for (i = 0; i < stack->size; i++) {
+					tmp_nodes[i] = stack->local[i];
+				}
+			}
+		} else {
+			tmp_nodes = realloc(stack->nodes,
+			                    2 * stack->capacity * sizeof(*tmp_nodes));
+		}
+		if (tmp_nodes == NULL) {
+			return (-1);
+		}
+		stack->nodes = tmp_nodes;
+		stack->capacity *= 2;
+	}
+	stack->nodes[stack->size++] = node;
+	return (0);
+}
+
+/**
+ * Walks the subtree rooted at 'node' in pre-order (node, left, right)
+ * calling 'visit(node->data, arg)' for every node.
+ *
+ * The walk is iterative: no recursion, and memory is only allocated
+ * if the tree is deeper than 'NMBINTREE_MAX_HEIGHT' levels.
+ *
+ * INPUT:
+ * 'node'			Root of the subtree to be walked.
+ * 'visit'			Called for every node. If it returns something
+ * 					other than 0 the walk stops.
+ * 'arg'			Passed unchanged to 'visit'.
+ *
+ * RETURNS:
+ * 0				If the whole subtree was visited.
+ * -1				If 'visit' is NULL or memory allocation failed.
+ * The value returned by 'visit' if the walk was stopped.
+ **/
+int nmbintree_preorder_visit(nmbintree_node *node,
+                             int (*visit)(void *data, void *arg), void *arg)
+{
+	nmbintree_stack stack;
+	int rc = 0;
+	if (visit == NULL) {
+		return (-1);
+	}
+	if (node == NULL) {
+		return (0);
+	}
+	nmbintree_stack_init(&stack);
+	nmbintree_stack_push(&stack, node);
+	while (stack.size > 0 && rc == 0) {
+		node = stack.nodes[--stack.size];
+		if ((rc = visit(node->data, arg)) != 0) {
+			break;
+		}
+		if ((node->right != NULL && nmbintree_stack_push(&stack, node->right) != 0) ||
+		        (node->left != NULL && nmbintree_stack_push(&stack, node->left) != 0)) {
+			rc = -1;
+		}
+	}
+	nmbintree_stack_release(&stack);
+	return rc;
+}
+
+/**
+ * Walks the subtree rooted at 'node' in in-order (left, node, right)
+ * calling 'visit(node->data, arg)' for every node.
+ *
+ * See 'nmbintree_preorder_visit' for the parameters and the
+ * returned values.
+ **/
+int nmbintree_inorder_visit(nmbintree_node *node,
+                            int (*visit)(void *data, void *arg), void *arg)
+{
+	nmbintree_stack stack;
+	int rc = 0;
+	if (visit == NULL) {
+		return (-1);
+	}
+	nmbintree_stack_init(&stack);
+	while ((node != NULL || stack.size > 0) && rc == 0) {
+		if (node != NULL) {
+			if (nmbintree_stack_push(&stack, node) != 0) {
+				rc = -1;
+			}
+			node = node->left;
+		} else {
+			node = stack.nodes[--stack.size];
+			rc = visit(node->data, arg);
+			node = node->right;
+		}
+	}
+	nmbintree_stack_release(&stack);
+	return rc;
+}
+
+/**
+ * Walks the subtree rooted at 'node' in post-order (left, right, node)
+ * calling 'visit(node->data, arg)' for every node.
+ *
+ * See 'nmbintree_preorder_visit' for the parameters and the
+ * returned values.
+ **/
+int nmbintree_postorder_visit(nmbintree_node *node,
+                              int (*visit)(void *data, void *arg), void *arg)
+{
+	nmbintree_stack stack;
+	nmbintree_node *top, *last = NULL;
+	int rc = 0;
+	if (visit == NULL) {
+		return (-1);
+	}
+	nmbintree_stack_init(&stack);
+	while ((node != NULL || stack.size > 0) && rc == 0) {
+		if (node != NULL) {
+			if (nmbintree_stack_push(&stack, node) != 0) {
+				rc = -1;
+			}
+			node = node->left;
+		} else {
+			top = stack.nodes[stack.size - 1];
+			if (top->right != NULL && top->right != last) {
+				node = top->right;
+			} else {
+				rc = visit(top->data, arg);
+				last = top;
+				stack.size--;
+			}
+		}
+	}
+	nmbintree_stack_release(&stack);
+	return rc;
+}
+
+/**
+ * THIS FUNCTION IS PRIVATE.
+ * Visitor appending 'data' at the tail of the list 'arg'.
+ **/
+static int nmbintree_append(void *data, void *arg)
+{
+	return nmlist_insert_next((nmlist*) arg, nmlist_tail((nmlist*) arg), data);
+}
+
+/**
+ * Appends the data held by the subtree rooted at 'node' to 'list',
+ * in pre-order.
+ *
+ * RETURNS:
+ * 0				If all the data was appended.
+ * -1				If list is NULL or memory allocation failed.
+ **/
+int nmbintree_preoder(nmbintree_node *node, nmlist *list)
+{
+	if (list == NULL) {
+		return (-1);
+	}
+	return nmbintree_preorder_visit(node, nmbintree_append, list);
+}
+
+/**
+ * Appends the data held by the subtree rooted at 'node' to 'list',
+ * in in-order.
+ *
+ * RETURNS:
+ * 0				If all the data was appended.
+ * -1				If list is NULL or memory allocation failed.
+ **/
+int nmbintree_inorder(nmbintree_node *node, nmlist *list)
+{
+	if (list == NULL) {
+		return (-1);
+	}
+	return nmbintree_inorder_visit(node, nmbintree_append, list);
+}
+
+/**
+ * Appends the data held by the subtree rooted at 'node' to 'list',
+ * in post-order.
+ *
+ * RETURNS:
+ * 0				If all the data was appended.
+ * -1				If list is NULL or memory allocation failed.
+ **/
+int nmmbintree_postorder(nmbintree_node *node, nmlist *list)
+{
+	if (list == NULL) {
+		return (-1);
+	}
+	return nmbintree_postorder_visit(node, nmbintree_append, list);
+}
+
+/**
+ * Copies the instrumentation counters of 'tree' (see 'nm_stats').
+ *
+ * RETURNS:
+ * 0				If the counters were copied to 'stats'.
+ * -1				If 'tree' or 'stats' is NULL, or the library
+ * 					was built without NM_STATS.
+ **/
+int nmbintree_stats(nmbintree *tree, nm_stats *stats)
+{
+#ifdef NM_STATS
+	if (tree == NULL || stats == NULL) {
+		return (-1);
+	}
+	*stats = tree->stats;
+	return (0);
+#else
+	(void) tree;
+	(void) stats;
+	return (-1);
+#endif
+}
+
+/**
+ * Sets the instrumentation counters of 'tree' back to zero.
+ *
+ * RETURNS:
+ * 0				If the counters were reset.
+ * -1				If 'tree' is NULL, or the library was built
+ * 					without NM_STATS.
+ **/
+int nmbintree_stats_reset(nmbintree *tree)
+{
+#ifdef NM_STATS
+	if (tree == NULL) {
+		return (-1);
+	}
+	memset(&tree->stats, 0, sizeof(tree->stats));
+	return (0);
+#else
+	(void) tree;
+	return (-1);
+#endif
+}
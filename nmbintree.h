@@ -6,8 +6,25 @@
 typedef struct nmbintree_node_s nmbintree_node;
 typedef struct nmbintree_s nmbintree;
 
+/* Default number of nodes per block of a tree created with
+ * 'nmbintree_alloc_arena'. */
+#define NMBINTREE_ARENA_CHUNK 4096
+
 nmbintree *nmbintree_alloc(void (*destructor)(void *data),
                            int (*cmp)(const void *e1, const void *e2));
+
+nmbintree *nmbintree_alloc_with(void (*destructor)(void *data),
+                                int (*cmp)(const void *e1, const void *e2),
+                                const nm_allocator *allocator);
+
+nmbintree *nmbintree_alloc_arena(void (*destructor)(void *data),
+                                 int (*cmp)(const void *e1, const void *e2),
+                                 unsigned int chunk);
+
+nmbintree *nmbintree_alloc_arena_with(void (*destructor)(void *data),
+                                      int (*cmp)(const void *e1, const void *e2),
+                                      unsigned int chunk,
+                                      const nm_allocator *allocator);
 						   
 int nmbintree_free(nmbintree *tree, nm_free_mode mode);
 
@@ -17,6 +34,16 @@ int nmbintree_add_left(nmbintree *tree, nmbintree_node *treenode,
 int nmbintree_add_right(nmbintree *tree, nmbintree_node *treenode,
                         const void *data);
 						
+int nmbintree_insert(nmbintree *tree, const void *data);
+
+nmbintree_node *nmbintree_find(nmbintree *tree, const void *data);
+
+void *nmbintree_erase(nmbintree *tree, const void *data);
+
+nmbintree_node *nmbintree_lower_bound(nmbintree *tree, const void *data);
+
+nmbintree_node *nmbintree_upper_bound(nmbintree *tree, const void *data);
+
 int nmbintree_purge_left(nmbintree *tree, nmbintree_node *treenode,
                          nm_free_mode mode);
 						 
@@ -30,6 +57,9 @@ nmbintree *nmbintree_merge(nmbintree *leftree, nmbintree *rightree,
 						   
 unsigned int nmbintree_size(nmbintree *tree);
 
+int nmbintree_stats(nmbintree *tree, nm_stats *stats);
+int nmbintree_stats_reset(nmbintree *tree);
+
 nmbintree_node *nmbintree_root(nmbintree *tree);
 
 nmbintree_node *nmbintree_left(nmbintree_node *treenode);
@@ -58,4 +88,13 @@ int nmbintree_inorder(nmbintree_node *node, nmlist *list);
 
 int nmmbintree_postorder(nmbintree_node *node, nmlist *list);
 
+int nmbintree_preorder_visit(nmbintree_node *node,
+                             int (*visit)(void *data, void *arg), void *arg);
+
+int nmbintree_inorder_visit(nmbintree_node *node,
+                            int (*visit)(void *data, void *arg), void *arg);
+
+int nmbintree_postorder_visit(nmbintree_node *node,
+                              int (*visit)(void *data, void *arg), void *arg);
+
 #endif
@@ -0,0 +1,766 @@
+#include <stdlib.h>
+#include <string.h>
+#include "nmbtree.h"
+
+/* In-memory B+-tree.
+ *
+ * Elements live in the leaves only, sorted, and the leaves are
+ * linked left to right for range scans. An inner node with 'count'
+ * keys has 'count + 1' children; 'keys[i]' is less than or equal to
+ * every element under 'children[i + 1]' and greater than every
+ * element under 'children[i]'. The keys are copies of element
+ * pointers still held by the tree (a removed element is replaced
+ * by its successor wherever it is used as a key), so 'cmp' never
+ * sees a removed element.
+ *
+ * Every node but the root is at least half full, so the height
+ * stays within log(n) / log(NMBTREE_FANOUT / 2). */
+#define NMBTREE_MIN_LEAF (NMBTREE_FANOUT / 2)
+#define NMBTREE_MIN_KEYS ((NMBTREE_FANOUT + 1) / 2 - 1)
+
+typedef struct nmbtree_node_s {
+	unsigned int count;
+	int leaf;
+} nmbtree_node;
+
+typedef struct nmbtree_leaf_s {
+	nmbtree_node hdr;
+	struct nmbtree_leaf_s *next;
+	void *data[NMBTREE_FANOUT];
+} nmbtree_leaf;
+
+typedef struct nmbtree_inner_s {
+	nmbtree_node hdr;
+	void *keys[NMBTREE_FANOUT - 1];
+	nmbtree_node *children[NMBTREE_FANOUT];
+} nmbtree_inner;
+
+struct nmbtree_s {
+	void (*destructor)(void *data);
+	int (*cmp)(const void *e1, const void *e2);
+	unsigned int size;
+	nmbtree_node *root;
+	nmbtree_leaf *first;
+};
+
+/**
+ * Allocates memory for a new empty B+-tree.
+ *
+ * Compared to 'nmbintree' every node holds up to NMBTREE_FANOUT
+ * elements (or children) in a contiguous array searched by
+ * bisection, so a lookup touches a handful of nodes instead of one
+ * node per level of a binary tree.
+ *
+ * INPUT:
+ * 'destructor'		Destructor for 'data' being hold by the tree.
+ * 'cmp'			Function needed to compare two elements (mandatory).
+ *
+ * RETURNS:
+ * NULL				If memory allocation fails.
+ * A new tree.
+ **/
+nmbtree *nmbtree_alloc(void (*destructor)(void *data),
+                       int (*cmp)(const void *e1, const void *e2))
+{
+	nmbtree *tree = NULL;
+	if ((tree = malloc(sizeof(*tree))) != NULL) {
+		tree->destructor = destructor;
+		tree->cmp = cmp;
+		tree->size = 0;
+		tree->root = NULL;
+		tree->first = NULL;
+	}
+	return tree;
+}
+
+/**
+ * THIS FUNCTION IS PRIVATE.
+ * De-allocates the subtree rooted at 'node'.
+ **/
+static void nmbtree_free_node(nmbtree_node *node)
+{
+	unsigned int i;
+	if (!node->leaf) {
+		for (i = 0; i <= node->count; i++) {
+			nmbtree_free_node(((nmbtree_inner*) node)->children[i]);
+		}
+	}
+	free(node);
+}
+
+/**
+ * Free data structure.
+ * If tree is NULL, returns (-1).
+ * If tree->destructor is NULL and mode is HARD, returns (-1).
+ *
+ * mode:
+ *	SOFT		: Will free only the nodes, and the tree
+ * 					structure. 'data' being held will be preserved.
+ *  HARD		: Will free the nodes, the 'tree', and
+ * 					the 'data' being held by the tree.
+ **/
+int nmbtree_free(nmbtree *tree, nm_free_mode mode)
+{
+	nmbtree_leaf *leaf;
+	unsigned int i;
+	if (tree == NULL || (mode == HARD && tree->destructor == NULL)) {
+		return (-1);
+	}
+	if (mode == HARD) {
+		for (leaf = tree->first; leaf != NULL; leaf = leaf->next) {
+			for (i = 0; i < leaf->hdr.count; i++) {
+				if (leaf->data[i] != NULL) {
+					tree->destructor(leaf->data[i]);
+				}
+			}
+		}
+	}
+	if (tree->root != NULL) {
+		nmbtree_free_node(tree->root);
+	}
+	free(tree);
+	return (0);
+}
+
+/**
+ * THIS FUNCTION IS PRIVATE.
+ * Allocates an empty leaf.
+ **/
+static nmbtree_leaf *nmbtree_leaf_alloc(void)
+{
+	nmbtree_leaf *leaf = NULL;
+	if ((leaf = malloc(sizeof(*leaf))) != NULL) {
+		leaf->hdr.count = 0;
+		leaf->hdr.leaf = 1;
+		leaf->next = NULL;
+	}
+	return leaf;
+}
+
+/**
+ * THIS FUNCTION IS PRIVATE.
+ * Allocates an empty inner node.
+ **/
+static nmbtree_inner *nmbtree_inner_alloc(void)
+{
+	nmbtree_inner *inner = NULL;
+	if ((inner = malloc(sizeof(*inner))) != NULL) {
+		inner->hdr.count = 0;
+		inner->hdr.leaf = 0;
+	}
+	return inner;
+}
+
+/**
+ * THIS FUNCTION IS PRIVATE.
+ * Returns the index of the child of 'inner' whose subtree would
+ * hold 'data' (the number of keys <= 'data').
+ **/
+static unsigned int nmbtree_child_index(nmbtree *tree, nmbtree_inner *inner,
+                                        const void *data)
+{
+	unsigned int lo = 0, hi = inner->hdr.count, mid;
+	while (lo < hi) {
+		mid = lo + (hi - lo) / 2;
+		if (tree->cmp(data, inner->keys[mid]) >= 0) {
+			lo = mid + 1;
+		} else {
+			hi = mid;
+		}
+	}
+	return lo;
+}
+
+/**
+ * THIS FUNCTION IS PRIVATE.
+ * Returns the position of the first element of 'leaf' not less
+ * than 'data' (or greater than, if 'upper' is set).
+ **/
+static unsigned int nmbtree_leaf_bound(nmbtree *tree, nmbtree_leaf *leaf,
+                                       const void *data, int upper)
+{
+	unsigned int lo = 0, hi = leaf->hdr.count, mid;
+	int c;
+	while (lo < hi) {
+		mid = lo + (hi - lo) / 2;
+		c = tree->cmp(leaf->data[mid], data);
+		if (c < 0 || (upper && c == 0)) {
+			lo = mid + 1;
+		} else {
+			hi = mid;
+		}
+	}
+	return lo;
+}
+
+/**
+ * THIS FUNCTION IS PRIVATE.
+ * Walks from the root (not NULL) down to the leaf that would hold
+ * 'data'. If 'path' is not NULL the inner nodes visited and the
+ * index of the child taken are stored in 'path' / 'index', and
+ * their number in '*depth'.
+ **/
+static nmbtree_leaf *nmbtree_descend(nmbtree *tree, const void *data,
+                                     nmbtree_inner **path, unsigned int *index,
+                                     int *depth)
+{
+	nmbtree_node *node = tree->root;
+	unsigned int i;
+	int d = 0;
+	while (!node->leaf) {
+		i = nmbtree_child_index(tree, (nmbtree_inner*) node, data);
+		if (path != NULL) {
+			path[d] = (nmbtree_inner*) node;
+			index[d] = i;
+		}
+		d++;
+		node = ((nmbtree_inner*) node)->children[i];
+	}
+	if (depth != NULL) {
+		*depth = d;
+	}
+	return (nmbtree_leaf*) node;
+}
+
+/**
+ * Inserts 'data' in the tree, keeping the elements ordered by
+ * 'tree->cmp'. A full leaf is split in two, the split propagating
+ * up as long as the parents are full.
+ *
+ * RETURNS:
+ * 0				If insertion is succesful.
+ * 1				If an element equal to 'data' is already in
+ * 					the tree (the tree is not modified).
+ * -1				If tree is NULL, tree->cmp is NULL or memory
+ * 					allocation fails (the tree is not modified).
+ **/
+int nmbtree_insert(nmbtree *tree, const void *data)
+{
+	nmbtree_inner *path[NMBTREE_MAX_HEIGHT];
+	unsigned int index[NMBTREE_MAX_HEIGHT];
+	nmbtree_inner *spare[NMBTREE_MAX_HEIGHT + 1];
+	void *tmp_keys[NMBTREE_FANOUT + 1];
+	nmbtree_node *tmp_children[NMBTREE_FANOUT + 1];
+	nmbtree_leaf *leaf, *right;
+	nmbtree_inner *inner, *new_inner;
+	nmbtree_node *child;
+	void *key;
+	unsigned int pos, i, n, mid;
+	int depth, d, nspare = 0;
+	if (tree == NULL || tree->cmp == NULL) {
+		return (-1);
+	}
+	if (tree->root == NULL) {
+		if ((leaf = nmbtree_leaf_alloc()) == NULL) {
+			return (-1);
+		}
+		leaf->data[0] = (void*) data;
+		leaf->hdr.count = 1;
+		tree->root = &leaf->hdr;
+		tree->first = leaf;
+		tree->size = 1;
+		return (0);
+	}
+	leaf = nmbtree_descend(tree, data, path, index, &depth);
+	pos = nmbtree_leaf_bound(tree, leaf, data, 0);
+	if (pos < leaf->hdr.count && tree->cmp(data, leaf->data[pos]) == 0) {
+		return (1);
+	}
+	n = leaf->hdr.count;
+	if (n < NMBTREE_FANOUT) {
+		memmove(&leaf->data[pos + 1], &leaf->data[pos], (n - pos) * sizeof(void*));
+		leaf->data[pos] = (void*) data;
+		leaf->hdr.count++;
+		tree->size++;
+		return (0);
+	}
+	/* Allocate every node the split needs up front, so running out
+	 * of memory leaves the tree untouched */
+	for (d = depth - 1; d >= 0 && path[d]->hdr.count == NMBTREE_FANOUT - 1; d--);
+	n = depth - 1 - d + ((d < 0) ? 1 : 0);
+	if ((right = nmbtree_leaf_alloc()) == NULL) {
+		return (-1);
+	}
+	for (nspare = 0; nspare < (int) n; nspare++) {
+		if ((spare[nspare] = nmbtree_inner_alloc()) == NULL) {
+			while (nspare > 0) {
+				free(spare[--nspare]);
+			}
+			free(right);
+			return (-1);
+		}
+	}
+	/* Split the leaf: NMBTREE_FANOUT + 1 elements, the left half
+	 * keeping the extra one */
+	memcpy(tmp_keys, leaf->data, pos * sizeof(void*));
+	tmp_keys[pos] = (void*) data;
+	memcpy(&tmp_keys[pos + 1], &leaf->data[pos], (NMBTREE_FANOUT - pos) * sizeof(void*));
+	mid = (NMBTREE_FANOUT + 2) / 2;
+	memcpy(leaf->data, tmp_keys, mid * sizeof(void*));
+	leaf->hdr.count = mid;
+	memcpy(right->data, &tmp_keys[mid], (NMBTREE_FANOUT + 1 - mid) * sizeof(void*));
+	right->hdr.count = NMBTREE_FANOUT + 1 - mid;
+	right->next = leaf->next;
+	leaf->next = right;
+	tree->size++;
+	key = right->data[0];
+	child = &right->hdr;
+	/* Insert ('key', 'child') in the parents, splitting full ones */
+	for (d = depth - 1; d >= 0; d--) {
+		inner = path[d];
+		i = index[d];
+		n = inner->hdr.count;
+		if (n < NMBTREE_FANOUT - 1) {
+			memmove(&inner->keys[i + 1], &inner->keys[i], (n - i) * sizeof(void*));
+			memmove(&inner->children[i + 2], &inner->children[i + 1],
+			        (n - i) * sizeof(nmbtree_node*));
+			inner->keys[i] = key;
+			inner->children[i + 1] = child;
+			inner->hdr.count++;
+			return (0);
+		}
+		memcpy(tmp_keys, inner->keys, i * sizeof(void*));
+		tmp_keys[i] = key;
+		memcpy(&tmp_keys[i + 1], &inner->keys[i], (n - i) * sizeof(void*));
+		memcpy(tmp_children, inner->children, (i + 1) * sizeof(nmbtree_node*));
+		tmp_children[i + 1] = child;
+		memcpy(&tmp_children[i + 2], &inner->children[i + 1],
+		       (n - i) * sizeof(nmbtree_node*));
+		/* NMBTREE_FANOUT keys: 'mid' stay, one moves up, the rest
+		 * go to the new node */
+		mid = NMBTREE_FANOUT / 2;
+		new_inner = spare[--nspare];
+		memcpy(inner->keys, tmp_keys, mid * sizeof(void*));
+		memcpy(inner->children, tmp_children, (mid + 1) * sizeof(nmbtree_node*));
+		inner->hdr.count = mid;
+		new_inner->hdr.count = NMBTREE_FANOUT - mid - 1;
+		memcpy(new_inner->keys, &tmp_keys[mid + 1],
+		       new_inner->hdr.count * sizeof(void*));
+		memcpy(new_inner->children, &tmp_children[mid + 1],
+		       (new_inner->hdr.count + 1) * sizeof(nmbtree_node*));
+		key = tmp_keys[mid];
+		child = &new_inner->hdr;
+	}
+	/* The root was split: grow the tree by one level */
+	new_inner = spare[--nspare];
+	new_inner->hdr.count = 1;
+	new_inner->keys[0] = key;
+	new_inner->children[0] = tree->root;
+	new_inner->children[1] = child;
+	tree->root = &new_inner->hdr;
+	return (0);
+}
+
+/**
+ * Searches the tree for an element equal (by 'tree->cmp')
+ * to 'data'.
+ *
+ * RETURNS:
+ * NULL				If there is no such element (or tree is NULL,
+ * 					tree->cmp is NULL).
+ * The element.
+ **/
+void *nmbtree_find(nmbtree *tree, const void *data)
+{
+	nmbtree_leaf *leaf;
+	unsigned int pos;
+	if (tree == NULL || tree->cmp == NULL || tree->root == NULL) {
+		return NULL;
+	}
+	leaf = nmbtree_descend(tree, data, NULL, NULL, NULL);
+	pos = nmbtree_leaf_bound(tree, leaf, data, 0);
+	if (pos < leaf->hdr.count && tree->cmp(data, leaf->data[pos]) == 0) {
+		return leaf->data[pos];
+	}
+	return NULL;
+}
+
+/**
+ * THIS FUNCTION IS PRIVATE.
+ * Moves the last element (or child) of 'children[i - 1]' to the
+ * front of 'children[i]'.
+ **/
+static void nmbtree_borrow_left(nmbtree_inner *parent, unsigned int i)
+{
+	nmbtree_node *node = parent->children[i], *left = parent->children[i - 1];
+	nmbtree_leaf *lnode, *lleft;
+	nmbtree_inner *inode, *ileft;
+	if (node->leaf) {
+		lnode = (nmbtree_leaf*) node;
+		lleft = (nmbtree_leaf*) left;
+		memmove(&lnode->data[1], &lnode->data[0], node->count * sizeof(void*));
+		lnode->data[0] = lleft->data[--left->count];
+		parent->keys[i - 1] = lnode->data[0];
+	} else {
+		inode = (nmbtree_inner*) node;
+		ileft = (nmbtree_inner*) left;
+		memmove(&inode->keys[1], &inode->keys[0], node->count * sizeof(void*));
+		memmove(&inode->children[1], &inode->children[0],
+		        (node->count + 1) * sizeof(nmbtree_node*));
+		inode->keys[0] = parent->keys[i - 1];
+		inode->children[0] = ileft->children[left->count];
+		parent->keys[i - 1] = ileft->keys[--left->count];
+	}
+	node->count++;
+}
+
+/**
+ * THIS FUNCTION IS PRIVATE.
+ * Moves the first element (or child) of 'children[i + 1]' to the
+ * end of 'children[i]'.
+ **/
+static void nmbtree_borrow_right(nmbtree_inner *parent, unsigned int i)
+{
+	nmbtree_node *node = parent->children[i], *right = parent->children[i + 1];
+	nmbtree_leaf *lnode, *lright;
+	nmbtree_inner *inode, *iright;
+	if (node->leaf) {
+		lnode = (nmbtree_leaf*) node;
+		lright = (nmbtree_leaf*) right;
+		lnode->data[node->count] = lright->data[0];
+		memmove(&lright->data[0], &lright->data[1], (right->count - 1) * sizeof(void*));
+		parent->keys[i] = lright->data[0];
+	} else {
+		inode = (nmbtree_inner*) node;
+		iright = (nmbtree_inner*) right;
+		inode->keys[node->count] = parent->keys[i];
+		inode->children[node->count + 1] = iright->children[0];
+		parent->keys[i] = iright->keys[0];
+		memmove(&iright->keys[0], &iright->keys[1], (right->count - 1) * sizeof(void*));
+		memmove(&iright->children[0], &iright->children[1],
+		        right->count * sizeof(nmbtree_node*));
+	}
+	node->count++;
+	right->count--;
+}
+
+/**
+ * THIS FUNCTION IS PRIVATE.
+ * Merges 'children[i + 1]' into 'children[i]', and removes it
+ * (and 'keys[i]') from 'parent'.
+ **/
+static void nmbtree_merge(nmbtree_inner *parent, unsigned int i)
+{
+	nmbtree_node *node = parent->children[i], *right = parent->children[i + 1];
+	nmbtree_leaf *lnode, *lright;
+	nmbtree_inner *inode, *iright;
+	if (node->leaf) {
+		lnode = (nmbtree_leaf*) node;
+		lright = (nmbtree_leaf*) right;
+		memcpy(&lnode->data[node->count], lright->data, right->count * sizeof(void*));
+		node->count += right->count;
+		lnode->next = lright->next;
+	} else {
+		inode = (nmbtree_inner*) node;
+		iright = (nmbtree_inner*) right;
+		inode->keys[node->count] = parent->keys[i];
+		memcpy(&inode->keys[node->count + 1], iright->keys, right->count * sizeof(void*));
+		memcpy(&inode->children[node->count + 1], iright->children,
+		       (right->count + 1) * sizeof(nmbtree_node*));
+		node->count += right->count + 1;
+	}
+	free(right);
+	memmove(&parent->keys[i], &parent->keys[i + 1],
+	        (parent->hdr.count - i - 1) * sizeof(void*));
+	memmove(&parent->children[i + 1], &parent->children[i + 2],
+	        (parent->hdr.count - i - 1) * sizeof(nmbtree_node*));
+	parent->hdr.count--;
+}
+
+/**
+ * Removes the element equal (by 'tree->cmp') to 'data' from
+ * the tree, and returns it. Nodes left less than half full borrow
+ * from or are merged with a sibling.
+ *
+ * RETURNS:
+ * NULL				If there is no such element (or tree is NULL,
+ * 					tree->cmp is NULL).
+ * The removed element.
+ **/
+void *nmbtree_remove(nmbtree *tree, const void *data)
+{
+	nmbtree_inner *path[NMBTREE_MAX_HEIGHT];
+	unsigned int index[NMBTREE_MAX_HEIGHT];
+	nmbtree_inner *parent;
+	nmbtree_leaf *leaf;
+	nmbtree_node *node, *root;
+	unsigned int pos, i, min;
+	void *rdata;
+	int depth, d;
+	if (tree == NULL || tree->cmp == NULL || tree->root == NULL) {
+		return NULL;
+	}
+	leaf = nmbtree_descend(tree, data, path, index, &depth);
+	pos = nmbtree_leaf_bound(tree, leaf, data, 0);
+	if (pos >= leaf->hdr.count || tree->cmp(data, leaf->data[pos]) != 0) {
+		return NULL;
+	}
+	rdata = leaf->data[pos];
+	memmove(&leaf->data[pos], &leaf->data[pos + 1],
+	        (leaf->hdr.count - pos - 1) * sizeof(void*));
+	leaf->hdr.count--;
+	tree->size--;
+	/* The smallest element of a leaf may be the key separating it
+	 * from its left neighbour, in the deepest ancestor where the
+	 * path doesn't take the leftmost child */
+	if (pos == 0 && leaf->hdr.count > 0) {
+		for (d = depth - 1; d >= 0; d--) {
+			if (index[d] > 0) {
+				if (path[d]->keys[index[d] - 1] == rdata) {
+					path[d]->keys[index[d] - 1] = leaf->data[0];
+				}
+				break;
+			}
+		}
+	}
+	node = &leaf->hdr;
+	for (d = depth - 1; d >= 0; d--) {
+		min = node->leaf ? NMBTREE_MIN_LEAF : NMBTREE_MIN_KEYS;
+		if (node->count >= min) {
+			break;
+		}
+		parent = path[d];
+		i = index[d];
+		if (i > 0 && parent->children[i - 1]->count > min) {
+			nmbtree_borrow_left(parent, i);
+		} else if (i < parent->hdr.count && parent->children[i + 1]->count > min) {
+			nmbtree_borrow_right(parent, i);
+		} else if (i > 0) {
+			nmbtree_merge(parent, i - 1);
+		} else {
+			nmbtree_merge(parent, i);
+		}
+		node = &parent->hdr;
+	}
+	root = tree->root;
+	if (root->count == 0) {
+		if (root->leaf) {
+			tree->root = NULL;
+			tree->first = NULL;
+		} else {
+			tree->root = ((nmbtree_inner*) root)->children[0];
+		}
+		free(root);
+	}
+	return rdata;
+}
+
+/**
+ * Fills an empty tree with the elements of 'vect', which must be
+ * sorted (strictly increasing by 'tree->cmp'). The tree is built
+ * bottom-up in O(n), with nodes as full as possible, instead of
+ * through 'n' insertions.
+ *
+ * The data pointers are copied: the tree and the vector then share
+ * the data, only one of them should be freed with its data.
+ *
+ * RETURNS:
+ * 0				If operation was succesful.
+ * -1				If tree or vect are NULL, tree->cmp is NULL,
+ * 					the tree isn't empty, 'vect' isn't sorted or
+ * 					memory allocation fails (the tree is not
+ * 					modified).
+ **/
+int nmbtree_load(nmbtree *tree, nmvect *vect)
+{
+	nmbtree_node **nodes = NULL;
+	void **mins = NULL;
+	nmbtree_leaf *leaf, *prev = NULL;
+	nmbtree_inner *inner;
+	unsigned int n, count, up, total, i, j, k, take;
+	if (tree == NULL || tree->cmp == NULL || vect == NULL || tree->size != 0) {
+		return (-1);
+	}
+	n = nmvect_size(vect);
+	for (i = 1; i < n; i++) {
+		if (tree->cmp(nmvect_get(vect, i - 1), nmvect_get(vect, i)) >= 0) {
+			return (-1);
+		}
+	}
+	if (n == 0) {
+		return (0);
+	}
+	/* Allocate all the nodes first: leaves in 'nodes[0, count)',
+	 * inner nodes after them */
+	count = (n + NMBTREE_FANOUT - 1) / NMBTREE_FANOUT;
+	for (total = count, up = count; up > 1; total += up) {
+		up = (up + NMBTREE_FANOUT - 1) / NMBTREE_FANOUT;
+	}
+	nodes = malloc(total * sizeof(*nodes));
+	mins = malloc(count * sizeof(*mins));
+	if (nodes == NULL || mins == NULL) {
+		free(nodes);
+		free(mins);
+		return (-1);
+	}
+	for (i = 0; i < total; i++) {
+		nodes[i] = (i < count) ? (nmbtree_node*) nmbtree_leaf_alloc() :
+		           (nmbtree_node*) nmbtree_inner_alloc();
+		if (nodes[i] == NULL) {
+			while (i > 0) {
+				free(nodes[--i]);
+			}
+			free(nodes);
+			free(mins);
+			return (-1);
+		}
+	}
+	/* Leaves: the elements spread evenly, so every leaf is at
+	 * least half full */
+	for (i = 0, k = 0; i < count; i++) {
+		leaf = (nmbtree_leaf*) nodes[i];
+		take = n / count + ((i < n % count) ? 1 : 0);
+		for (j = 0; j < take; j++) {
+			leaf->data[j] = nmvect_get(vect, k++);
+		}
+		leaf->hdr.count = take;
+		if (prev != NULL) {
+			prev->next = leaf;
+		}
+		prev = leaf;
+		mins[i] = leaf->data[0];
+	}
+	tree->first = (nmbtree_leaf*) nodes[0];
+	/* Inner levels, built from 'nodes[0, count)' (the level below,
+	 * compacted at the front of 'nodes') with the spare nodes */
+	total = count;
+	while (count > 1) {
+		up = (count + NMBTREE_FANOUT - 1) / NMBTREE_FANOUT;
+		for (i = 0, k = 0; i < up; i++) {
+			inner = (nmbtree_inner*) nodes[total + i];
+			take = count / up + ((i < count % up) ? 1 : 0);
+			inner->children[0] = nodes[k];
+			for (j = 1; j < take; j++) {
+				inner->keys[j - 1] = mins[k + j];
+				inner->children[j] = nodes[k + j];
+			}
+			inner->hdr.count = take - 1;
+			mins[i] = mins[k];
+			k += take;
+		}
+		for (i = 0; i < up; i++) {
+			nodes[i] = nodes[total + i];
+		}
+		total += up;
+		count = up;
+	}
+	tree->root = nodes[0];
+	tree->size = n;
+	free(nodes);
+	free(mins);
+	return (0);
+}
+
+/**
+ * THIS FUNCTION IS PRIVATE.
+ * Points 'iter' at 'leaf->data[pos]', moving on to the next leaf
+ * if 'pos' is past the end of 'leaf'.
+ **/
+static int nmbtree_iter_set(nmbtree_iter *iter, nmbtree_leaf *leaf, unsigned int pos)
+{
+	if (leaf != NULL && pos >= leaf->hdr.count) {
+		leaf = leaf->next;
+		pos = 0;
+	}
+	iter->leaf = leaf;
+	iter->pos = pos;
+	return (leaf == NULL) ? (-1) : (0);
+}
+
+/**
+ * Points 'iter' at the smallest element of the tree.
+ *
+ * Range scans walk the linked leaves with 'nmbtree_iter_next':
+ *
+ *	for (rc = nmbtree_lower_bound(t, lo, &it); rc == 0 &&
+ *	        cmp(nmbtree_iter_get(&it), hi) < 0; rc = nmbtree_iter_next(&it))
+ *
+ * RETURNS:
+ * 0				If 'iter' points to an element.
+ * -1				If the tree is empty (or tree, iter are NULL).
+ **/
+int nmbtree_first(nmbtree *tree, nmbtree_iter *iter)
+{
+	if (tree == NULL || iter == NULL) {
+		return (-1);
+	}
+	return nmbtree_iter_set(iter, tree->first, 0);
+}
+
+/**
+ * Points 'iter' at the smallest element not less than 'data'.
+ *
+ * RETURNS:
+ * 0				If 'iter' points to an element.
+ * -1				If there is none (or tree, iter are NULL,
+ * 					tree->cmp is NULL).
+ **/
+int nmbtree_lower_bound(nmbtree *tree, const void *data, nmbtree_iter *iter)
+{
+	nmbtree_leaf *leaf;
+	if (tree == NULL || tree->cmp == NULL || iter == NULL) {
+		return (-1);
+	}
+	if (tree->root == NULL) {
+		return nmbtree_iter_set(iter, NULL, 0);
+	}
+	leaf = nmbtree_descend(tree, data, NULL, NULL, NULL);
+	return nmbtree_iter_set(iter, leaf, nmbtree_leaf_bound(tree, leaf, data, 0));
+}
+
+/**
+ * Points 'iter' at the smallest element greater than 'data'.
+ *
+ * RETURNS:
+ * 0				If 'iter' points to an element.
+ * -1				If there is none (or tree, iter are NULL,
+ * 					tree->cmp is NULL).
+ **/
+int nmbtree_upper_bound(nmbtree *tree, const void *data, nmbtree_iter *iter)
+{
+	nmbtree_leaf *leaf;
+	if (tree == NULL || tree->cmp == NULL || iter == NULL) {
+		return (-1);
+	}
+	if (tree->root == NULL) {
+		return nmbtree_iter_set(iter, NULL, 0);
+	}
+	leaf = nmbtree_descend(tree, data, NULL, NULL, NULL);
+	return nmbtree_iter_set(iter, leaf, nmbtree_leaf_bound(tree, leaf, data, 1));
+}
+
+/**
+ * Moves 'iter' to the next element, in order.
+ *
+ * RETURNS:
+ * 0				If 'iter' points to an element.
+ * -1				If it moved past the last element (or iter is
+ * 					NULL, or already past the end).
+ **/
+int nmbtree_iter_next(nmbtree_iter *iter)
+{
+	if (iter == NULL || iter->leaf == NULL) {
+		return (-1);
+	}
+	return nmbtree_iter_set(iter, iter->leaf, iter->pos + 1);
+}
+
+/**
+ * Returns the element 'iter' points to (NULL if iter is NULL or
+ * past the end).
+ **/
+void *nmbtree_iter_get(nmbtree_iter *iter)
+{
+	if (iter == NULL || iter->leaf == NULL) {
+		return NULL;
+	}
+	return ((nmbtree_leaf*) iter->leaf)->data[iter->pos];
+}
+
+/**
+ * Returns the number of elements of the tree (0 if tree is NULL).
+ **/
+unsigned int nmbtree_size(nmbtree *tree)
+{
+	return (tree == NULL) ? 0 : tree->size;
+}
@@ -0,0 +1,48 @@
+#ifndef __NM__BTREE__H__
+#define __NM__BTREE__H__
+#include "nmaux.h"
+#include "nmvect.h"
+
+/* Maximum number of children of an inner node, and of elements of
+ * a leaf. With 8 bytes pointers a leaf takes NMBTREE_FANOUT / 8
+ * cache lines (plus a header); 32 keeps a search to ~2 node visits
+ * per thousand-fold growth of the tree. */
+#ifndef NMBTREE_FANOUT
+#define NMBTREE_FANOUT 32
+#endif
+
+#if NMBTREE_FANOUT < 4
+#error "NMBTREE_FANOUT must be at least 4"
+#endif
+
+/* Maximum height of the tree (a tree of height 32 holds more than
+ * 2^32 elements for any fan-out >= 4). */
+#define NMBTREE_MAX_HEIGHT 32
+
+typedef struct nmbtree_s nmbtree;
+
+/* Position of an element in the tree, valid until the tree is
+ * modified. */
+typedef struct nmbtree_iter_s {
+	void *leaf;
+	unsigned int pos;
+} nmbtree_iter;
+
+nmbtree *nmbtree_alloc(void (*destructor)(void *data),
+                       int (*cmp)(const void *e1, const void *e2));
+int nmbtree_free(nmbtree *tree, nm_free_mode mode);
+
+int nmbtree_insert(nmbtree *tree, const void *data);
+void *nmbtree_find(nmbtree *tree, const void *data);
+void *nmbtree_remove(nmbtree *tree, const void *data);
+int nmbtree_load(nmbtree *tree, nmvect *vect);
+
+int nmbtree_first(nmbtree *tree, nmbtree_iter *iter);
+int nmbtree_lower_bound(nmbtree *tree, const void *data, nmbtree_iter *iter);
+int nmbtree_upper_bound(nmbtree *tree, const void *data, nmbtree_iter *iter);
+int nmbtree_iter_next(nmbtree_iter *iter);
+void *nmbtree_iter_get(nmbtree_iter *iter);
+
+unsigned int nmbtree_size(nmbtree *tree);
+
+#endif
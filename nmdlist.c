@@ -0,0 +1,360 @@
+#include <stdlib.h>
+#include "nmdlist.h"
+
+struct nmdlist_element_s {
+	void *data;
+	struct nmdlist_element_s *prev;
+	struct nmdlist_element_s *next;
+};
+
+struct nmdlist_s {
+	void (*destructor)(void *data);
+	unsigned int size;
+	nmdlist_element *head;
+	nmdlist_element *tail;
+};
+
+/**
+ * Allocates memory for a new doubly linked list.
+ *
+ * Unlike 'nmlist' every element knows its predecessor, so an
+ * element can be removed or moved in O(1) given only a pointer to
+ * it, and the list can be walked backwards from its tail. A hash
+ * table mapping keys to elements plus 'nmdlist_move_head' /
+ * 'nmdlist_remove_tail' make an O(1) LRU cache.
+ *
+ * INPUT:
+ * 'destructor'		Destructor for 'data' being hold by the list.
+ *
+ * RETURNS:
+ * NULL				If memory allocation fails.
+ * A new list.
+ **/
+nmdlist *nmdlist_alloc(void (*destructor)(void *data))
+{
+	nmdlist *list = NULL;
+	if ((list = calloc(1, sizeof(*list))) == NULL) {
+		return NULL;
+	}
+	list->destructor = destructor;
+	list->size = 0;
+	list->head = NULL;
+	list->tail = NULL;
+	return list;
+}
+
+/**
+ * De-allocates memory for the list, and the data it holds.
+ *
+ * RETURNS:
+ * 0				If list was succesfuly de-allocated.
+ * -1				If something went wrong (list is NULL,
+ * 					destructor is NULL).
+ **/
+int nmdlist_free(nmdlist *list)
+{
+	void *data;
+	if (list == NULL || list->destructor == NULL) {
+		return (-1);
+	}
+	while (list->size > 0) {
+		if ((data = nmdlist_remove_head(list)) != NULL) {
+			list->destructor(data);
+		}
+	}
+	free(list);
+	return (0);
+}
+
+/**
+ * THIS FUNCTION IS PRIVATE.
+ * Links the detached 'new_e' between 'prev' and 'next' (either
+ * may be NULL, for the ends of the list).
+ **/
+static void nmdlist_link(nmdlist *list, nmdlist_element *prev,
+                         nmdlist_element *new_e, nmdlist_element *next)
+{
+	new_e->prev = prev;
+	new_e->next = next;
+	if (prev != NULL) {
+		prev->next = new_e;
+	} else {
+		list->head = new_e;
+	}
+	if (next != NULL) {
+		next->prev = new_e;
+	} else {
+		list->tail = new_e;
+	}
+	list->size++;
+}
+
+/**
+ * THIS FUNCTION IS PRIVATE.
+ * Detaches 'element' from the list, without freeing it.
+ **/
+static void nmdlist_unlink(nmdlist *list, nmdlist_element *element)
+{
+	if (element->prev != NULL) {
+		element->prev->next = element->next;
+	} else {
+		list->head = element->next;
+	}
+	if (element->next != NULL) {
+		element->next->prev = element->prev;
+	} else {
+		list->tail = element->prev;
+	}
+	list->size--;
+}
+
+/**
+ * Inserts a new element after 'element'.
+ *
+ * INPUT:
+ * 'list'		The list.
+ * 'element'	We insert our new element after this one (if
+ * 				NULL the new element becomes the head).
+ * 'data'		Data to be inserted into the list.
+ *
+ * RETURNS:
+ * 0			If insertion was succesful.
+ * -1			If list is NULL or memory allocation fails.
+ **/
+int nmdlist_insert_next(nmdlist *list, nmdlist_element *element, const void *data)
+{
+	nmdlist_element *new_e = NULL;
+	if (list == NULL || (new_e = calloc(1, sizeof(*new_e))) == NULL) {
+		return (-1);
+	}
+	new_e->data = (void*) data;
+	if (element == NULL) {
+		nmdlist_link(list, NULL, new_e, list->head);
+	} else {
+		nmdlist_link(list, element, new_e, element->next);
+	}
+	return (0);
+}
+
+/**
+ * Inserts a new element before 'element'.
+ *
+ * INPUT:
+ * 'list'		The list.
+ * 'element'	We insert our new element before this one (if
+ * 				NULL the new element becomes the tail).
+ * 'data'		Data to be inserted into the list.
+ *
+ * RETURNS:
+ * 0			If insertion was succesful.
+ * -1			If list is NULL or memory allocation fails.
+ **/
+int nmdlist_insert_prev(nmdlist *list, nmdlist_element *element, const void *data)
+{
+	nmdlist_element *new_e = NULL;
+	if (list == NULL || (new_e = calloc(1, sizeof(*new_e))) == NULL) {
+		return (-1);
+	}
+	new_e->data = (void*) data;
+	if (element == NULL) {
+		nmdlist_link(list, list->tail, new_e, NULL);
+	} else {
+		nmdlist_link(list, element->prev, new_e, element);
+	}
+	return (0);
+}
+
+/**
+ * Removes 'element' from the list in O(1). The element is freed,
+ * its data is returned.
+ *
+ * RETURNS:
+ * The data hold by the element.
+ * NULL			If list or element are NULL.
+ **/
+void *nmdlist_remove(nmdlist *list, nmdlist_element *element)
+{
+	void *data;
+	if (list == NULL || element == NULL) {
+		return NULL;
+	}
+	nmdlist_unlink(list, element);
+	data = element->data;
+	free(element);
+	return data;
+}
+
+/**
+ * Removes the head of the list.
+ *
+ * RETURNS:
+ * The data hold by the head.
+ * NULL			If list is NULL or empty.
+ **/
+void *nmdlist_remove_head(nmdlist *list)
+{
+	return (list == NULL) ? NULL : nmdlist_remove(list, list->head);
+}
+
+/**
+ * Removes the tail of the list in O(1).
+ *
+ * RETURNS:
+ * The data hold by the tail.
+ * NULL			If list is NULL or empty.
+ **/
+void *nmdlist_remove_tail(nmdlist *list)
+{
+	return (list == NULL) ? NULL : nmdlist_remove(list, list->tail);
+}
+
+/**
+ * Removes 'element' and de-allocates its data.
+ *
+ * RETURNS:
+ * 0			If operation was succesful.
+ * -1			If list or element are NULL or the list has no
+ * 				destructor.
+ **/
+int nmdlist_purge(nmdlist *list, nmdlist_element *element)
+{
+	void *data;
+	if (list == NULL || element == NULL || list->destructor == NULL) {
+		return (-1);
+	}
+	if ((data = nmdlist_remove(list, element)) != NULL) {
+		list->destructor(data);
+	}
+	return (0);
+}
+
+/**
+ * Moves 'element' (already in the list) to the head, in O(1).
+ *
+ * RETURNS:
+ * 0			If operation was succesful.
+ * -1			If list or element are NULL.
+ **/
+int nmdlist_move_head(nmdlist *list, nmdlist_element *element)
+{
+	if (list == NULL || element == NULL) {
+		return (-1);
+	}
+	if (element != list->head) {
+		nmdlist_unlink(list, element);
+		nmdlist_link(list, NULL, element, list->head);
+	}
+	return (0);
+}
+
+/**
+ * Moves 'element' (already in the list) to the tail, in O(1).
+ *
+ * RETURNS:
+ * 0			If operation was succesful.
+ * -1			If list or element are NULL.
+ **/
+int nmdlist_move_tail(nmdlist *list, nmdlist_element *element)
+{
+	if (list == NULL || element == NULL) {
+		return (-1);
+	}
+	if (element != list->tail) {
+		nmdlist_unlink(list, element);
+		nmdlist_link(list, list->tail, element, NULL);
+	}
+	return (0);
+}
+
+/**
+ * Returns the number of elements of the list (0 if list is NULL).
+ **/
+unsigned int nmdlist_size(nmdlist *list)
+{
+	return (list == NULL) ? 0 : list->size;
+}
+
+/**
+ * Returns the first element of the list (NULL if list is NULL
+ * or empty).
+ **/
+nmdlist_element *nmdlist_head(nmdlist *list)
+{
+	return (list == NULL) ? NULL : list->head;
+}
+
+/**
+ * Returns the last element of the list (NULL if list is NULL
+ * or empty).
+ **/
+nmdlist_element *nmdlist_tail(nmdlist *list)
+{
+	return (list == NULL) ? NULL : list->tail;
+}
+
+/**
+ * Returns the element following 'element' (NULL at the tail).
+ **/
+nmdlist_element *nmdlist_next(nmdlist_element *element)
+{
+	return (element == NULL) ? NULL : element->next;
+}
+
+/**
+ * Returns the element preceding 'element' (NULL at the head).
+ **/
+nmdlist_element *nmdlist_prev(nmdlist_element *element)
+{
+	return (element == NULL) ? NULL : element->prev;
+}
+
+/**
+ * Returns the 'index'th element, walking from the nearest end
+ * of the list.
+ *
+ * RETURNS:
+ * NULL			If list is NULL or index is out of bounds.
+ * The element.
+ **/
+nmdlist_element *nmdlist_index(nmdlist *list, unsigned int index)
+{
+	nmdlist_element *element;
+	unsigned int i;
+	if (list == NULL || index >= list->size) {
+		return NULL;
+	}
+	if (index < list->size / 2) {
+		for (i = 0, element = list->head; i < index; i++) {
+			element = element->next;
+		}
+	} else {
+		for (i = list->size - 1, element = list->tail; i > index; i--) {
+			element = element->prev;
+		}
+	}
+	return element;
+}
+
+/**
+ * Returns the data hold by 'element' (NULL if element is NULL).
+ **/
+void *nmdlist_get_data(nmdlist_element *element)
+{
+	return (element == NULL) ? NULL : element->data;
+}
+
+/**
+ * Updates the data hold by 'element'.
+ *
+ * RETURNS:
+ * 0			If operation was succesful.
+ * -1			If element is NULL.
+ **/
+int nmdlist_set_data(nmdlist_element *element, const void *data)
+{
+	if (element == NULL) {
+		return (-1);
+	}
+	element->data = (void*) data;
+	return (0);
+}
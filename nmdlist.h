@@ -0,0 +1,31 @@
+#ifndef __NM__DLIST__H__
+#define __NM__DLIST__H__
+
+typedef struct nmdlist_element_s nmdlist_element;
+typedef struct nmdlist_s nmdlist;
+
+nmdlist *nmdlist_alloc(void (*destructor)(void *data));
+int nmdlist_free(nmdlist *list);
+
+int nmdlist_insert_next(nmdlist *list, nmdlist_element *element, const void *data);
+int nmdlist_insert_prev(nmdlist *list, nmdlist_element *element, const void *data);
+
+void *nmdlist_remove(nmdlist *list, nmdlist_element *element);
+void *nmdlist_remove_head(nmdlist *list);
+void *nmdlist_remove_tail(nmdlist *list);
+int nmdlist_purge(nmdlist *list, nmdlist_element *element);
+
+int nmdlist_move_head(nmdlist *list, nmdlist_element *element);
+int nmdlist_move_tail(nmdlist *list, nmdlist_element *element);
+
+unsigned int nmdlist_size(nmdlist *list);
+nmdlist_element *nmdlist_head(nmdlist *list);
+nmdlist_element *nmdlist_tail(nmdlist *list);
+nmdlist_element *nmdlist_next(nmdlist_element *element);
+nmdlist_element *nmdlist_prev(nmdlist_element *element);
+nmdlist_element *nmdlist_index(nmdlist *list, unsigned int index);
+
+void *nmdlist_get_data(nmdlist_element *element);
+int nmdlist_set_data(nmdlist_element *element, const void *data);
+
+#endif
@@ -0,0 +1,364 @@
+#ifndef __NM__GEN__H__
+#define __NM__GEN__H__
+#include <stdlib.h>
+#include <string.h>
+
+/* Type specialized containers.
+ *
+ * The macros below stamp out a vector, a linked list or a heap of
+ * values of type 'T', with 'CMP' used directly where the generic
+ * containers call their 'cmp' function pointer. 'CMP(a, b)' takes two
+ * 'T' values and returns <0, 0, >0; it can be a macro or a (static
+ * inline) function, in both cases the compiler can inline it.
+ *
+ * Example:
+ *
+ *	#define INT_CMP(a, b) (((a) > (b)) - ((a) < (b)))
+ *	NMVECT_DEFINE(intvect, int, INT_CMP)
+ *
+ *	intvect *v = intvect_alloc(16);
+ *	intvect_append(v, 42);
+ *	if (intvect_contains(v, 42)) ...
+ *	intvect_free(v);
+ *
+ * All the generated functions are 'static inline', so a definition
+ * can be placed in a header and used by several translation units.
+ * The generic 'void*' containers remain the fallback for
+ * heterogeneous data or data owned through a destructor. */
+
+/* Vector of 'T': 'name##_alloc', 'name##_free', 'name##_append',
+ * 'name##_insert', 'name##_remove', 'name##_get', 'name##_set',
+ * 'name##_find', 'name##_contains', 'name##_size'. */
+#define NMVECT_DEFINE(name, T, CMP) \
+typedef struct name##_s { \
+	T *array; \
+	unsigned int size; \
+	unsigned int capacity; \
+} name; \
+\
+static inline name *name##_alloc(unsigned int icap) \
+{ \
+	name *vect = calloc(1, sizeof(*vect)); \
+	if (vect == NULL) { \
+		return NULL; \
+	} \
+	vect->capacity = (icap > 0) ? icap : 1; \
+	if ((vect->array = malloc(vect->capacity * sizeof(T))) == NULL) { \
+		free(vect); \
+		return NULL; \
+	} \
+	return vect; \
+} \
+\
+static inline int name##_free(name *vect) \
+{ \
+	if (vect == NULL) { \
+		return (-1); \
+	} \
+	free(vect->array); \
+	free(vect); \
+	return (0); \
+} \
+\
+static inline int name##_expand(name *vect) \
+{ \
+	unsigned int tmp_cap = vect->capacity * 3 / 2 + 1; \
+	T *tmp_array = realloc(vect->array, tmp_cap * sizeof(T)); \
+	if (tmp_array == NULL) { \
+		return (-1); \
+	} \
+	vect->array = tmp_array; \
+	vect->capacity = tmp_cap; \
+	return (0); \
+} \
+\
+static inline int name##_append(name *vect, T data) \
+{ \
+	if (vect->size == vect->capacity && name##_expand(vect) != 0) { \
+		return (-1); \
+	} \
+	vect->array[vect->size++] = data; \
+	return (0); \
+} \
+\
+static inline int name##_insert(name *vect, unsigned int index, T data) \
+{ \
+	if (index > vect->size || \
+	        (vect->size == vect->capacity && name##_expand(vect) != 0)) { \
+		return (-1); \
+	} \
+	memmove(&vect->array[index + 1], &vect->array[index], \
+	        (vect->size - index) * sizeof(T)); \
+	vect->array[index] = data; \
+	vect->size++; \
+	return (0); \
+} \
+\
+static inline int name##_remove(name *vect, unsigned int index, T *data) \
+{ \
+	if (index >= vect->size) { \
+		return (-1); \
+	} \
+	if (data != NULL) { \
+		*data = vect->array[index]; \
+	} \
+	vect->size--; \
+	memmove(&vect->array[index], &vect->array[index + 1], \
+	        (vect->size - index) * sizeof(T)); \
+	return (0); \
+} \
+\
+static inline T *name##_get(name *vect, unsigned int index) \
+{ \
+	return (index < vect->size) ? &vect->array[index] : NULL; \
+} \
+\
+static inline int name##_set(name *vect, unsigned int index, T data) \
+{ \
+	if (index >= vect->size) { \
+		return (-1); \
+	} \
+	vect->array[index] = data; \
+	return (0); \
+} \
+\
+static inline int name##_find(const name *vect, T data) \
+{ \
+	unsigned int i; \
+	for (i = 0; i < vect->size; i++) { \
+		if (CMP(vect->array[i], data) == 0) { \
+			return (int) i; \
+		} \
+	} \
+	return (-1); \
+} \
+\
+static inline int name##_contains(const name *vect, T data) \
+{ \
+	return name##_find(vect, data) >= 0; \
+} \
+\
+static inline unsigned int name##_size(const name *vect) \
+{ \
+	return vect->size; \
+}
+
+/* Singly linked list of 'T': 'name##_alloc', 'name##_free',
+ * 'name##_insert_next', 'name##_remove_next', 'name##_push_back',
+ * 'name##_find', 'name##_contains', 'name##_size'. Elements are
+ * 'name##_element' with public 'data' and 'next' fields. */
+#define NMLIST_DEFINE(name, T, CMP) \
+typedef struct name##_element_s { \
+	T data; \
+	struct name##_element_s *next; \
+} name##_element; \
+\
+typedef struct name##_s { \
+	unsigned int size; \
+	name##_element *head; \
+	name##_element *tail; \
+} name; \
+\
+static inline name *name##_alloc(void) \
+{ \
+	return calloc(1, sizeof(name)); \
+} \
+\
+static inline int name##_free(name *list) \
+{ \
+	name##_element *element, *next; \
+	if (list == NULL) { \
+		return (-1); \
+	} \
+	for (element = list->head; element != NULL; element = next) { \
+		next = element->next; \
+		free(element); \
+	} \
+	free(list); \
+	return (0); \
+} \
+\
+static inline int name##_insert_next(name *list, name##_element *element, T data) \
+{ \
+	name##_element *new_e = malloc(sizeof(*new_e)); \
+	if (new_e == NULL) { \
+		return (-1); \
+	} \
+	new_e->data = data; \
+	if (element == NULL) { \
+		new_e->next = list->head; \
+		list->head = new_e; \
+	} else { \
+		new_e->next = element->next; \
+		element->next = new_e; \
+	} \
+	if (new_e->next == NULL) { \
+		list->tail = new_e; \
+	} \
+	list->size++; \
+	return (0); \
+} \
+\
+static inline int name##_remove_next(name *list, name##_element *element, T *data) \
+{ \
+	name##_element *old_e; \
+	name##_element **link = (element == NULL) ? &list->head : &element->next; \
+	if ((old_e = *link) == NULL) { \
+		return (-1); \
+	} \
+	if (data != NULL) { \
+		*data = old_e->data; \
+	} \
+	*link = old_e->next; \
+	if (old_e == list->tail) { \
+		list->tail = element; \
+	} \
+	free(old_e); \
+	list->size--; \
+	return (0); \
+} \
+\
+static inline int name##_push_back(name *list, T data) \
+{ \
+	return name##_insert_next(list, list->tail, data); \
+} \
+\
+static inline name##_element *name##_find(const name *list, T data) \
+{ \
+	name##_element *element; \
+	for (element = list->head; element != NULL; element = element->next) { \
+		if (CMP(element->data, data) == 0) { \
+			return element; \
+		} \
+	} \
+	return NULL; \
+} \
+\
+static inline int name##_contains(const name *list, T data) \
+{ \
+	return name##_find(list, data) != NULL; \
+} \
+\
+static inline unsigned int name##_size(const name *list) \
+{ \
+	return list->size; \
+}
+
+/* Binary min-heap of 'T' (the smallest by 'CMP' on top):
+ * 'name##_alloc', 'name##_free', 'name##_push', 'name##_pop',
+ * 'name##_peek', 'name##_heapify', 'name##_size'. */
+#define NMHEAP_DEFINE(name, T, CMP) \
+typedef struct name##_s { \
+	T *array; \
+	unsigned int size; \
+	unsigned int capacity; \
+} name; \
+\
+static inline name *name##_alloc(unsigned int icap) \
+{ \
+	name *heap = calloc(1, sizeof(*heap)); \
+	if (heap == NULL) { \
+		return NULL; \
+	} \
+	heap->capacity = (icap > 0) ? icap : 1; \
+	if ((heap->array = malloc(heap->capacity * sizeof(T))) == NULL) { \
+		free(heap); \
+		return NULL; \
+	} \
+	return heap; \
+} \
+\
+static inline int name##_free(name *heap) \
+{ \
+	if (heap == NULL) { \
+		return (-1); \
+	} \
+	free(heap->array); \
+	free(heap); \
+	return (0); \
+} \
+\
+static inline void name##_sift_down(name *heap, unsigned int i, T data) \
+{ \
+	unsigned int child; \
+	while ((child = 2 * i + 1) < heap->size) { \
+		if (child + 1 < heap->size && \
+		        CMP(heap->array[child + 1], heap->array[child]) < 0) { \
+			child++; \
+		} \
+		if (CMP(heap->array[child], data) >= 0) { \
+			break; \
+		} \
+		heap->array[i] = heap->array[child]; \
+		i = child; \
+	} \
+	heap->array[i] = data; \
+} \
+\
+static inline int name##_push(name *heap, T data) \
+{ \
+	unsigned int i, parent; \
+	T *tmp_array; \
+	if (heap->size == heap->capacity) { \
+		tmp_array = realloc(heap->array, (heap->capacity * 3 / 2 + 1) * sizeof(T)); \
+		if (tmp_array == NULL) { \
+			return (-1); \
+		} \
+		heap->array = tmp_array; \
+		heap->capacity = heap->capacity * 3 / 2 + 1; \
+	} \
+	for (i = heap->size++; i > 0; i = parent) { \
+		parent = (i - 1) / 2; \
+		if (CMP(data, heap->array[parent]) >= 0) { \
+			break; \
+		} \
+		heap->array[i] = heap->array[parent]; \
+	} \
+	heap->array[i] = data; \
+	return (0); \
+} \
+\
+static inline int name##_pop(name *heap, T *data) \
+{ \
+	if (heap->size == 0) { \
+		return (-1); \
+	} \
+	if (data != NULL) { \
+		*data = heap->array[0]; \
+	} \
+	if (--heap->size > 0) { \
+		name##_sift_down(heap, 0, heap->array[heap->size]); \
+	} \
+	return (0); \
+} \
+\
+static inline T *name##_peek(name *heap) \
+{ \
+	return (heap->size > 0) ? &heap->array[0] : NULL; \
+} \
+\
+static inline int name##_heapify(name *heap, const T *array, unsigned int n) \
+{ \
+	unsigned int i; \
+	T *tmp_array; \
+	if (n > heap->capacity) { \
+		if ((tmp_array = realloc(heap->array, n * sizeof(T))) == NULL) { \
+			return (-1); \
+		} \
+		heap->array = tmp_array; \
+		heap->capacity = n; \
+	} \
+	memcpy(heap->array, array, n * sizeof(T)); \
+	heap->size = n; \
+	for (i = n / 2; i > 0; i--) { \
+		name##_sift_down(heap, i - 1, heap->array[i - 1]); \
+	} \
+	return (0); \
+} \
+\
+static inline unsigned int name##_size(const name *heap) \
+{ \
+	return heap->size; \
+}
+
+#endif
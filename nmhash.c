@@ -0,0 +1,539 @@
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "nmhash.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+/* Open addressing hash table with SwissTable-like metadata.
+ *
+ * Every slot has a control byte: EMPTY, DELETED (tombstone) or, for
+ * a full slot, the low 7 bits of the element hash ('h2'). Slots are
+ * probed by groups of NMHASH_GROUP: the control bytes of a group are
+ * matched against 'h2' all at once (SSE2 when available) and 'cmp' is
+ * only called for the candidates. Groups are visited in triangular
+ * order, which covers all of them as their number is a power of two.
+ *
+ * When the table gets too loaded a new one is allocated and the
+ * elements are moved over incrementally: every insertion / removal
+ * migrates NMHASH_MIGRATE old slots, while lookups search both tables.
+ * That way no single operation pays for re-hashing the whole table. */
+#define NMHASH_GROUP 16
+#define NMHASH_MIGRATE 64
+#define NMHASH_EMPTY ((unsigned char) 0x80)
+#define NMHASH_DELETED ((unsigned char) 0xFE)
+
+typedef struct nmhash_table_s {
+	unsigned char *ctrl;
+	void **slots;
+	size_t mask;
+	size_t size;
+	size_t tombs;
+} nmhash_table;
+
+struct nmhash_s {
+	size_t (*hash)(const void *data);
+	void (*destructor)(void *data);
+	int (*cmp)(const void *e1, const void *e2);
+	nmhash_table cur;
+	nmhash_table old;
+	size_t migrated;
+};
+
+/**
+ * THIS FUNCTION IS PRIVATE.
+ * Returns a bitmask of the bytes in 'group' equal to 'h2'.
+ **/
+static unsigned int nmhash_match(const unsigned char *group, unsigned char h2)
+{
+#if defined(__SSE2__)
+	__m128i ctrl = _mm_loadu_si128((const __m128i*) group);
+	return (unsigned int) _mm_movemask_epi8(_mm_cmpeq_epi8(ctrl,
+	                                        _mm_set1_epi8((char) h2)));
+#else
+	unsigned int i, mask = 0;
+	for (i = 0; i < NMHASH_GROUP; i++) {
+		mask |= (unsigned int) (group[i] == h2) << i;
+	}
+	return mask;
+#endif
+}
+
+/**
+ * THIS FUNCTION IS PRIVATE.
+ * Returns a bitmask of the slots in 'group' that are not full
+ * (EMPTY and DELETED are the only control bytes with the high
+ * bit set).
+ **/
+static unsigned int nmhash_match_free(const unsigned char *group)
+{
+#if defined(__SSE2__)
+	return (unsigned int) _mm_movemask_epi8(_mm_loadu_si128((const __m128i*) group));
+#else
+	unsigned int i, mask = 0;
+	for (i = 0; i < NMHASH_GROUP; i++) {
+		mask |= (unsigned int) (group[i] >> 7) << i;
+	}
+	return mask;
+#endif
+}
+
+/**
+ * THIS FUNCTION IS PRIVATE.
+ * Returns the index of the lowest bit set in 'mask' (not 0).
+ **/
+static unsigned int nmhash_ctz(unsigned int mask)
+{
+#if defined(__GNUC__)
+	return (unsigned int) __builtin_ctz(mask);
+#else
+	unsigned int i = 0;
+	while ((mask & 1) == 0) {
+		mask >>= 1;
+		i++;
+	}
+	return i;
+#endif
+}
+
+/**
+ * THIS FUNCTION IS PRIVATE.
+ * Mixes the user supplied hash, so weak hashes (eg. the identity)
+ * spread over both the group index and 'h2'.
+ **/
+static uint64_t nmhash_mix(const nmhash *map, const void *data)
+{
+	uint64_t h = (uint64_t) map->hash(data);
+	h ^= h >> 33;
+	h *= 0xff51afd7ed558ccdULL;
+	h ^= h >> 33;
+	h *= 0xc4ceb9fe1a85ec53ULL;
+	h ^= h >> 33;
+	return h;
+}
+
+/**
+ * THIS FUNCTION IS PRIVATE.
+ * Allocates an empty table of 'cap' slots ('cap' is a power of
+ * two, multiple of NMHASH_GROUP).
+ **/
+static int nmhash_table_alloc(nmhash_table *table, size_t cap)
+{
+	if ((table->ctrl = malloc(cap)) == NULL) {
+		return (-1);
+	}
+	if ((table->slots = malloc(cap * sizeof(*table->slots))) == NULL) {
+		free(table->ctrl);
+		table->ctrl = NULL;
+		return (-1);
+	}
+	memset(table->ctrl, NMHASH_EMPTY, cap);
+	table->mask = cap - 1;
+	table->size = 0;
+	table->tombs = 0;
+	return (0);
+}
+
+/**
+ * THIS FUNCTION IS PRIVATE.
+ * De-allocates the memory used by a table.
+ **/
+static void nmhash_table_release(nmhash_table *table)
+{
+	free(table->ctrl);
+	free(table->slots);
+	table->ctrl = NULL;
+	table->slots = NULL;
+	table->size = 0;
+	table->tombs = 0;
+}
+
+/**
+ * THIS FUNCTION IS PRIVATE.
+ * Searches 'table' for an element equal to 'data'.
+ *
+ * RETURNS:
+ * The slot index, or -1 if the element isn't in the table.
+ **/
+static long nmhash_table_find(const nmhash *map, const nmhash_table *table,
+                              const void *data, uint64_t h)
+{
+	size_t gmask = table->mask / NMHASH_GROUP;
+	size_t g = (size_t) (h >> 7) & gmask, step = 0, idx;
+	unsigned int match;
+	const unsigned char *group;
+	for (;;) {
+		group = table->ctrl + g * NMHASH_GROUP;
+		match = nmhash_match(group, (unsigned char) (h & 0x7F));
+		while (match != 0) {
+			idx = g * NMHASH_GROUP + nmhash_ctz(match);
+			if (map->cmp(table->slots[idx], data) == 0) {
+				return (long) idx;
+			}
+			match &= match - 1;
+		}
+		if (nmhash_match(group, NMHASH_EMPTY) != 0 || step == gmask) {
+			return (-1);
+		}
+		step++;
+		g = (g + step) & gmask;
+	}
+}
+
+/**
+ * THIS FUNCTION IS PRIVATE.
+ * Stores 'data' in the first free slot of its probe sequence. The
+ * caller guarantees that 'data' isn't already in the table and that
+ * the table isn't full.
+ **/
+static void nmhash_table_place(nmhash_table *table, const void *data, uint64_t h)
+{
+	size_t gmask = table->mask / NMHASH_GROUP;
+	size_t g = (size_t) (h >> 7) & gmask, step = 0, idx;
+	unsigned int match;
+	while ((match = nmhash_match_free(table->ctrl + g * NMHASH_GROUP)) == 0) {
+		step++;
+		g = (g + step) & gmask;
+	}
+	idx = g * NMHASH_GROUP + nmhash_ctz(match);
+	if (table->ctrl[idx] == NMHASH_DELETED) {
+		table->tombs--;
+	}
+	table->ctrl[idx] = (unsigned char) (h & 0x7F);
+	table->slots[idx] = (void*) data;
+	table->size++;
+}
+
+/**
+ * THIS FUNCTION IS PRIVATE.
+ * Frees slot 'idx'. If its group still has an EMPTY slot no probe
+ * sequence can go past it, so the slot can become EMPTY again instead
+ * of a tombstone.
+ **/
+static void nmhash_table_clear(nmhash_table *table, size_t idx)
+{
+	const unsigned char *group = table->ctrl + (idx & ~(size_t) (NMHASH_GROUP - 1));
+	if (nmhash_match(group, NMHASH_EMPTY) != 0) {
+		table->ctrl[idx] = NMHASH_EMPTY;
+	} else {
+		table->ctrl[idx] = NMHASH_DELETED;
+		table->tombs++;
+	}
+	table->size--;
+}
+
+/**
+ * THIS FUNCTION IS PRIVATE.
+ * Moves up to 'n' slots of the old table into the current one,
+ * releasing the old table once it is empty.
+ **/
+static void nmhash_migrate(nmhash *map, size_t n)
+{
+	nmhash_table *old = &map->old;
+	size_t i;
+	while (old->ctrl != NULL && n-- > 0) {
+		if (old->size == 0 || map->migrated > old->mask) {
+			nmhash_table_release(old);
+			break;
+		}
+		i = map->migrated++;
+		if ((old->ctrl[i] & 0x80) == 0) {
+			nmhash_table_place(&map->cur, old->slots[i],
+			                   nmhash_mix(map, old->slots[i]));
+			old->ctrl[i] = NMHASH_DELETED;
+			old->size--;
+		}
+	}
+}
+
+/**
+ * THIS FUNCTION IS PRIVATE.
+ * Makes room for one more element in the current table.
+ *
+ * If the current table is more than 7/8 used (counting tombstones),
+ * a new table is started: twice as big, or the same size if the load
+ * is mostly tombstones. An unfinished migration is completed first.
+ *
+ * RETURNS:
+ * 0				If there is room for one more element.
+ * -1				If memory allocation failed.
+ **/
+static int nmhash_reserve(nmhash *map)
+{
+	nmhash_table next;
+	size_t cap = map->cur.mask + 1;
+	if (map->cur.size + map->cur.tombs + 1 <= cap - cap / 8) {
+		return (0);
+	}
+	if (map->old.ctrl != NULL) {
+		nmhash_migrate(map, (size_t) -1);
+		return nmhash_reserve(map);
+	}
+	if (map->cur.size >= (cap - cap / 8) / 2) {
+		cap *= 2;
+	}
+	if (nmhash_table_alloc(&next, cap) != 0) {
+		return (-1);
+	}
+	map->old = map->cur;
+	map->cur = next;
+	map->migrated = 0;
+	nmhash_migrate(map, NMHASH_MIGRATE);
+	return (0);
+}
+
+/**
+ * Allocates memory for a new hash table.
+ *
+ * The table holds 'data' pointers, like the other containers.
+ * To use it as a map store structures holding both key and
+ * value, and make 'hash' / 'cmp' only look at the key: lookups can
+ * then be done with a structure holding just the key.
+ *
+ * INPUT:
+ * 'icap'			Number of elements the table should hold
+ * 					before growing.
+ * 'hash'			Hash function for the elements. Equal elements
+ * 					(for 'cmp') must have equal hashes.
+ * 'destructor'		Function needed to free data held by the table.
+ * 'cmp'			Function needed to compare two elements
+ * 					(0 if they are equal).
+ *
+ * RETURNS:
+ * NULL				If memory allocation fails, 'hash' or 'cmp'
+ * 					are NULL.
+ * A new hash table.
+ **/
+nmhash *nmhash_alloc(unsigned int icap, size_t (*hash)(const void *data),
+                     void (*destructor)(void *data),
+                     int (*cmp)(const void *e1, const void *e2))
+{
+	nmhash *map = NULL;
+	size_t cap = NMHASH_GROUP;
+	if (hash == NULL || cmp == NULL) {
+		return NULL;
+	}
+	while (cap - cap / 8 < icap) {
+		cap *= 2;
+	}
+	if ((map = calloc(1, sizeof(*map))) == NULL) {
+		return NULL;
+	}
+	if (nmhash_table_alloc(&map->cur, cap) != 0) {
+		free(map);
+		return NULL;
+	}
+	map->hash = hash;
+	map->destructor = destructor;
+	map->cmp = cmp;
+	map->old.ctrl = NULL;
+	map->old.slots = NULL;
+	map->migrated = 0;
+	return map;
+}
+
+/**
+ * THIS FUNCTION IS PRIVATE.
+ * Calls the destructor for every element of 'table'.
+ **/
+static void nmhash_table_purge(nmhash_table *table, void (*destructor)(void *data))
+{
+	size_t i;
+	if (table->ctrl == NULL) {
+		return;
+	}
+	for (i = 0; i <= table->mask; i++) {
+		if ((table->ctrl[i] & 0x80) == 0 && table->slots[i] != NULL) {
+			destructor(table->slots[i]);
+		}
+	}
+}
+
+/**
+ * De-allocates memory for the hash table, and frees
+ * the data it holds.
+ *
+ * RETURNS:
+ * 0				If memory de-allocation was succesful.
+ * -1				If map is NULL, or destructor is NULL.
+ **/
+int nmhash_free(nmhash *map)
+{
+	if (map == NULL || map->destructor == NULL) {
+		return (-1);
+	}
+	nmhash_table_purge(&map->cur, map->destructor);
+	nmhash_table_purge(&map->old, map->destructor);
+	nmhash_table_release(&map->cur);
+	nmhash_table_release(&map->old);
+	free(map);
+	return (0);
+}
+
+/**
+ * Inserts 'data' into the hash table.
+ *
+ * RETURNS:
+ * 0				If insertion was succesful.
+ * 1				If an element equal to 'data' is already in
+ * 					the table (the table is not modified).
+ * -1				If map is NULL or memory allocation failed.
+ **/
+int nmhash_insert(nmhash *map, const void *data)
+{
+	uint64_t h;
+	if (map == NULL) {
+		return (-1);
+	}
+	h = nmhash_mix(map, data);
+	if (nmhash_table_find(map, &map->cur, data, h) >= 0 ||
+	        (map->old.ctrl != NULL &&
+	         nmhash_table_find(map, &map->old, data, h) >= 0)) {
+		return (1);
+	}
+	if (nmhash_reserve(map) != 0) {
+		return (-1);
+	}
+	nmhash_table_place(&map->cur, data, h);
+	nmhash_migrate(map, NMHASH_MIGRATE);
+	return (0);
+}
+
+/**
+ * Searches the hash table for an element equal to 'data'.
+ *
+ * RETURNS:
+ * NULL				If there is no such element (or map is NULL).
+ * The data held by the table.
+ **/
+void *nmhash_find(nmhash *map, const void *data)
+{
+	uint64_t h;
+	long idx;
+	if (map == NULL) {
+		return NULL;
+	}
+	h = nmhash_mix(map, data);
+	if ((idx = nmhash_table_find(map, &map->cur, data, h)) >= 0) {
+		return map->cur.slots[idx];
+	}
+	if (map->old.ctrl != NULL &&
+	        (idx = nmhash_table_find(map, &map->old, data, h)) >= 0) {
+		return map->old.slots[idx];
+	}
+	return NULL;
+}
+
+/**
+ * Test if an element equal to 'data' is in the hash table.
+ *
+ * RETURNS:
+ * 1				If the table contains the element.
+ * 0				If it doesn't.
+ * -1				If map is NULL.
+ **/
+int nmhash_contains(nmhash *map, const void *data)
+{
+	uint64_t h;
+	if (map == NULL) {
+		return (-1);
+	}
+	h = nmhash_mix(map, data);
+	return (nmhash_table_find(map, &map->cur, data, h) >= 0 ||
+	        (map->old.ctrl != NULL &&
+	         nmhash_table_find(map, &map->old, data, h) >= 0)) ? 1 : 0;
+}
+
+/**
+ * Removes the element equal to 'data' from the hash table, and
+ * returns the data that was held.
+ *
+ * RETURNS:
+ * NULL				If there is no such element (or map is NULL).
+ * 'data'			The data held by the table.
+ **/
+void *nmhash_remove(nmhash *map, const void *data)
+{
+	nmhash_table *table;
+	void *rdata = NULL;
+	uint64_t h;
+	long idx;
+	if (map == NULL) {
+		return NULL;
+	}
+	h = nmhash_mix(map, data);
+	table = &map->cur;
+	if ((idx = nmhash_table_find(map, table, data, h)) < 0 &&
+	        map->old.ctrl != NULL) {
+		table = &map->old;
+		idx = nmhash_table_find(map, table, data, h);
+	}
+	if (idx >= 0) {
+		rdata = table->slots[idx];
+		nmhash_table_clear(table, (size_t) idx);
+	}
+	nmhash_migrate(map, NMHASH_MIGRATE);
+	return rdata;
+}
+
+/**
+ * Removes the element equal to 'data' from the hash table and
+ * frees its data.
+ *
+ * RETURNS:
+ * 0				If the element was purged (or wasn't found).
+ * -1				If map is NULL or destructor is NULL.
+ **/
+int nmhash_purge(nmhash *map, const void *data)
+{
+	void *rdata;
+	if (map == NULL || map->destructor == NULL) {
+		return (-1);
+	}
+	if ((rdata = nmhash_remove(map, data)) != NULL) {
+		map->destructor(rdata);
+	}
+	return (0);
+}
+
+/**
+ * Returns the number of elements in the hash table.
+ **/
+unsigned int nmhash_size(nmhash *map)
+{
+	return (map == NULL) ? 0 : (unsigned int) (map->cur.size + map->old.size);
+}
+
+/**
+ * Returns the number of slots of the (current) table.
+ **/
+unsigned int nmhash_capacity(nmhash *map)
+{
+	return (map == NULL) ? 0 : (unsigned int) (map->cur.mask + 1);
+}
+
+/**
+ * Hash function for tables holding pointers compared
+ * by identity (hashes the pointer value itself).
+ **/
+size_t nmhash_ptr(const void *data)
+{
+	return (size_t) (uintptr_t) data;
+}
+
+/**
+ * Hash function for tables holding NUL terminated strings
+ * (FNV-1a).
+ **/
+size_t nmhash_str(const void *data)
+{
+	const unsigned char *str = data;
+	uint64_t h = 0xcbf29ce484222325ULL;
+	while (*str != '\0') {
+		h ^= *str++;
+		h *= 0x100000001b3ULL;
+	}
+	return (size_t) h;
+}
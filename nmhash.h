@@ -0,0 +1,24 @@
+#ifndef __NM__HASH__H__
+#define __NM__HASH__H__
+#include <stddef.h>
+#include "nmaux.h"
+
+typedef struct nmhash_s nmhash;
+
+nmhash *nmhash_alloc(unsigned int icap, size_t (*hash)(const void *data),
+                     void (*destructor)(void *data),
+                     int (*cmp)(const void *e1, const void *e2));
+int nmhash_free(nmhash *map);
+
+int nmhash_insert(nmhash *map, const void *data);
+void *nmhash_find(nmhash *map, const void *data);
+int nmhash_contains(nmhash *map, const void *data);
+void *nmhash_remove(nmhash *map, const void *data);
+int nmhash_purge(nmhash *map, const void *data);
+unsigned int nmhash_size(nmhash *map);
+unsigned int nmhash_capacity(nmhash *map);
+
+size_t nmhash_ptr(const void *data);
+size_t nmhash_str(const void *data);
+
+#endif
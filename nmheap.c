@@ -0,0 +1,295 @@
+#include <stdlib.h>
+#include "nmheap.h"
+
+/* Binary min-heap stored in an nmvect: the children of the element
+ * at 'i' are at '2*i+1' and '2*i+2', and no element is less (by the
+ * vect 'cmp') than its parent, so the smallest one is at index 0. */
+struct nmheap_s {
+	nmvect *vect;
+	int (*cmp)(const void *e1, const void *e2);
+	void (*index)(void *data, unsigned int index);
+};
+
+/**
+ * THIS FUNCTION IS PRIVATE.
+ * Stores 'data' at position 'i' and notifies the index callback.
+ **/
+static void nmheap_place(nmheap *heap, unsigned int i, void *data)
+{
+	nmvect_set(heap->vect, i, data);
+	if (heap->index != NULL) {
+		heap->index(data, i);
+	}
+}
+
+/**
+ * THIS FUNCTION IS PRIVATE.
+ * Moves 'data', to be stored at position 'i', up towards the root
+ * while it is less than its parent.
+ **/
+static void nmheap_sift_up(nmheap *heap, unsigned int i, void *data)
+{
+	unsigned int parent;
+	void *pdata;
+	while (i > 0) {
+		parent = (i - 1) / 2;
+		pdata = nmvect_get(heap->vect, parent);
+		if (heap->cmp(data, pdata) >= 0) {
+			break;
+		}
+		nmheap_place(heap, i, pdata);
+		i = parent;
+	}
+	nmheap_place(heap, i, data);
+}
+
+/**
+ * THIS FUNCTION IS PRIVATE.
+ * Moves 'data', to be stored at position 'i', down towards the leaves
+ * while one of its children is less than it.
+ **/
+static void nmheap_sift_down(nmheap *heap, unsigned int i, void *data)
+{
+	unsigned int size = nmvect_size(heap->vect), child;
+	void *cdata;
+	while ((child = 2 * i + 1) < size) {
+		cdata = nmvect_get(heap->vect, child);
+		if (child + 1 < size &&
+		        heap->cmp(nmvect_get(heap->vect, child + 1), cdata) < 0) {
+			child++;
+			cdata = nmvect_get(heap->vect, child);
+		}
+		if (heap->cmp(cdata, data) >= 0) {
+			break;
+		}
+		nmheap_place(heap, i, cdata);
+		i = child;
+	}
+	nmheap_place(heap, i, data);
+}
+
+/**
+ * Allocates memory for a new empty heap.
+ *
+ * INPUT:
+ * 'icap'			Initial capacity.
+ * 'destructor'		Function needed to free data held by the heap.
+ * 'cmp'			Function needed to compare two elements. The
+ * 					element that compares the smallest is on top.
+ *
+ * RETURNS:
+ * NULL				If memory allocation fails or 'cmp' is NULL.
+ * A new heap.
+ **/
+nmheap *nmheap_alloc(unsigned int icap, void (*destructor)(void *data),
+                     int (*cmp)(const void *e1, const void *e2))
+{
+	nmheap *heap = NULL;
+	nmvect *vect = NULL;
+	if (cmp == NULL ||
+	        (vect = nmvect_alloc((icap > 0) ? icap : 1, destructor, cmp)) == NULL) {
+		return NULL;
+	}
+	if ((heap = nmheap_heapify(vect)) == NULL) {
+		nmvect_free(vect);
+	}
+	return heap;
+}
+
+/**
+ * Builds a heap out of an existing vector, in O(n).
+ *
+ * The heap takes ownership of 'vect' (it is de-allocated by
+ * 'nmheap_free') and orders it using the vect 'cmp'.
+ *
+ * RETURNS:
+ * NULL				If memory allocation fails, 'vect' is NULL or
+ * 					has no 'cmp'.
+ * A new heap.
+ **/
+nmheap *nmheap_heapify(nmvect *vect)
+{
+	nmheap *heap = NULL;
+	unsigned int i;
+	if (vect == NULL || nmvect_get_cmp(vect) == NULL) {
+		return NULL;
+	}
+	if ((heap = calloc(1, sizeof(*heap))) == NULL) {
+		return NULL;
+	}
+	heap->vect = vect;
+	heap->cmp = nmvect_get_cmp(vect);
+	heap->index = NULL;
+	for (i = nmvect_size(vect) / 2; i > 0; i--) {
+		nmheap_sift_down(heap, i - 1, nmvect_get(vect, i - 1));
+	}
+	return heap;
+}
+
+/**
+ * De-allocates memory for the heap and the data it holds.
+ *
+ * RETURNS:
+ * 0				If memory de-allocation was succesful.
+ * -1				If heap is NULL, or destructor is NULL.
+ **/
+int nmheap_free(nmheap *heap)
+{
+	if (heap == NULL || nmvect_free(heap->vect) != 0) {
+		return (-1);
+	}
+	free(heap);
+	return (0);
+}
+
+/**
+ * Pushes 'data' into the heap in O(log n).
+ *
+ * RETURNS:
+ * 0				If insertion was succesful.
+ * -1				If heap is NULL or memory allocation failed.
+ **/
+int nmheap_push(nmheap *heap, const void *data)
+{
+	if (heap == NULL || nmvect_append(heap->vect, data) != 0) {
+		return (-1);
+	}
+	nmheap_sift_up(heap, nmvect_size(heap->vect) - 1, (void*) data);
+	return (0);
+}
+
+/**
+ * Removes the smallest element from the heap in O(log n),
+ * and returns its data.
+ *
+ * RETURNS:
+ * NULL				If heap is NULL or empty.
+ * 'data'			The data of the top element.
+ **/
+void *nmheap_pop(nmheap *heap)
+{
+	return nmheap_remove(heap, 0);
+}
+
+/**
+ * Returns the data of the smallest element without
+ * removing it.
+ *
+ * RETURNS:
+ * NULL				If heap is NULL or empty.
+ * 'data'			The data of the top element.
+ **/
+void *nmheap_peek(nmheap *heap)
+{
+	return (heap == NULL) ? NULL : nmvect_get(heap->vect, 0);
+}
+
+/**
+ * Pops the smallest element and frees its data.
+ *
+ * RETURNS:
+ * 0				If the element was purged.
+ * -1				If heap is NULL, or destructor is NULL.
+ **/
+int nmheap_purge(nmheap *heap)
+{
+	void *data;
+	if (heap == NULL || nmvect_get_destructor(heap->vect) == NULL) {
+		return (-1);
+	}
+	if ((data = nmheap_pop(heap)) != NULL) {
+		nmvect_get_destructor(heap->vect)(data);
+	}
+	return (0);
+}
+
+/**
+ * Removes the element at position 'index' in O(log n), and
+ * returns its data.
+ *
+ * Positions change as the heap is modified: use 'nmheap_set_index'
+ * to keep track of them.
+ *
+ * RETURNS:
+ * NULL				If heap is NULL or index is out of bounds.
+ * 'data'			The data of the removed element.
+ **/
+void *nmheap_remove(nmheap *heap, unsigned int index)
+{
+	void *data, *last;
+	if (heap == NULL || index >= nmvect_size(heap->vect)) {
+		return NULL;
+	}
+	data = nmvect_get(heap->vect, index);
+	last = nmvect_remove_last(heap->vect);
+	if (index < nmvect_size(heap->vect)) {
+		if (index > 0 &&
+		        heap->cmp(last, nmvect_get(heap->vect, (index - 1) / 2)) < 0) {
+			nmheap_sift_up(heap, index, last);
+		} else {
+			nmheap_sift_down(heap, index, last);
+		}
+	}
+	return data;
+}
+
+/**
+ * Restores the heap order after the key of the element at
+ * position 'index' was decreased, in O(log n).
+ *
+ * RETURNS:
+ * 0				If the heap was updated.
+ * -1				If heap is NULL or index is out of bounds.
+ **/
+int nmheap_decrease_key(nmheap *heap, unsigned int index)
+{
+	if (heap == NULL || index >= nmvect_size(heap->vect)) {
+		return (-1);
+	}
+	nmheap_sift_up(heap, index, nmvect_get(heap->vect, index));
+	return (0);
+}
+
+/**
+ * Sets a callback notified with the new position of every
+ * element that moves inside the heap, so the caller can
+ * later use 'nmheap_decrease_key' / 'nmheap_remove' on it.
+ *
+ * The callback is immediately called for all the elements
+ * already in the heap.
+ *
+ * RETURNS:
+ * 0				If the callback was set.
+ * -1				If heap is NULL.
+ **/
+int nmheap_set_index(nmheap *heap, void (*index)(void *data, unsigned int index))
+{
+	unsigned int i;
+	if (heap == NULL) {
+		return (-1);
+	}
+	heap->index = index;
+	if (index != NULL) {
+		for (i = 0; i < nmvect_size(heap->vect); i++) {
+			index(nmvect_get(heap->vect, i), i);
+		}
+	}
+	return (0);
+}
+
+/**
+ * Returns the number of elements in the heap.
+ **/
+unsigned int nmheap_size(nmheap *heap)
+{
+	return (heap == NULL) ? 0 : nmvect_size(heap->vect);
+}
+
+/**
+ * Returns the vector holding the heap elements. It can be
+ * read, but modifying it breaks the heap order.
+ **/
+nmvect *nmheap_vect(nmheap *heap)
+{
+	return (heap == NULL) ? NULL : heap->vect;
+}
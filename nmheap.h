@@ -0,0 +1,22 @@
+#ifndef __NM__HEAP__H__
+#define __NM__HEAP__H__
+#include "nmvect.h"
+
+typedef struct nmheap_s nmheap;
+
+nmheap *nmheap_alloc(unsigned int icap, void (*destructor)(void *data),
+                     int (*cmp)(const void *e1, const void *e2));
+nmheap *nmheap_heapify(nmvect *vect);
+int nmheap_free(nmheap *heap);
+
+int nmheap_push(nmheap *heap, const void *data);
+void *nmheap_pop(nmheap *heap);
+void *nmheap_peek(nmheap *heap);
+int nmheap_purge(nmheap *heap);
+void *nmheap_remove(nmheap *heap, unsigned int index);
+int nmheap_decrease_key(nmheap *heap, unsigned int index);
+int nmheap_set_index(nmheap *heap, void (*index)(void *data, unsigned int index));
+unsigned int nmheap_size(nmheap *heap);
+nmvect *nmheap_vect(nmheap *heap);
+
+#endif
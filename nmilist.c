@@ -0,0 +1,193 @@
+#include <stdlib.h>
+#include "nmilist.h"
+
+/**
+ * Initializes an empty intrusive list.
+ *
+ * The list never allocates: the links are embedded in the
+ * elements, which stay owned by the caller (the list doesn't
+ * free them). An element can be in as many lists as it embeds
+ * links.
+ *
+ * Example:
+ *
+ *	struct job { int id; nmilist_link link; };
+ *	nmilist_insert_next(&list, nmilist_tail(&list), &job->link);
+ *	job = NM_CONTAINER_OF(nmilist_head(&list), struct job, link);
+ *
+ * RETURNS:
+ * 0				If operation was succesful.
+ * -1				If list is NULL.
+ **/
+int nmilist_init(nmilist *list)
+{
+	if (list == NULL) {
+		return (-1);
+	}
+	list->size = 0;
+	list->head = NULL;
+	list->tail = NULL;
+	return (0);
+}
+
+/**
+ * Inserts 'link' into the list after 'element'.
+ *
+ * INPUT:
+ * 'list'		The list.
+ * 'element'	We insert 'link' after this one (if NULL 'link'
+ * 				becomes the head).
+ * 'link'		The link to insert (not in the list already).
+ *
+ * RETURNS:
+ * 0			If insertion was succesful.
+ * -1			If list or link are NULL.
+ **/
+int nmilist_insert_next(nmilist *list, nmilist_link *element, nmilist_link *link)
+{
+	if (list == NULL || link == NULL) {
+		return (-1);
+	}
+	if (element == NULL) {
+		if (list->size == 0) {
+			list->tail = link;
+		}
+		link->next = list->head;
+		list->head = link;
+	} else {
+		if (element->next == NULL) {
+			list->tail = link;
+		}
+		link->next = element->next;
+		element->next = link;
+	}
+	list->size++;
+	return (0);
+}
+
+/**
+ * Inserts 'link' into the list at the specified index.
+ *
+ * RETURNS:
+ * 0			If insertion was succesful.
+ * -1			If list or link are NULL or index is out of bounds.
+ **/
+int nmilist_insert_index(nmilist *list, unsigned int index, nmilist_link *link)
+{
+	if (list == NULL || index > list->size) {
+		return (-1);
+	}
+	if (index == 0) {
+		return nmilist_insert_next(list, NULL, link);
+	}
+	return nmilist_insert_next(list, nmilist_index(list, index - 1), link);
+}
+
+/**
+ * Removes the link following 'element' from the list (the head
+ * if 'element' is NULL).
+ *
+ * RETURNS:
+ * The removed link.
+ * NULL			If list is NULL or there is nothing to remove.
+ **/
+nmilist_link *nmilist_remove_next(nmilist *list, nmilist_link *element)
+{
+	nmilist_link *old;
+	if (list == NULL || list->size == 0) {
+		return NULL;
+	}
+	if (element == NULL) {
+		old = list->head;
+		list->head = old->next;
+		if (list->size == 1) {
+			list->tail = NULL;
+		}
+	} else {
+		if ((old = element->next) == NULL) {
+			return NULL;
+		}
+		element->next = old->next;
+		if (old->next == NULL) {
+			list->tail = element;
+		}
+	}
+	old->next = NULL;
+	list->size--;
+	return old;
+}
+
+/**
+ * Removes the link at the specified index.
+ *
+ * RETURNS:
+ * The removed link.
+ * NULL			If list is NULL or index is out of bounds.
+ **/
+nmilist_link *nmilist_remove_index(nmilist *list, unsigned int index)
+{
+	if (list == NULL || index >= list->size) {
+		return NULL;
+	}
+	if (index == 0) {
+		return nmilist_remove_next(list, NULL);
+	}
+	return nmilist_remove_next(list, nmilist_index(list, index - 1));
+}
+
+/**
+ * Returns the number of links in the list (0 if list is NULL).
+ **/
+unsigned int nmilist_size(nmilist *list)
+{
+	return (list == NULL) ? 0 : list->size;
+}
+
+/**
+ * Returns the first link of the list (NULL if list is NULL
+ * or empty).
+ **/
+nmilist_link *nmilist_head(nmilist *list)
+{
+	return (list == NULL) ? NULL : list->head;
+}
+
+/**
+ * Returns the last link of the list (NULL if list is NULL
+ * or empty).
+ **/
+nmilist_link *nmilist_tail(nmilist *list)
+{
+	return (list == NULL) ? NULL : list->tail;
+}
+
+/**
+ * Returns the link following 'element' (NULL at the tail).
+ **/
+nmilist_link *nmilist_next(nmilist_link *element)
+{
+	return (element == NULL) ? NULL : element->next;
+}
+
+/**
+ * Returns the 'index'th link of the list.
+ *
+ * RETURNS:
+ * NULL			If list is NULL or index is out of bounds.
+ * The link.
+ **/
+nmilist_link *nmilist_index(nmilist *list, unsigned int index)
+{
+	nmilist_link *link;
+	unsigned int i;
+	if (list == NULL || index >= list->size) {
+		return NULL;
+	}
+	if (index == list->size - 1) {
+		return list->tail;
+	}
+	for (i = 0, link = list->head; i < index; i++) {
+		link = link->next;
+	}
+	return link;
+}
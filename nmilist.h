@@ -0,0 +1,31 @@
+#ifndef __NM__ILIST__H__
+#define __NM__ILIST__H__
+#include "nmaux.h"
+
+/* Intrusive singly linked list: 'nmilist_link' is embedded in the
+ * user structure, 'NM_CONTAINER_OF' gets back to the structure. */
+typedef struct nmilist_link_s {
+	struct nmilist_link_s *next;
+} nmilist_link;
+
+typedef struct nmilist_s {
+	unsigned int size;
+	nmilist_link *head;
+	nmilist_link *tail;
+} nmilist;
+
+int nmilist_init(nmilist *list);
+
+int nmilist_insert_next(nmilist *list, nmilist_link *element, nmilist_link *link);
+int nmilist_insert_index(nmilist *list, unsigned int index, nmilist_link *link);
+
+nmilist_link *nmilist_remove_next(nmilist *list, nmilist_link *element);
+nmilist_link *nmilist_remove_index(nmilist *list, unsigned int index);
+
+unsigned int nmilist_size(nmilist *list);
+nmilist_link *nmilist_head(nmilist *list);
+nmilist_link *nmilist_tail(nmilist *list);
+nmilist_link *nmilist_next(nmilist_link *element);
+nmilist_link *nmilist_index(nmilist *list, unsigned int index);
+
+#endif
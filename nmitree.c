@@ -0,0 +1,331 @@
+#include <stdlib.h>
+#include "nmitree.h"
+
+/**
+ * Initializes an empty intrusive tree.
+ *
+ * The tree never allocates: the links are embedded in the
+ * elements, which stay owned by the caller (the tree doesn't
+ * free them). Lookups take a 'key' link, usually embedded in a
+ * structure on the stack holding only the key fields.
+ *
+ * Example:
+ *
+ *	struct item { int key; nmitree_link link; };
+ *	int cmp(const nmitree_link *l1, const nmitree_link *l2) {
+ *		return NM_CONTAINER_OF(l1, struct item, link)->key -
+ *		       NM_CONTAINER_OF(l2, struct item, link)->key;
+ *	}
+ *
+ * INPUT:
+ * 'tree'			The tree.
+ * 'cmp'			Function comparing the structures embedding
+ * 					two links (<0, 0, >0).
+ *
+ * RETURNS:
+ * 0				If operation was succesful.
+ * -1				If tree or cmp are NULL.
+ **/
+int nmitree_init(nmitree *tree,
+                 int (*cmp)(const nmitree_link *l1, const nmitree_link *l2))
+{
+	if (tree == NULL || cmp == NULL) {
+		return (-1);
+	}
+	tree->cmp = cmp;
+	tree->size = 0;
+	tree->root = NULL;
+	return (0);
+}
+
+/**
+ * THIS FUNCTION IS PRIVATE.
+ * Returns the height of the subtree rooted at 'link'.
+ **/
+static int nmitree_height(nmitree_link *link)
+{
+	return (link == NULL) ? 0 : link->height;
+}
+
+/**
+ * THIS FUNCTION IS PRIVATE.
+ * Recomputes 'link->height' from its children.
+ **/
+static void nmitree_update(nmitree_link *link)
+{
+	int hl = nmitree_height(link->left);
+	int hr = nmitree_height(link->right);
+	link->height = ((hl > hr) ? hl : hr) + 1;
+}
+
+/**
+ * THIS FUNCTION IS PRIVATE.
+ * Rotates the subtree rooted at '*slot' to the left.
+ **/
+static void nmitree_rotate_left(nmitree_link **slot)
+{
+	nmitree_link *link = *slot;
+	nmitree_link *right = link->right;
+	link->right = right->left;
+	right->left = link;
+	nmitree_update(link);
+	nmitree_update(right);
+	*slot = right;
+}
+
+/**
+ * THIS FUNCTION IS PRIVATE.
+ * Rotates the subtree rooted at '*slot' to the right.
+ **/
+static void nmitree_rotate_right(nmitree_link **slot)
+{
+	nmitree_link *link = *slot;
+	nmitree_link *left = link->left;
+	link->left = left->right;
+	left->right = link;
+	nmitree_update(link);
+	nmitree_update(left);
+	*slot = left;
+}
+
+/**
+ * THIS FUNCTION IS PRIVATE.
+ * Restores the AVL balance of the subtree rooted at '*slot' (see
+ * 'nmbintree_balance').
+ **/
+static void nmitree_balance(nmitree_link **slot)
+{
+	nmitree_link *link = *slot;
+	int balance = nmitree_height(link->left) - nmitree_height(link->right);
+	if (balance > 1) {
+		if (nmitree_height(link->left->left) < nmitree_height(link->left->right)) {
+			nmitree_rotate_left(&link->left);
+		}
+		nmitree_rotate_right(slot);
+	} else if (balance < -1) {
+		if (nmitree_height(link->right->right) < nmitree_height(link->right->left)) {
+			nmitree_rotate_right(&link->right);
+		}
+		nmitree_rotate_left(slot);
+	} else {
+		nmitree_update(link);
+	}
+}
+
+/**
+ * THIS FUNCTION IS PRIVATE.
+ * Re-balances the links on 'path', from the deepest one up,
+ * stopping once a subtree height doesn't change.
+ **/
+static void nmitree_rebalance(nmitree_link ***path, int depth)
+{
+	int height;
+	while (depth > 0) {
+		depth--;
+		height = (*path[depth])->height;
+		nmitree_balance(path[depth]);
+		if ((*path[depth])->height == height) {
+			break;
+		}
+	}
+}
+
+/**
+ * Inserts 'link' in the tree, keeping it ordered by 'tree->cmp'
+ * and height balanced (AVL). Never allocates.
+ *
+ * RETURNS:
+ * 0				If insertion is succesful.
+ * 1				If an equal link is already in the tree (the
+ * 					tree is not modified).
+ * -1				If tree or link are NULL.
+ **/
+int nmitree_insert(nmitree *tree, nmitree_link *link)
+{
+	nmitree_link **path[NMITREE_MAX_HEIGHT];
+	nmitree_link **slot;
+	int depth = 0, c;
+	if (tree == NULL || link == NULL) {
+		return (-1);
+	}
+	slot = &tree->root;
+	while (*slot != NULL) {
+		if ((c = tree->cmp(link, *slot)) == 0) {
+			return (1);
+		}
+		path[depth++] = slot;
+		slot = (c < 0) ? &(*slot)->left : &(*slot)->right;
+	}
+	link->left = NULL;
+	link->right = NULL;
+	link->height = 1;
+	*slot = link;
+	tree->size++;
+	nmitree_rebalance(path, depth);
+	return (0);
+}
+
+/**
+ * Searches the tree for a link equal to 'key'.
+ *
+ * RETURNS:
+ * NULL				If there is no such link (or tree is NULL).
+ * The link.
+ **/
+nmitree_link *nmitree_find(nmitree *tree, const nmitree_link *key)
+{
+	nmitree_link *link;
+	int c;
+	if (tree == NULL || key == NULL) {
+		return NULL;
+	}
+	link = tree->root;
+	while (link != NULL && (c = tree->cmp(key, link)) != 0) {
+		link = (c < 0) ? link->left : link->right;
+	}
+	return link;
+}
+
+/**
+ * Removes the link equal to 'key' from the tree, and returns it.
+ * The tree is re-balanced. Never frees.
+ *
+ * RETURNS:
+ * NULL				If there is no such link (or tree is NULL).
+ * The removed link.
+ **/
+nmitree_link *nmitree_erase(nmitree *tree, const nmitree_link *key)
+{
+	nmitree_link **path[NMITREE_MAX_HEIGHT];
+	nmitree_link **slot, **succ_slot;
+	nmitree_link *link, *succ;
+	int depth = 0, link_depth, c;
+	if (tree == NULL || key == NULL) {
+		return NULL;
+	}
+	slot = &tree->root;
+	while (*slot != NULL && (c = tree->cmp(key, *slot)) != 0) {
+		path[depth++] = slot;
+		slot = (c < 0) ? &(*slot)->left : &(*slot)->right;
+	}
+	if ((link = *slot) == NULL) {
+		return NULL;
+	}
+	if (link->left == NULL) {
+		*slot = link->right;
+	} else if (link->right == NULL) {
+		*slot = link->left;
+	} else {
+		/* Replace the link by its in-order successor */
+		link_depth = depth;
+		path[depth++] = slot;
+		succ_slot = &link->right;
+		while ((*succ_slot)->left != NULL) {
+			path[depth++] = succ_slot;
+			succ_slot = &(*succ_slot)->left;
+		}
+		succ = *succ_slot;
+		*succ_slot = succ->right;
+		succ->left = link->left;
+		succ->right = link->right;
+		succ->height = link->height;
+		*slot = succ;
+		if (depth > link_depth + 1) {
+			path[link_depth + 1] = &succ->right;
+		}
+	}
+	link->left = NULL;
+	link->right = NULL;
+	tree->size--;
+	nmitree_rebalance(path, depth);
+	return link;
+}
+
+/**
+ * Returns the smallest link that is not less than 'key'
+ * (NULL if there is none, or tree is NULL).
+ **/
+nmitree_link *nmitree_lower_bound(nmitree *tree, const nmitree_link *key)
+{
+	nmitree_link *link, *bound = NULL;
+	if (tree == NULL || key == NULL) {
+		return NULL;
+	}
+	link = tree->root;
+	while (link != NULL) {
+		if (tree->cmp(key, link) <= 0) {
+			bound = link;
+			link = link->left;
+		} else {
+			link = link->right;
+		}
+	}
+	return bound;
+}
+
+/**
+ * Returns the smallest link that is greater than 'key'
+ * (NULL if there is none, or tree is NULL).
+ **/
+nmitree_link *nmitree_upper_bound(nmitree *tree, const nmitree_link *key)
+{
+	nmitree_link *link, *bound = NULL;
+	if (tree == NULL || key == NULL) {
+		return NULL;
+	}
+	link = tree->root;
+	while (link != NULL) {
+		if (tree->cmp(key, link) < 0) {
+			bound = link;
+			link = link->left;
+		} else {
+			link = link->right;
+		}
+	}
+	return bound;
+}
+
+/**
+ * Returns the smallest link of the tree (NULL if tree is NULL
+ * or empty).
+ **/
+nmitree_link *nmitree_first(nmitree *tree)
+{
+	nmitree_link *link;
+	if (tree == NULL || (link = tree->root) == NULL) {
+		return NULL;
+	}
+	while (link->left != NULL) {
+		link = link->left;
+	}
+	return link;
+}
+
+/**
+ * Returns the link following 'link' in order, in O(log n) (the
+ * links don't point to their parent). With 'nmitree_first' this
+ * walks the tree in order:
+ *
+ *	for (l = nmitree_first(t); l != NULL; l = nmitree_next(t, l))
+ *
+ * RETURNS:
+ * NULL				If 'link' is the last one (or tree is NULL).
+ * The next link.
+ **/
+nmitree_link *nmitree_next(nmitree *tree, const nmitree_link *link)
+{
+	nmitree_link *next;
+	if (link != NULL && link->right != NULL) {
+		for (next = link->right; next->left != NULL; next = next->left);
+		return next;
+	}
+	return nmitree_upper_bound(tree, link);
+}
+
+/**
+ * Returns the number of links in the tree (0 if tree is NULL).
+ **/
+unsigned int nmitree_size(nmitree *tree)
+{
+	return (tree == NULL) ? 0 : tree->size;
+}
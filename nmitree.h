@@ -0,0 +1,35 @@
+#ifndef __NM__ITREE__H__
+#define __NM__ITREE__H__
+#include "nmaux.h"
+
+/* Maximum height of an intrusive tree (an AVL tree of height 64
+ * would hold more than 2^44 links). */
+#define NMITREE_MAX_HEIGHT 64
+
+/* Intrusive AVL tree: 'nmitree_link' is embedded in the user
+ * structure, 'NM_CONTAINER_OF' gets back to the structure. */
+typedef struct nmitree_link_s {
+	struct nmitree_link_s *left;
+	struct nmitree_link_s *right;
+	int height;
+} nmitree_link;
+
+typedef struct nmitree_s {
+	int (*cmp)(const nmitree_link *l1, const nmitree_link *l2);
+	unsigned int size;
+	nmitree_link *root;
+} nmitree;
+
+int nmitree_init(nmitree *tree,
+                 int (*cmp)(const nmitree_link *l1, const nmitree_link *l2));
+
+int nmitree_insert(nmitree *tree, nmitree_link *link);
+nmitree_link *nmitree_find(nmitree *tree, const nmitree_link *key);
+nmitree_link *nmitree_erase(nmitree *tree, const nmitree_link *key);
+nmitree_link *nmitree_lower_bound(nmitree *tree, const nmitree_link *key);
+nmitree_link *nmitree_upper_bound(nmitree *tree, const nmitree_link *key);
+nmitree_link *nmitree_first(nmitree *tree);
+nmitree_link *nmitree_next(nmitree *tree, const nmitree_link *link);
+unsigned int nmitree_size(nmitree *tree);
+
+#endif
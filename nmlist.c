@@ -1,4 +1,6 @@
 #include <stdlib.h>
+#include <string.h>
+#include "nmaux.h"
 #include "nmlist.h"
 
 struct nmlist_element_s {
@@ -12,8 +14,128 @@ struct nmlist_s {
 	unsigned int size;
 	nmlist_element *head;
 	nmlist_element *tail;
+	nmlist_pool *pool;
+	const nm_allocator *allocator;
+#ifdef NM_STATS
+	nm_stats stats;
+#endif
 };
 
+/* Elements are carved out of chunks of 'chunk + 1' elements. The first
+ * element of every chunk is not handed out, its 'next' field links the
+ * chunks together so they can be released by 'nmlist_pool_free'. */
+struct nmlist_pool_s {
+	unsigned int chunk;
+	unsigned int refs;
+	nmlist_element *free;
+	nmlist_element *chunks;
+};
+
+/**
+ * Allocates memory for a new element pool.
+ *
+ * A pool recycles the 'nmlist_element' structures released by
+ * the lists using it, so once the pool is warm inserting and removing
+ * elements doesn't call 'calloc' / 'free' anymore.
+ *
+ * The pool can be shared by multiple lists (it is not thread safe).
+ * Every list created with 'nmlist_alloc_pool' holds a reference
+ * to the pool, so it doesn't matter if 'nmlist_pool_free' is called
+ * before or after the lists are de-allocated.
+ *
+ * INPUT:
+ * 'chunk'			Number of elements allocated at once
+ * 					when the pool runs dry.
+ *
+ * RETURNS:
+ * NULL				If memory allocation fails or 'chunk' is 0.
+ * A new element pool.
+ **/
+nmlist_pool *nmlist_pool_alloc(unsigned int chunk)
+{
+	nmlist_pool *pool = NULL;
+	if (chunk == 0) {
+		return NULL;
+	}
+	if ((pool = calloc(1, sizeof(*pool))) != NULL) {
+		pool->chunk = chunk;
+		pool->refs = 1;
+		pool->free = NULL;
+		pool->chunks = NULL;
+	}
+	return pool;
+}
+
+/**
+ * Releases a reference to 'pool'.
+ *
+ * When the last reference is released (the creator's one and
+ * the ones held by the lists) all the chunks are de-allocated.
+ *
+ * RETURNS:
+ * 0				If the reference was released.
+ * -1				If 'pool' is NULL.
+ **/
+int nmlist_pool_free(nmlist_pool *pool)
+{
+	nmlist_element *chunk, *next;
+	if (pool == NULL) {
+		return (-1);
+	}
+	if (--pool->refs > 0) {
+		return (0);
+	}
+	for (chunk = pool->chunks; chunk != NULL; chunk = next) {
+		next = chunk->next;
+		free(chunk);
+	}
+	free(pool);
+	return (0);
+}
+
+/**
+ * THIS FUNCTION IS PRIVATE.
+ * Takes an element from the pool free list, allocating
+ * a new chunk if the free list is empty.
+ *
+ * RETURNS:
+ * NULL				If memory allocation fails.
+ * An element with 'data' and 'next' set to NULL.
+ **/
+static nmlist_element *nmlist_pool_get(nmlist_pool *pool)
+{
+	nmlist_element *element, *chunk;
+	unsigned int i;
+	if (pool->free == NULL) {
+		chunk = malloc((pool->chunk + 1) * sizeof(*chunk));
+		if (chunk == NULL) {
+			return NULL;
+		}
+		chunk->next = pool->chunks;
+		pool->chunks = chunk;
+		for (i = 1; i < pool->chunk; i++) {
+			chunk[i].next = &chunk[i+1];
+		}
+		chunk[pool->chunk].next = NULL;
+		pool->free = &chunk[1];
+	}
+	element = pool->free;
+	pool->free = element->next;
+	element->data = NULL;
+	element->next = NULL;
+	return element;
+}
+
+/**
+ * THIS FUNCTION IS PRIVATE.
+ * Gives 'element' back to the pool free list.
+ **/
+static void nmlist_pool_put(nmlist_pool *pool, nmlist_element *element)
+{
+	element->next = pool->free;
+	pool->free = element;
+}
+
 /**
  * Allocates memory for a new linked list.
  *
@@ -24,14 +146,66 @@ struct nmlist_s {
  * A new linked list.
  **/
 nmlist *nmlist_alloc(void (*destructor)(void *data))
+{
+	return nmlist_alloc_with(destructor, NULL);
+}
+
+/**
+ * Allocates memory for a new linked list whose memory (the list
+ * and its elements) comes from 'allocator'.
+ *
+ * INPUT:
+ * 'destructor'		Destructor for 'data' being hold
+ * 					in the 'nmlist_element'.
+ * 'allocator'		The allocator (NULL for malloc / free).
+ * RETURNS:
+ * NULL				If memory allocation fails.
+ * A new linked list.
+ **/
+nmlist *nmlist_alloc_with(void (*destructor)(void *data),
+                          const nm_allocator *allocator)
 {
 	nmlist *list = NULL;
-	if ((list = calloc(1,sizeof(*list))) != NULL) {
+	if ((list = nm_calloc(allocator, 1, sizeof(*list))) != NULL) {
 		list->size = 0;
 		list->destructor = destructor;
 		list->head = NULL;
 		list->tail = NULL;
+		list->pool = NULL;
+		list->allocator = allocator;
+	}
+	return list;
+}
+
+/**
+ * Allocates memory for a new linked list whose elements
+ * are taken from an element pool.
+ *
+ * INPUT:
+ * 'destructor'		Destructor for 'data' being hold
+ * 					in the 'nmlist_element'.
+ * 'pool'			The pool the elements are taken from.
+ * 					If NULL, a private pool of 'NMLIST_POOL_CHUNK'
+ * 					elements per chunk is created for the list.
+ * RETURNS:
+ * NULL				If memory allocation fails.
+ * A new linked list.
+ **/
+nmlist *nmlist_alloc_pool(void (*destructor)(void *data), nmlist_pool *pool)
+{
+	nmlist *list = NULL;
+	if (pool == NULL) {
+		if ((pool = nmlist_pool_alloc(NMLIST_POOL_CHUNK)) == NULL) {
+			return NULL;
+		}
+	} else {
+		pool->refs++;
+	}
+	if ((list = nmlist_alloc(destructor)) == NULL) {
+		nmlist_pool_free(pool);
+		return NULL;
 	}
+	list->pool = pool;
 	return list;
 }
 
@@ -57,7 +231,10 @@ int nmlist_free(nmlist *list)
 			list->destructor(data);
 		}
 	}
-	free(list);
+	if (list->pool != NULL) {
+		nmlist_pool_free(list->pool);
+	}
+	nm_free(list->allocator, list);
 	return (0);
 	
 }
@@ -82,8 +259,15 @@ int nmlist_free(nmlist *list)
 int nmlist_insert_next(nmlist *list, nmlist_element *element, const void *data)
 {
 	nmlist_element *new_e = NULL;
-	new_e = calloc(1, sizeof(*new_e));
-	if (list == NULL || new_e == NULL) {
+	if (list == NULL) {
+		return (-1);
+	}
+	if (list->pool != NULL) {
+		new_e = nmlist_pool_get(list->pool);
+	} else if ((new_e = nm_calloc(list->allocator, 1, sizeof(*new_e))) != NULL) {
+		NM_STAT_INC(list->stats, allocs);
+	}
+	if (new_e == NULL) {
 		return (-1);
 	}
 	new_e->data = (void*) data;
@@ -132,6 +316,7 @@ int nmlist_insert_index(nmlist *list, unsigned int index, const void *data)
 		for (i = 0, tmp = list->head; i < index; i++) {
 			tmp = tmp->next;
 		}
+		NM_STAT_ADD(list->stats, traversed, index);
 		nmlist_insert_next(list, tmp, data);
 	}
 	return (0);
@@ -175,7 +360,11 @@ void *nmlist_remove_next(nmlist *list, nmlist_element *element)
 			list->tail = element;
 		}
 	}
-	free(old_e);
+	if (list->pool != NULL) {
+		nmlist_pool_put(list->pool, old_e);
+	} else {
+		nm_free(list->allocator, old_e);
+	}
 	list->size--;
 	return data;
 }
@@ -205,6 +394,7 @@ void *nmlist_remove_index(nmlist *list, unsigned int index)
 		for (i = 0, tmp = list->head; i < index - 1; i++) {
 			tmp = tmp->next;
 		}
+		NM_STAT_ADD(list->stats, traversed, index - 1);
 		data = nmlist_remove_next(list, tmp);
 	}
 	return (data);
@@ -255,7 +445,7 @@ int nmlist_purge_index(nmlist *list, unsigned int index)
 	}
 	data = nmlist_remove_index(list, index);
 	if (data != NULL) {
-		list->destructor = NULL;
+		list->destructor(data);
 	}
 	return (0);
 }
@@ -308,6 +498,7 @@ nmlist_element *nmlist_index(nmlist *list, unsigned int index)
 	for (i = 0, tmp = list->head; i < index; i++) {
 		tmp = tmp->next;
 	}
+	NM_STAT_ADD(list->stats, traversed, index);
 	return tmp;
 }
 
@@ -523,3 +714,48 @@ int nmlist_set_destructor(nmlist *list, void(*destructor)(void *data))
 	list->destructor = destructor;
 	return (0);
 }
+
+/**
+ * Copies the instrumentation counters of 'list' (see 'nm_stats').
+ *
+ * RETURNS:
+ * 0				If the counters were copied to 'stats'.
+ * -1				If 'list' or 'stats' is NULL, or the library
+ * 					was built without NM_STATS.
+ **/
+int nmlist_stats(nmlist *list, nm_stats *stats)
+{
+#ifdef NM_STATS
+	if (list == NULL || stats == NULL) {
+		return (-1);
+	}
+	*stats = list->stats;
+	return (0);
+#else
+	(void) list;
+	(void) stats;
+	return (-1);
+#endif
+}
+
+/**
+ * Sets the instrumentation counters of 'list' back to zero.
+ *
+ * RETURNS:
+ * 0				If the counters were reset.
+ * -1				If 'list' is NULL, or the library was built
+ * 					without NM_STATS.
+ **/
+int nmlist_stats_reset(nmlist *list)
+{
+#ifdef NM_STATS
+	if (list == NULL) {
+		return (-1);
+	}
+	memset(&list->stats, 0, sizeof(list->stats));
+	return (0);
+#else
+	(void) list;
+	return (-1);
+#endif
+}
@@ -1,10 +1,22 @@
 #ifndef __NM__LIST__H__
 #define __NM__LIST__H__
+#include "nmaux.h"
 
 typedef struct nmlist_element_s nmlist_element;
 typedef struct nmlist_s nmlist;
+typedef struct nmlist_pool_s nmlist_pool;
+
+/* Number of elements carved out of the heap at once by a list pool
+ * created implicitly by 'nmlist_alloc_pool'. */
+#define NMLIST_POOL_CHUNK 256
+
+nmlist_pool *nmlist_pool_alloc(unsigned int chunk);
+int nmlist_pool_free(nmlist_pool *pool);
 	
 nmlist *nmlist_alloc(void (*destructor)(void *data));
+nmlist *nmlist_alloc_pool(void (*destructor)(void *data), nmlist_pool *pool);
+nmlist *nmlist_alloc_with(void (*destructor)(void *data),
+                          const nm_allocator *allocator);
 int nmlist_free(nmlist *list);
 
 int nmlist_insert_next(nmlist *list, nmlist_element *element, const void *data);
@@ -36,4 +48,7 @@ int nmlist_set_next(nmlist_element *element, const void *data);
 int nmlist_set_index(nmlist *list, unsigned int index, const void *data);
 int nmlist_set_destructor(nmlist *list, void(*destructor)(void *data));
 
+int nmlist_stats(nmlist *list, nm_stats *stats);
+int nmlist_stats_reset(nmlist *list);
+
 #endif
\ No newline at end of file
@@ -0,0 +1,257 @@
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdatomic.h>
+#include <sched.h>
+#include "nmmpmc.h"
+
+/* Bounded multi-producer / multi-consumer queue
+ * (D. Vyukov's sequence number ring).
+ *
+ * Every cell carries a sequence number telling whose turn it is:
+ * 'seq == pos'		The cell is free for the producer enqueuing at 'pos'.
+ * 'seq == pos + 1'	The cell is full for the consumer dequeuing at 'pos'.
+ * Producers and consumers claim positions with a CAS on 'tail' and
+ * 'head', which live on separate cache lines. */
+typedef struct nmmpmc_cell_s {
+	atomic_size_t seq;
+	void *data;
+} nmmpmc_cell;
+
+struct nmmpmc_s {
+	void (*destructor)(void *data);
+	nmmpmc_cell *cells;
+	size_t mask;
+	char pad0[NM_CACHE_LINE];
+	atomic_size_t tail;
+	char pad1[NM_CACHE_LINE - sizeof(atomic_size_t)];
+	atomic_size_t head;
+	char pad2[NM_CACHE_LINE - sizeof(atomic_size_t)];
+};
+
+/**
+ * Allocates memory for a new bounded lock-free queue.
+ *
+ * INPUT:
+ * 'capacity'		Maximum number of elements, rounded up to
+ * 					a power of two (at least 2).
+ * 'destructor'		Destructor for 'data' being hold by the queue.
+ *
+ * RETURNS:
+ * NULL				If memory allocation fails.
+ * A new queue.
+ **/
+nmmpmc *nmmpmc_alloc(unsigned int capacity, void (*destructor)(void *data))
+{
+	nmmpmc *queue = NULL;
+	size_t cap = 2, i;
+	while (cap < capacity) {
+		cap <<= 1;
+	}
+	if ((queue = calloc(1, sizeof(*queue))) == NULL) {
+		return NULL;
+	}
+	if ((queue->cells = malloc(cap * sizeof(*queue->cells))) == NULL) {
+		free(queue);
+		return NULL;
+	}
+	for (i = 0; i < cap; i++) {
+		atomic_init(&queue->cells[i].seq, i);
+		queue->cells[i].data = NULL;
+	}
+	queue->destructor = destructor;
+	queue->mask = cap - 1;
+	atomic_init(&queue->tail, 0);
+	atomic_init(&queue->head, 0);
+	return queue;
+}
+
+/**
+ * De-allocates memory for the queue. The data still
+ * being hold by the queue is purged.
+ *
+ * Must not be called while other threads use the queue.
+ *
+ * RETURNS:
+ * 0				If queue was succesfuly de-allocated.
+ * -1				If something went wrong (queue is NULL,
+ * 					destructor is NULL).
+ **/
+int nmmpmc_free(nmmpmc *queue)
+{
+	void *data;
+	if (queue == NULL || queue->destructor == NULL) {
+		return (-1);
+	}
+	while (nmmpmc_try_dequeue(queue, &data) == 0) {
+		if (data != NULL) {
+			queue->destructor(data);
+		}
+	}
+	free(queue->cells);
+	free(queue);
+	return (0);
+}
+
+/**
+ * Tries to enqueue 'data' without blocking.
+ *
+ * INPUT:
+ * 'queue'			The queue.
+ * 'data'			The data to be inserted.
+ *
+ * RETURNS:
+ * 0				If insertion was succesful.
+ * -1				If the queue is full or NULL.
+ **/
+int nmmpmc_try_enqueue(nmmpmc *queue, const void *data)
+{
+	nmmpmc_cell *cell;
+	size_t pos, seq;
+	intptr_t dif;
+	if (queue == NULL) {
+		return (-1);
+	}
+	pos = atomic_load_explicit(&queue->tail, memory_order_relaxed);
+	for (;;) {
+		cell = &queue->cells[pos & queue->mask];
+		seq = atomic_load_explicit(&cell->seq, memory_order_acquire);
+		dif = (intptr_t) seq - (intptr_t) pos;
+		if (dif == 0) {
+			if (atomic_compare_exchange_weak_explicit(&queue->tail, &pos, pos + 1,
+			        memory_order_relaxed, memory_order_relaxed)) {
+				break;
+			}
+		} else if (dif < 0) {
+			return (-1);
+		} else {
+			pos = atomic_load_explicit(&queue->tail, memory_order_relaxed);
+		}
+	}
+	cell->data = (void*) data;
+	atomic_store_explicit(&cell->seq, pos + 1, memory_order_release);
+	return (0);
+}
+
+/**
+ * Tries to dequeue an element without blocking.
+ *
+ * INPUT:
+ * 'queue'			The queue.
+ * 'data'			Where the dequeued data is stored.
+ *
+ * RETURNS:
+ * 0				If an element was dequeued into '*data'.
+ * -1				If the queue is empty or NULL.
+ **/
+int nmmpmc_try_dequeue(nmmpmc *queue, void **data)
+{
+	nmmpmc_cell *cell;
+	size_t pos, seq;
+	intptr_t dif;
+	if (queue == NULL || data == NULL) {
+		return (-1);
+	}
+	pos = atomic_load_explicit(&queue->head, memory_order_relaxed);
+	for (;;) {
+		cell = &queue->cells[pos & queue->mask];
+		seq = atomic_load_explicit(&cell->seq, memory_order_acquire);
+		dif = (intptr_t) seq - (intptr_t) (pos + 1);
+		if (dif == 0) {
+			if (atomic_compare_exchange_weak_explicit(&queue->head, &pos, pos + 1,
+			        memory_order_relaxed, memory_order_relaxed)) {
+				break;
+			}
+		} else if (dif < 0) {
+			return (-1);
+		} else {
+			pos = atomic_load_explicit(&queue->head, memory_order_relaxed);
+		}
+	}
+	*data = cell->data;
+	atomic_store_explicit(&cell->seq, pos + queue->mask + 1, memory_order_release);
+	return (0);
+}
+
+/**
+ * Enqueue 'data' into the queue, spinning (and yielding
+ * the processor) while the queue is full.
+ *
+ * RETURNS:
+ * 0				If insertion was succesful.
+ * -1				If queue is NULL.
+ **/
+int nmmpmc_enqueue(nmmpmc *queue, const void *data)
+{
+	if (queue == NULL) {
+		return (-1);
+	}
+	while (nmmpmc_try_enqueue(queue, data) != 0) {
+		sched_yield();
+	}
+	return (0);
+}
+
+/**
+ * Dequeue 'data' from the queue, spinning (and yielding
+ * the processor) while the queue is empty.
+ *
+ * RETURNS:
+ * NULL				If queue is NULL or data is NULL.
+ * 'data'
+ **/
+void *nmmpmc_dequeue(nmmpmc *queue)
+{
+	void *data = NULL;
+	if (queue == NULL) {
+		return NULL;
+	}
+	while (nmmpmc_try_dequeue(queue, &data) != 0) {
+		sched_yield();
+	}
+	return data;
+}
+
+/**
+ * Tries to dequeue an element and purges its data.
+ *
+ * RETURNS:
+ * 0				If an element was purged.
+ * -1				If the queue is empty, NULL or has no destructor.
+ **/
+int nmmpmc_purge(nmmpmc *queue)
+{
+	void *data;
+	if (queue == NULL || queue->destructor == NULL ||
+	        nmmpmc_try_dequeue(queue, &data) != 0) {
+		return (-1);
+	}
+	if (data != NULL) {
+		queue->destructor(data);
+	}
+	return (0);
+}
+
+/**
+ * Returns the number of elements in the queue.
+ *
+ * While other threads operate on the queue the value is
+ * only a snapshot.
+ **/
+unsigned int nmmpmc_size(nmmpmc *queue)
+{
+	size_t head, tail;
+	if (queue == NULL) {
+		return 0;
+	}
+	head = atomic_load_explicit(&queue->head, memory_order_relaxed);
+	tail = atomic_load_explicit(&queue->tail, memory_order_relaxed);
+	return (tail > head) ? (unsigned int) (tail - head) : 0;
+}
+
+/**
+ * Returns the maximum number of elements the queue can hold.
+ **/
+unsigned int nmmpmc_capacity(nmmpmc *queue)
+{
+	return (queue == NULL) ? 0 : (unsigned int) (queue->mask + 1);
+}
@@ -0,0 +1,18 @@
+#ifndef __NM__MPMC__H__
+#define __NM__MPMC__H__
+#include "nmaux.h"
+
+typedef struct nmmpmc_s nmmpmc;
+
+nmmpmc *nmmpmc_alloc(unsigned int capacity, void (*destructor)(void *data));
+int nmmpmc_free(nmmpmc *queue);
+
+int nmmpmc_enqueue(nmmpmc *queue, const void *data);
+void *nmmpmc_dequeue(nmmpmc *queue);
+int nmmpmc_try_enqueue(nmmpmc *queue, const void *data);
+int nmmpmc_try_dequeue(nmmpmc *queue, void **data);
+int nmmpmc_purge(nmmpmc *queue);
+unsigned int nmmpmc_size(nmmpmc *queue);
+unsigned int nmmpmc_capacity(nmmpmc *queue);
+
+#endif
@@ -1,6 +1,210 @@
 #include <stdlib.h>
+#include <string.h>
 #include "nmqueue.h"
 
+/* A queue is either backed by a linked list ('list' != NULL) or
+ * by a circular buffer ('ring'), whose capacity is always a power
+ * of two so positions are wrapped with a mask. */
+struct nmqueue_s {
+	void (*destructor)(void *data);
+	nmlist *list;
+	void **ring;
+	unsigned int capacity;
+	unsigned int head;
+	unsigned int size;
+	const nm_allocator *allocator;
+};
+
+/**
+ * THIS FUNCTION IS PRIVATE.
+ * Wraps 'list' into a new queue. If memory allocation
+ * fails 'list' is de-allocated.
+ **/
+static nmqueue *nmqueue_alloc_list(nmlist *list, void (*destructor)(void *data),
+                                   const nm_allocator *allocator)
+{
+	nmqueue *queue = NULL;
+	if (list == NULL) {
+		return NULL;
+	}
+	if ((queue = nm_calloc(allocator, 1, sizeof(*queue))) == NULL) {
+		nmlist_free(list);
+		return NULL;
+	}
+	queue->destructor = destructor;
+	queue->list = list;
+	queue->ring = NULL;
+	queue->allocator = allocator;
+	return queue;
+}
+
+/**
+ * Allocates memory for a new list backed queue.
+ *
+ * INPUT:
+ * 'destructor'		Destructor for 'data' being hold by the queue.
+ *
+ * RETURNS:
+ * NULL				If memory allocation fails.
+ * A new queue.
+ **/
+nmqueue *nmqueue_alloc(void (*destructor)(void *data))
+{
+	return nmqueue_alloc_with(destructor, NULL);
+}
+
+/**
+ * Allocates memory for a new list backed queue, whose memory
+ * (the queue, the list and its elements) comes from 'allocator'.
+ *
+ * INPUT:
+ * 'destructor'		Destructor for 'data' being hold by the queue.
+ * 'allocator'		The allocator (NULL for malloc / free).
+ *
+ * RETURNS:
+ * NULL				If memory allocation fails.
+ * A new queue.
+ **/
+nmqueue *nmqueue_alloc_with(void (*destructor)(void *data),
+                            const nm_allocator *allocator)
+{
+	return nmqueue_alloc_list(nmlist_alloc_with(destructor, allocator),
+	                          destructor, allocator);
+}
+
+/**
+ * Allocates memory for a new list backed queue, whose
+ * elements are taken from 'pool' (see 'nmlist_alloc_pool').
+ *
+ * INPUT:
+ * 'destructor'		Destructor for 'data' being hold by the queue.
+ * 'pool'			Element pool, NULL for a private one.
+ *
+ * RETURNS:
+ * NULL				If memory allocation fails.
+ * A new queue.
+ **/
+nmqueue *nmqueue_alloc_pool(void (*destructor)(void *data), nmlist_pool *pool)
+{
+	return nmqueue_alloc_list(nmlist_alloc_pool(destructor, pool), destructor, NULL);
+}
+
+/**
+ * Allocates memory for a new queue backed by a circular buffer.
+ *
+ * The buffer capacity is a power of two and is doubled every
+ * time the queue is full, so after warm-up enqueue / dequeue
+ * don't allocate memory anymore.
+ *
+ * INPUT:
+ * 'icap'			Initial capacity (rounded up to a power of two).
+ * 'destructor'		Destructor for 'data' being hold by the queue.
+ *
+ * RETURNS:
+ * NULL				If memory allocation fails.
+ * A new queue.
+ **/
+nmqueue *nmqueue_alloc_ring(unsigned int icap, void (*destructor)(void *data))
+{
+	return nmqueue_alloc_ring_with(icap, destructor, NULL);
+}
+
+/**
+ * Allocates memory for a new ring backed queue, whose memory
+ * (the queue and its buffer) comes from 'allocator'.
+ *
+ * INPUT:
+ * 'icap'			Initial capacity (rounded up to a power of two).
+ * 'destructor'		Destructor for 'data' being hold by the queue.
+ * 'allocator'		The allocator (NULL for malloc / free).
+ *
+ * RETURNS:
+ * NULL				If memory allocation fails.
+ * A new queue.
+ **/
+nmqueue *nmqueue_alloc_ring_with(unsigned int icap, void (*destructor)(void *data),
+                                 const nm_allocator *allocator)
+{
+	nmqueue *queue = NULL;
+	unsigned int cap = 1;
+	while (cap < icap && cap <= (~0u >> 1)) {
+		cap <<= 1;
+	}
+	if ((queue = nm_calloc(allocator, 1, sizeof(*queue))) == NULL) {
+		return NULL;
+	}
+	if ((queue->ring = nm_malloc(allocator, cap * sizeof(*queue->ring))) == NULL) {
+		nm_free(allocator, queue);
+		return NULL;
+	}
+	queue->allocator = allocator;
+	queue->destructor = destructor;
+	queue->list = NULL;
+	queue->capacity = cap;
+	queue->head = 0;
+	queue->size = 0;
+	return queue;
+}
+
+/**
+ * De-allocates memory for the queue. The data still
+ * being hold by the queue is purged.
+ *
+ * RETURNS:
+ * 0				If queue was succesfuly de-allocated.
+ * -1				If something went wrong (queue is NULL,
+ * 					destructor is NULL).
+ **/
+int nmqueue_free(nmqueue *queue)
+{
+	if (queue == NULL || queue->destructor == NULL) {
+		return (-1);
+	}
+	if (queue->list != NULL) {
+		nmlist_free(queue->list);
+	} else {
+		while (queue->size > 0) {
+			nmqueue_purge(queue);
+		}
+		nm_free(queue->allocator, queue->ring);
+	}
+	nm_free(queue->allocator, queue);
+	return (0);
+}
+
+/**
+ * THIS FUNCTION IS PRIVATE.
+ * Doubles the capacity of a ring backed queue.
+ *
+ * The elements that wrapped around the end of the old buffer
+ * are moved right after the old end, so the queue stays
+ * contiguous (modulo the new capacity).
+ *
+ * RETURNS:
+ * 0				If the buffer was succesfuly expanded.
+ * -1				If memory re-allocation failed.
+ **/
+static int nmqueue_expand(nmqueue *queue)
+{
+	void **tmp_ring;
+	unsigned int wrapped;
+	if (queue->capacity > (~0u >> 1)) {
+		return (-1);
+	}
+	tmp_ring = nm_realloc(queue->allocator, queue->ring,
+	                      2 * queue->capacity * sizeof(*tmp_ring));
+	if (tmp_ring == NULL) {
+		return (-1);
+	}
+	if (queue->head + queue->size > queue->capacity) {
+		wrapped = queue->head + queue->size - queue->capacity;
+		memcpy(tmp_ring + queue->capacity, tmp_ring, wrapped * sizeof(*tmp_ring));
+	}
+	queue->ring = tmp_ring;
+	queue->capacity *= 2;
+	return (0);
+}
+
 /**
  * Enqueue 'data' into the queue.
  * (Inserts at tail).
@@ -15,7 +219,18 @@
  **/
 int nmqueue_enqueue(nmqueue *queue, const void *data)
 {
-	return nmlist_insert_next(queue, nmlist_tail(queue), data);
+	if (queue == NULL) {
+		return (-1);
+	}
+	if (queue->list != NULL) {
+		return nmlist_insert_next(queue->list, nmlist_tail(queue->list), data);
+	}
+	if (queue->size == queue->capacity && nmqueue_expand(queue) != 0) {
+		return (-1);
+	}
+	queue->ring[(queue->head + queue->size) & (queue->capacity - 1)] = (void*) data;
+	queue->size++;
+	return (0);
 }
 
 /**
@@ -31,7 +246,20 @@ int nmqueue_enqueue(nmqueue *queue, const void *data)
  **/
 void *nmqueue_dequeue(nmqueue *queue)
 {
-	return nmlist_remove_next(queue, NULL);
+	void *data;
+	if (queue == NULL) {
+		return NULL;
+	}
+	if (queue->list != NULL) {
+		return nmlist_remove_next(queue->list, NULL);
+	}
+	if (queue->size == 0) {
+		return NULL;
+	}
+	data = queue->ring[queue->head];
+	queue->head = (queue->head + 1) & (queue->capacity - 1);
+	queue->size--;
+	return data;
 }
 
 
@@ -48,7 +276,17 @@ void *nmqueue_dequeue(nmqueue *queue)
  **/
 int nmqueue_purge(nmqueue *queue)
 {
-	return nmlist_purge_next(queue, NULL);
+	void *data;
+	if (queue == NULL || queue->destructor == NULL) {
+		return (-1);
+	}
+	if (queue->list != NULL) {
+		return nmlist_purge_next(queue->list, NULL);
+	}
+	if ((data = nmqueue_dequeue(queue)) != NULL) {
+		queue->destructor(data);
+	}
+	return (0);
 }
 
 /**
@@ -64,7 +302,13 @@ int nmqueue_purge(nmqueue *queue)
  **/
 void *nmqueue_peek(nmqueue *queue)
 {
-	return nmlist_get_data(nmlist_head(queue));
+	if (queue == NULL) {
+		return NULL;
+	}
+	if (queue->list != NULL) {
+		return nmlist_get_data(nmlist_head(queue->list));
+	}
+	return (queue->size == 0) ? NULL : queue->ring[queue->head];
 }
 
 /**
@@ -75,5 +319,8 @@ void *nmqueue_peek(nmqueue *queue)
  **/
 unsigned int nmqueue_size(nmqueue *queue)
 {
-	return nmlist_size(queue);
+	if (queue == NULL) {
+		return 0;
+	}
+	return (queue->list != NULL) ? nmlist_size(queue->list) : queue->size;
 }
\ No newline at end of file
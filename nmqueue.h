@@ -2,10 +2,16 @@
 #define __NM__QUEUE__H__
 #include "nmlist.h"
 
-typedef nmlist nmqueue;
+typedef struct nmqueue_s nmqueue;
 
-#define nmqueue_alloc nmlist_alloc;
-#define nmqueue_free nmlist_free;
+nmqueue *nmqueue_alloc(void (*destructor)(void *data));
+nmqueue *nmqueue_alloc_pool(void (*destructor)(void *data), nmlist_pool *pool);
+nmqueue *nmqueue_alloc_ring(unsigned int icap, void (*destructor)(void *data));
+nmqueue *nmqueue_alloc_with(void (*destructor)(void *data),
+                            const nm_allocator *allocator);
+nmqueue *nmqueue_alloc_ring_with(unsigned int icap, void (*destructor)(void *data),
+                                 const nm_allocator *allocator);
+int nmqueue_free(nmqueue *queue);
 
 int nmqueue_enqueue(nmqueue *queue, const void *data);
 void *nmqueue_dequeue(nmqueue *queue);
@@ -0,0 +1,554 @@
+#include <limits.h>
+#include <stdatomic.h>
+#include <string.h>
+#include "nmsearch.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define NMSEARCH_X86 1
+#include <immintrin.h>
+#endif
+
+/* Equality search kernels over arrays of 32 / 64 bit keys.
+ *
+ * Every kernel has a scalar version and, on x86 with GCC / Clang, an
+ * SSE (SSE2 for 32 bit keys, SSE4.1 for 64 bit keys) and an AVX2
+ * version compiled with 'target' attributes. The best version the
+ * running CPU supports is picked on first use, so the library itself
+ * doesn't need to be built with '-mavx2'.
+ *
+ * Keys are only read through 'memcpy' or unaligned vector loads, so
+ * 'array' may point to any storage of 32 / 64 bit values (pointers,
+ * 'nmarray' element blocks, ...) without breaking strict aliasing. */
+typedef struct nmsearch_kernels_s {
+	const char *isa;
+	int (*find32)(const uint32_t *array, unsigned int n, uint32_t key);
+	int (*find64)(const uint64_t *array, unsigned int n, uint64_t key);
+	unsigned int (*bitmap32)(const uint32_t *array, unsigned int n,
+	                         uint32_t key, uint64_t *bitmap);
+	unsigned int (*bitmap64)(const uint64_t *array, unsigned int n,
+	                         uint64_t key, uint64_t *bitmap);
+} nmsearch_kernels;
+
+/* Number of elements scanned per call to the bitmap kernel by
+ * 'nmsearch_all32' / 'nmsearch_all64'. */
+#define NMSEARCH_BLOCK 4096
+
+/**
+ * THIS FUNCTION IS PRIVATE.
+ * Counts the bits set in 'word'.
+ **/
+static unsigned int nmsearch_popcount(uint64_t word)
+{
+#if defined(__GNUC__)
+	return (unsigned int) __builtin_popcountll(word);
+#else
+	unsigned int count = 0;
+	while (word != 0) {
+		word &= word - 1;
+		count++;
+	}
+	return count;
+#endif
+}
+
+/**
+ * THIS FUNCTION IS PRIVATE.
+ * Returns the index of the lowest bit set in 'word' (not 0).
+ **/
+static unsigned int nmsearch_ctz(uint64_t word)
+{
+#if defined(__GNUC__)
+	return (unsigned int) __builtin_ctzll(word);
+#else
+	unsigned int i = 0;
+	while ((word & 1) == 0) {
+		word >>= 1;
+		i++;
+	}
+	return i;
+#endif
+}
+
+/**
+ * THIS FUNCTION IS PRIVATE.
+ * Reads the 32 bit key at 'p', whatever the type of the object.
+ **/
+static inline uint32_t nmsearch_load32(const uint32_t *p)
+{
+	uint32_t key;
+	memcpy(&key, p, sizeof(key));
+	return key;
+}
+
+/**
+ * THIS FUNCTION IS PRIVATE.
+ * Reads the 64 bit key at 'p', whatever the type of the object.
+ **/
+static inline uint64_t nmsearch_load64(const uint64_t *p)
+{
+	uint64_t key;
+	memcpy(&key, p, sizeof(key));
+	return key;
+}
+
+static int nmsearch_find32_scalar(const uint32_t *array, unsigned int n, uint32_t key)
+{
+	unsigned int i;
+	for (i = 0; i < n; i++) {
+		if (nmsearch_load32(array + i) == key) {
+			return (int) i;
+		}
+	}
+	return (-1);
+}
+
+static int nmsearch_find64_scalar(const uint64_t *array, unsigned int n, uint64_t key)
+{
+	unsigned int i;
+	for (i = 0; i < n; i++) {
+		if (nmsearch_load64(array + i) == key) {
+			return (int) i;
+		}
+	}
+	return (-1);
+}
+
+static unsigned int nmsearch_bitmap32_scalar(const uint32_t *array, unsigned int n,
+        uint32_t key, uint64_t *bitmap)
+{
+	unsigned int i, count = 0;
+	for (i = 0; i < n; i++) {
+		if (nmsearch_load32(array + i) == key) {
+			bitmap[i / 64] |= (uint64_t) 1 << (i % 64);
+			count++;
+		}
+	}
+	return count;
+}
+
+static unsigned int nmsearch_bitmap64_scalar(const uint64_t *array, unsigned int n,
+        uint64_t key, uint64_t *bitmap)
+{
+	unsigned int i, count = 0;
+	for (i = 0; i < n; i++) {
+		if (nmsearch_load64(array + i) == key) {
+			bitmap[i / 64] |= (uint64_t) 1 << (i % 64);
+			count++;
+		}
+	}
+	return count;
+}
+
+static const nmsearch_kernels nmsearch_scalar = {
+	"scalar",
+	nmsearch_find32_scalar,
+	nmsearch_find64_scalar,
+	nmsearch_bitmap32_scalar,
+	nmsearch_bitmap64_scalar
+};
+
+#if defined(NMSEARCH_X86)
+
+__attribute__((target("sse2")))
+static int nmsearch_find32_sse(const uint32_t *array, unsigned int n, uint32_t key)
+{
+	__m128i k = _mm_set1_epi32((int) key), a, b;
+	unsigned int i = 0, mask;
+	for (; i + 8 <= n; i += 8) {
+		a = _mm_cmpeq_epi32(_mm_loadu_si128((const __m128i*) (array + i)), k);
+		b = _mm_cmpeq_epi32(_mm_loadu_si128((const __m128i*) (array + i + 4)), k);
+		mask = (unsigned int) _mm_movemask_ps(_mm_castsi128_ps(a)) |
+		       (unsigned int) _mm_movemask_ps(_mm_castsi128_ps(b)) << 4;
+		if (mask != 0) {
+			return (int) (i + nmsearch_ctz(mask));
+		}
+	}
+	for (; i < n; i++) {
+		if (nmsearch_load32(array + i) == key) {
+			return (int) i;
+		}
+	}
+	return (-1);
+}
+
+__attribute__((target("sse4.1")))
+static int nmsearch_find64_sse(const uint64_t *array, unsigned int n, uint64_t key)
+{
+	__m128i k = _mm_set1_epi64x((long long) key), a, b;
+	unsigned int i = 0, mask;
+	for (; i + 4 <= n; i += 4) {
+		a = _mm_cmpeq_epi64(_mm_loadu_si128((const __m128i*) (array + i)), k);
+		b = _mm_cmpeq_epi64(_mm_loadu_si128((const __m128i*) (array + i + 2)), k);
+		mask = (unsigned int) _mm_movemask_pd(_mm_castsi128_pd(a)) |
+		       (unsigned int) _mm_movemask_pd(_mm_castsi128_pd(b)) << 2;
+		if (mask != 0) {
+			return (int) (i + nmsearch_ctz(mask));
+		}
+	}
+	for (; i < n; i++) {
+		if (nmsearch_load64(array + i) == key) {
+			return (int) i;
+		}
+	}
+	return (-1);
+}
+
+__attribute__((target("sse2")))
+static unsigned int nmsearch_bitmap32_sse(const uint32_t *array, unsigned int n,
+        uint32_t key, uint64_t *bitmap)
+{
+	__m128i k = _mm_set1_epi32((int) key), c;
+	unsigned int i = 0, j, count = 0;
+	uint64_t word;
+	for (; i + 64 <= n; i += 64) {
+		word = 0;
+		for (j = 0; j < 64; j += 4) {
+			c = _mm_cmpeq_epi32(_mm_loadu_si128((const __m128i*) (array + i + j)), k);
+			word |= (uint64_t) _mm_movemask_ps(_mm_castsi128_ps(c)) << j;
+		}
+		bitmap[i / 64] |= word;
+		count += nmsearch_popcount(word);
+	}
+	for (; i < n; i++) {
+		if (nmsearch_load32(array + i) == key) {
+			bitmap[i / 64] |= (uint64_t) 1 << (i % 64);
+			count++;
+		}
+	}
+	return count;
+}
+
+__attribute__((target("sse4.1")))
+static unsigned int nmsearch_bitmap64_sse(const uint64_t *array, unsigned int n,
+        uint64_t key, uint64_t *bitmap)
+{
+	__m128i k = _mm_set1_epi64x((long long) key), c;
+	unsigned int i = 0, j, count = 0;
+	uint64_t word;
+	for (; i + 64 <= n; i += 64) {
+		word = 0;
+		for (j = 0; j < 64; j += 2) {
+			c = _mm_cmpeq_epi64(_mm_loadu_si128((const __m128i*) (array + i + j)), k);
+			word |= (uint64_t) _mm_movemask_pd(_mm_castsi128_pd(c)) << j;
+		}
+		bitmap[i / 64] |= word;
+		count += nmsearch_popcount(word);
+	}
+	for (; i < n; i++) {
+		if (nmsearch_load64(array + i) == key) {
+			bitmap[i / 64] |= (uint64_t) 1 << (i % 64);
+			count++;
+		}
+	}
+	return count;
+}
+
+static const nmsearch_kernels nmsearch_sse = {
+	"sse4.1",
+	nmsearch_find32_sse,
+	nmsearch_find64_sse,
+	nmsearch_bitmap32_sse,
+	nmsearch_bitmap64_sse
+};
+
+/* CPUs with SSE2 but no SSE4.1 (no 64 bit 'pcmpeqq'): SSE for 32 bit
+ * keys, scalar for 64 bit keys. */
+static const nmsearch_kernels nmsearch_sse2 = {
+	"sse2",
+	nmsearch_find32_sse,
+	nmsearch_find64_scalar,
+	nmsearch_bitmap32_sse,
+	nmsearch_bitmap64_scalar
+};
+
+__attribute__((target("avx2")))
+static int nmsearch_find32_avx2(const uint32_t *array, unsigned int n, uint32_t key)
+{
+	__m256i k = _mm256_set1_epi32((int) key), a, b, c, d;
+	unsigned int i = 0;
+	uint64_t mask;
+	/* 32 keys per iteration, the exact position is only computed
+	 * once a block has a match */
+	for (; i + 32 <= n; i += 32) {
+		a = _mm256_cmpeq_epi32(_mm256_loadu_si256((const __m256i*) (array + i)), k);
+		b = _mm256_cmpeq_epi32(_mm256_loadu_si256((const __m256i*) (array + i + 8)), k);
+		c = _mm256_cmpeq_epi32(_mm256_loadu_si256((const __m256i*) (array + i + 16)), k);
+		d = _mm256_cmpeq_epi32(_mm256_loadu_si256((const __m256i*) (array + i + 24)), k);
+		if (!_mm256_testz_si256(_mm256_or_si256(_mm256_or_si256(a, b),
+		                        _mm256_or_si256(c, d)), _mm256_set1_epi32(-1))) {
+			mask = (uint64_t) _mm256_movemask_ps(_mm256_castsi256_ps(a)) |
+			       (uint64_t) _mm256_movemask_ps(_mm256_castsi256_ps(b)) << 8 |
+			       (uint64_t) _mm256_movemask_ps(_mm256_castsi256_ps(c)) << 16 |
+			       (uint64_t) _mm256_movemask_ps(_mm256_castsi256_ps(d)) << 24;
+			return (int) (i + nmsearch_ctz(mask));
+		}
+	}
+	for (; i < n; i++) {
+		if (nmsearch_load32(array + i) == key) {
+			return (int) i;
+		}
+	}
+	return (-1);
+}
+
+__attribute__((target("avx2")))
+static int nmsearch_find64_avx2(const uint64_t *array, unsigned int n, uint64_t key)
+{
+	__m256i k = _mm256_set1_epi64x((long long) key), a, b, c, d;
+	unsigned int i = 0;
+	uint64_t mask;
+	for (; i + 16 <= n; i += 16) {
+		a = _mm256_cmpeq_epi64(_mm256_loadu_si256((const __m256i*) (array + i)), k);
+		b = _mm256_cmpeq_epi64(_mm256_loadu_si256((const __m256i*) (array + i + 4)), k);
+		c = _mm256_cmpeq_epi64(_mm256_loadu_si256((const __m256i*) (array + i + 8)), k);
+		d = _mm256_cmpeq_epi64(_mm256_loadu_si256((const __m256i*) (array + i + 12)), k);
+		if (!_mm256_testz_si256(_mm256_or_si256(_mm256_or_si256(a, b),
+		                        _mm256_or_si256(c, d)), _mm256_set1_epi32(-1))) {
+			mask = (uint64_t) _mm256_movemask_pd(_mm256_castsi256_pd(a)) |
+			       (uint64_t) _mm256_movemask_pd(_mm256_castsi256_pd(b)) << 4 |
+			       (uint64_t) _mm256_movemask_pd(_mm256_castsi256_pd(c)) << 8 |
+			       (uint64_t) _mm256_movemask_pd(_mm256_castsi256_pd(d)) << 12;
+			return (int) (i + nmsearch_ctz(mask));
+		}
+	}
+	for (; i < n; i++) {
+		if (nmsearch_load64(array + i) == key) {
+			return (int) i;
+		}
+	}
+	return (-1);
+}
+
+__attribute__((target("avx2")))
+static unsigned int nmsearch_bitmap32_avx2(const uint32_t *array, unsigned int n,
+        uint32_t key, uint64_t *bitmap)
+{
+	__m256i k = _mm256_set1_epi32((int) key), c;
+	unsigned int i = 0, j, count = 0;
+	uint64_t word;
+	for (; i + 64 <= n; i += 64) {
+		word = 0;
+		for (j = 0; j < 64; j += 8) {
+			c = _mm256_cmpeq_epi32(_mm256_loadu_si256((const __m256i*) (array + i + j)), k);
+			word |= (uint64_t) _mm256_movemask_ps(_mm256_castsi256_ps(c)) << j;
+		}
+		bitmap[i / 64] |= word;
+		count += nmsearch_popcount(word);
+	}
+	for (; i < n; i++) {
+		if (nmsearch_load32(array + i) == key) {
+			bitmap[i / 64] |= (uint64_t) 1 << (i % 64);
+			count++;
+		}
+	}
+	return count;
+}
+
+__attribute__((target("avx2")))
+static unsigned int nmsearch_bitmap64_avx2(const uint64_t *array, unsigned int n,
+        uint64_t key, uint64_t *bitmap)
+{
+	__m256i k = _mm256_set1_epi64x((long long) key), c;
+	unsigned int i = 0, j, count = 0;
+	uint64_t word;
+	for (; i + 64 <= n; i += 64) {
+		word = 0;
+		for (j = 0; j < 64; j += 4) {
+			c = _mm256_cmpeq_epi64(_mm256_loadu_si256((const __m256i*) (array + i + j)), k);
+			word |= (uint64_t) _mm256_movemask_pd(_mm256_castsi256_pd(c)) << j;
+		}
+		bitmap[i / 64] |= word;
+		count += nmsearch_popcount(word);
+	}
+	for (; i < n; i++) {
+		if (nmsearch_load64(array + i) == key) {
+			bitmap[i / 64] |= (uint64_t) 1 << (i % 64);
+			count++;
+		}
+	}
+	return count;
+}
+
+static const nmsearch_kernels nmsearch_avx2 = {
+	"avx2",
+	nmsearch_find32_avx2,
+	nmsearch_find64_avx2,
+	nmsearch_bitmap32_avx2,
+	nmsearch_bitmap64_avx2
+};
+
+#endif
+
+/**
+ * THIS FUNCTION IS PRIVATE.
+ * Returns the kernels for the running CPU, selecting them on
+ * the first call.
+ **/
+static const nmsearch_kernels *nmsearch_impl(void)
+{
+	static _Atomic(const nmsearch_kernels*) impl = NULL;
+	const nmsearch_kernels *kernels;
+	kernels = atomic_load_explicit(&impl, memory_order_relaxed);
+	if (kernels == NULL) {
+		kernels = &nmsearch_scalar;
+#if defined(NMSEARCH_X86)
+		__builtin_cpu_init();
+		if (__builtin_cpu_supports("avx2")) {
+			kernels = &nmsearch_avx2;
+		} else if (__builtin_cpu_supports("sse4.1")) {
+			kernels = &nmsearch_sse;
+		} else if (__builtin_cpu_supports("sse2")) {
+			kernels = &nmsearch_sse2;
+		}
+#endif
+		atomic_store_explicit(&impl, kernels, memory_order_relaxed);
+	}
+	return kernels;
+}
+
+/**
+ * Returns the index of the first element of 'array' equal to 'key'.
+ *
+ * INPUT:
+ * 'array'			Array of 'n' keys.
+ * 'n'				Number of keys.
+ * 'key'			Key to look for.
+ *
+ * RETURNS:
+ * The index of the first match.
+ * -1				If there is no match, array is NULL or 'n' is
+ * 					bigger than INT_MAX (the index wouldn't fit).
+ **/
+int nmsearch_find32(const uint32_t *array, unsigned int n, uint32_t key)
+{
+	if (array == NULL || n > INT_MAX) {
+		return (-1);
+	}
+	return nmsearch_impl()->find32(array, n, key);
+}
+
+/**
+ * 64 bit keys version of 'nmsearch_find32'.
+ **/
+int nmsearch_find64(const uint64_t *array, unsigned int n, uint64_t key)
+{
+	if (array == NULL || n > INT_MAX) {
+		return (-1);
+	}
+	return nmsearch_impl()->find64(array, n, key);
+}
+
+/**
+ * Sets bit 'i' of 'bitmap' for every element 'array[i]' equal to
+ * 'key'. 'bitmap' must hold '(n+63)/64' words; it is cleared first.
+ *
+ * RETURNS:
+ * The number of matches.
+ **/
+unsigned int nmsearch_bitmap32(const uint32_t *array, unsigned int n,
+                               uint32_t key, uint64_t *bitmap)
+{
+	if (array == NULL || bitmap == NULL) {
+		return 0;
+	}
+	memset(bitmap, 0, ((n + 63) / 64) * sizeof(*bitmap));
+	return nmsearch_impl()->bitmap32(array, n, key, bitmap);
+}
+
+/**
+ * 64 bit keys version of 'nmsearch_bitmap32'.
+ **/
+unsigned int nmsearch_bitmap64(const uint64_t *array, unsigned int n,
+                               uint64_t key, uint64_t *bitmap)
+{
+	if (array == NULL || bitmap == NULL) {
+		return 0;
+	}
+	memset(bitmap, 0, ((n + 63) / 64) * sizeof(*bitmap));
+	return nmsearch_impl()->bitmap64(array, n, key, bitmap);
+}
+
+/**
+ * THIS FUNCTION IS PRIVATE.
+ * Writes the positions of the bits set in 'bitmap' (a 'n' elements
+ * block starting at 'base') to 'indices', up to 'limit' in total.
+ **/
+static unsigned int nmsearch_extract(const uint64_t *bitmap, unsigned int n,
+                                     unsigned int base, unsigned int *indices,
+                                     unsigned int count, unsigned int limit)
+{
+	unsigned int w;
+	uint64_t word;
+	for (w = 0; w < (n + 63) / 64 && count < limit; w++) {
+		for (word = bitmap[w]; word != 0 && count < limit; word &= word - 1) {
+			indices[count++] = base + w * 64 + nmsearch_ctz(word);
+		}
+	}
+	return count;
+}
+
+/**
+ * Writes the indexes of the elements of 'array' equal to 'key'
+ * to 'indices', in increasing order.
+ *
+ * INPUT:
+ * 'array'			Array of 'n' keys.
+ * 'n'				Number of keys.
+ * 'key'			Key to look for.
+ * 'indices'		Output buffer, NULL to only count the matches.
+ * 'limit'			Capacity of 'indices': the scan stops after
+ * 					'limit' matches (ignored if 'indices' is NULL).
+ *
+ * RETURNS:
+ * The number of matches (written to 'indices', if not NULL).
+ **/
+unsigned int nmsearch_all32(const uint32_t *array, unsigned int n, uint32_t key,
+                            unsigned int *indices, unsigned int limit)
+{
+	uint64_t bitmap[NMSEARCH_BLOCK / 64];
+	unsigned int i, block, count = 0;
+	if (array == NULL) {
+		return 0;
+	}
+	for (i = 0; i < n && (indices == NULL || count < limit); i += block) {
+		block = (n - i < NMSEARCH_BLOCK) ? n - i : NMSEARCH_BLOCK;
+		if (indices == NULL) {
+			count += nmsearch_bitmap32(array + i, block, key, bitmap);
+		} else if (nmsearch_bitmap32(array + i, block, key, bitmap) > 0) {
+			count = nmsearch_extract(bitmap, block, i, indices, count, limit);
+		}
+	}
+	return count;
+}
+
+/**
+ * 64 bit keys version of 'nmsearch_all32'.
+ **/
+unsigned int nmsearch_all64(const uint64_t *array, unsigned int n, uint64_t key,
+                            unsigned int *indices, unsigned int limit)
+{
+	uint64_t bitmap[NMSEARCH_BLOCK / 64];
+	unsigned int i, block, count = 0;
+	if (array == NULL) {
+		return 0;
+	}
+	for (i = 0; i < n && (indices == NULL || count < limit); i += block) {
+		block = (n - i < NMSEARCH_BLOCK) ? n - i : NMSEARCH_BLOCK;
+		if (indices == NULL) {
+			count += nmsearch_bitmap64(array + i, block, key, bitmap);
+		} else if (nmsearch_bitmap64(array + i, block, key, bitmap) > 0) {
+			count = nmsearch_extract(bitmap, block, i, indices, count, limit);
+		}
+	}
+	return count;
+}
+
+/**
+ * Returns the name of the instruction set used by the kernels
+ * on this CPU ("avx2", "sse4.1", "sse2" for SSE on 32 bit keys
+ * only, or "scalar").
+ **/
+const char *nmsearch_isa(void)
+{
+	return nmsearch_impl()->isa;
+}
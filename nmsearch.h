@@ -0,0 +1,17 @@
+#ifndef __NM__SEARCH__H__
+#define __NM__SEARCH__H__
+#include <stdint.h>
+
+int nmsearch_find32(const uint32_t *array, unsigned int n, uint32_t key);
+int nmsearch_find64(const uint64_t *array, unsigned int n, uint64_t key);
+unsigned int nmsearch_bitmap32(const uint32_t *array, unsigned int n,
+                               uint32_t key, uint64_t *bitmap);
+unsigned int nmsearch_bitmap64(const uint64_t *array, unsigned int n,
+                               uint64_t key, uint64_t *bitmap);
+unsigned int nmsearch_all32(const uint32_t *array, unsigned int n, uint32_t key,
+                            unsigned int *indices, unsigned int limit);
+unsigned int nmsearch_all64(const uint64_t *array, unsigned int n, uint64_t key,
+                            unsigned int *indices, unsigned int limit);
+const char *nmsearch_isa(void);
+
+#endif
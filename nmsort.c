@@ -0,0 +1,419 @@
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include "nmsort.h"
+
+/* Sorting of arrays of pointers, 'cmp' being called with the
+ * pointers themselves (the way the containers call their 'cmp'). */
+
+/* Runs shorter than this are insertion sorted. */
+#define NMSORT_INSERTION 24
+
+/* Fewest elements per slice of 'nmsort_parallel'. */
+#define NMSORT_SLICE_MIN 4096
+
+typedef int (*nmsort_cmp)(const void *e1, const void *e2);
+
+/* Work item of a parallel sort thread: either sort
+ * 'src[lo, hi)' or merge 'src[lo, mid)' and 'src[mid, hi)'
+ * into 'dst[lo, hi)'. */
+typedef struct nmsort_task_s {
+	void **src;
+	void **dst;
+	unsigned int lo;
+	unsigned int mid;
+	unsigned int hi;
+	nmsort_cmp cmp;
+} nmsort_task;
+
+/**
+ * THIS FUNCTION IS PRIVATE.
+ * Stable insertion sort of 'array[lo, hi)'.
+ **/
+static void nmsort_insertion(void **array, unsigned int lo, unsigned int hi,
+                             nmsort_cmp cmp)
+{
+	unsigned int i, j;
+	void *tmp;
+	for (i = lo + 1; i < hi; i++) {
+		tmp = array[i];
+		for (j = i; j > lo && cmp(tmp, array[j - 1]) < 0; j--) {
+			array[j] = array[j - 1];
+		}
+		array[j] = tmp;
+	}
+}
+
+/**
+ * THIS FUNCTION IS PRIVATE.
+ * Moves 'array[i]' down the max-heap 'array[lo, lo+n)'.
+ **/
+static void nmsort_sift_down(void **array, unsigned int lo, unsigned int i,
+                             unsigned int n, nmsort_cmp cmp)
+{
+	unsigned int child;
+	void *tmp = array[lo + i];
+	while ((child = 2 * i + 1) < n) {
+		if (child + 1 < n && cmp(array[lo + child], array[lo + child + 1]) < 0) {
+			child++;
+		}
+		if (cmp(array[lo + child], tmp) <= 0) {
+			break;
+		}
+		array[lo + i] = array[lo + child];
+		i = child;
+	}
+	array[lo + i] = tmp;
+}
+
+/**
+ * THIS FUNCTION IS PRIVATE.
+ * Heapsort of 'array[lo, hi)', used once quicksort recursion gets
+ * too deep.
+ **/
+static void nmsort_heap(void **array, unsigned int lo, unsigned int hi,
+                        nmsort_cmp cmp)
+{
+	unsigned int i, n = hi - lo;
+	void *tmp;
+	for (i = n / 2; i > 0; i--) {
+		nmsort_sift_down(array, lo, i - 1, n, cmp);
+	}
+	for (i = n - 1; i > 0; i--) {
+		tmp = array[lo];
+		array[lo] = array[lo + i];
+		array[lo + i] = tmp;
+		nmsort_sift_down(array, lo, 0, i, cmp);
+	}
+}
+
+/**
+ * THIS FUNCTION IS PRIVATE.
+ * Orders 'array[a]', 'array[b]', 'array[c]'.
+ **/
+static void nmsort_median3(void **array, unsigned int a, unsigned int b,
+                           unsigned int c, nmsort_cmp cmp)
+{
+	void *tmp;
+	if (cmp(array[b], array[a]) < 0) {
+		tmp = array[a]; array[a] = array[b]; array[b] = tmp;
+	}
+	if (cmp(array[c], array[b]) < 0) {
+		tmp = array[b]; array[b] = array[c]; array[c] = tmp;
+		if (cmp(array[b], array[a]) < 0) {
+			tmp = array[a]; array[a] = array[b]; array[b] = tmp;
+		}
+	}
+}
+
+/**
+ * THIS FUNCTION IS PRIVATE.
+ * Introsort of 'array[lo, hi)': quicksort with a median of three
+ * pivot, recursing on the smaller side; heapsort after 'depth'
+ * levels; insertion sort for short runs.
+ **/
+static void nmsort_introsort(void **array, unsigned int lo, unsigned int hi,
+                             unsigned int depth, nmsort_cmp cmp)
+{
+	unsigned int i, j, mid;
+	void *pivot, *tmp;
+	while (hi - lo > NMSORT_INSERTION) {
+		if (depth-- == 0) {
+			nmsort_heap(array, lo, hi, cmp);
+			return;
+		}
+		mid = lo + (hi - lo) / 2;
+		nmsort_median3(array, lo, mid, hi - 1, cmp);
+		pivot = array[mid];
+		/* Hoare partition: elements equal to the pivot are spread
+		 * over both sides, so duplicates don't degrade it */
+		i = lo;
+		j = hi - 1;
+		for (;;) {
+			while (cmp(array[++i], pivot) < 0);
+			while (cmp(pivot, array[--j]) < 0);
+			if (i >= j) {
+				break;
+			}
+			tmp = array[i];
+			array[i] = array[j];
+			array[j] = tmp;
+		}
+		/* array[lo, j] <= pivot <= array[j+1, hi) */
+		if (j + 1 - lo < hi - (j + 1)) {
+			nmsort_introsort(array, lo, j + 1, depth, cmp);
+			lo = j + 1;
+		} else {
+			nmsort_introsort(array, j + 1, hi, depth, cmp);
+			hi = j + 1;
+		}
+	}
+	nmsort_insertion(array, lo, hi, cmp);
+}
+
+/**
+ * THIS FUNCTION IS PRIVATE.
+ * Returns the recursion depth allowed to quicksort on 'n'
+ * elements (2 * log2(n)).
+ **/
+static unsigned int nmsort_depth(unsigned int n)
+{
+	unsigned int depth = 0;
+	while (n > 1) {
+		n >>= 1;
+		depth += 2;
+	}
+	return depth;
+}
+
+/**
+ * THIS FUNCTION IS PRIVATE.
+ * Stable merge of 'src[lo, mid)' and 'src[mid, hi)' into
+ * 'dst[lo, hi)'.
+ **/
+static void nmsort_merge(void **src, void **dst, unsigned int lo,
+                         unsigned int mid, unsigned int hi, nmsort_cmp cmp)
+{
+	unsigned int i = lo, j = mid, k = lo;
+	while (i < mid && j < hi) {
+		dst[k++] = (cmp(src[j], src[i]) < 0) ? src[j++] : src[i++];
+	}
+	memcpy(dst + k, src + i, (mid - i) * sizeof(*dst));
+	k += mid - i;
+	memcpy(dst + k, src + j, (hi - j) * sizeof(*dst));
+}
+
+/**
+ * Sorts 'array' in place (introsort, not stable).
+ *
+ * INPUT:
+ * 'array'			Array of 'n' pointers.
+ * 'n'				Number of elements.
+ * 'cmp'			Function comparing two elements, called with the
+ * 					pointers from the array.
+ *
+ * RETURNS:
+ * 0				If operation was succesful.
+ * -1				If array or cmp are NULL.
+ **/
+int nmsort_intro(void **array, unsigned int n, nmsort_cmp cmp)
+{
+	if (array == NULL || cmp == NULL) {
+		return (-1);
+	}
+	nmsort_introsort(array, 0, n, nmsort_depth(n), cmp);
+	return (0);
+}
+
+/**
+ * Sorts 'array' keeping equal elements in their original order
+ * (bottom-up merge sort over insertion sorted runs). Uses a
+ * temporary buffer of 'n' pointers.
+ *
+ * RETURNS:
+ * 0				If operation was succesful.
+ * -1				If array or cmp are NULL, or memory allocation
+ * 					fails (the array is left untouched).
+ **/
+int nmsort_stable(void **array, unsigned int n, nmsort_cmp cmp)
+{
+	void **buf, **src, **dst, **tmp;
+	size_t lo, mid, hi, width;
+	if (array == NULL || cmp == NULL) {
+		return (-1);
+	}
+	if (n <= NMSORT_INSERTION) {
+		nmsort_insertion(array, 0, n, cmp);
+		return (0);
+	}
+	if ((buf = malloc(n * sizeof(*buf))) == NULL) {
+		return (-1);
+	}
+	for (lo = 0; lo < n; lo += NMSORT_INSERTION) {
+		hi = (n - lo < NMSORT_INSERTION) ? n : lo + NMSORT_INSERTION;
+		nmsort_insertion(array, (unsigned int) lo, (unsigned int) hi, cmp);
+	}
+	src = array;
+	dst = buf;
+	for (width = NMSORT_INSERTION; width < n; width *= 2) {
+		for (lo = 0; lo < n; lo += 2 * width) {
+			mid = (n - lo < width) ? n : lo + width;
+			hi = (n - mid < width) ? n : mid + width;
+			nmsort_merge(src, dst, (unsigned int) lo, (unsigned int) mid,
+			             (unsigned int) hi, cmp);
+		}
+		tmp = src;
+		src = dst;
+		dst = tmp;
+	}
+	if (src != array) {
+		memcpy(array, src, n * sizeof(*array));
+	}
+	free(buf);
+	return (0);
+}
+
+/**
+ * THIS FUNCTION IS PRIVATE.
+ * Thread body of 'nmsort_parallel'.
+ **/
+static void *nmsort_run(void *arg)
+{
+	nmsort_task *task = arg;
+	if (task->dst == NULL) {
+		nmsort_introsort(task->src, task->lo, task->hi,
+		                 nmsort_depth(task->hi - task->lo), task->cmp);
+	} else {
+		nmsort_merge(task->src, task->dst, task->lo, task->mid, task->hi, task->cmp);
+	}
+	return NULL;
+}
+
+/**
+ * THIS FUNCTION IS PRIVATE.
+ * Runs 'tasks[0, n)', all but the first on new threads. Tasks
+ * whose thread can't be started run in the calling thread.
+ **/
+static void nmsort_run_all(nmsort_task *tasks, pthread_t *tids, int *started,
+                           unsigned int n)
+{
+	unsigned int i;
+	for (i = 1; i < n; i++) {
+		started[i] = (pthread_create(&tids[i], NULL, nmsort_run, &tasks[i]) == 0);
+	}
+	nmsort_run(&tasks[0]);
+	for (i = 1; i < n; i++) {
+		if (started[i]) {
+			pthread_join(tids[i], NULL);
+		} else {
+			nmsort_run(&tasks[i]);
+		}
+	}
+}
+
+/**
+ * Sorts 'array' in place using up to 'threads' threads (not
+ * stable).
+ *
+ * The array is split in 'threads' slices (fewer if they would
+ * hold less than NMSORT_SLICE_MIN elements) sorted concurrently
+ * with introsort, then the slices are merged pairwise, each
+ * round of merges running concurrently too. Arrays shorter than
+ * NMSORT_PARALLEL_MIN, or 'threads' <= 1, are sorted in the
+ * calling thread.
+ *
+ * RETURNS:
+ * 0				If operation was succesful.
+ * -1				If array or cmp are NULL, or memory allocation
+ * 					fails (the array is left untouched).
+ **/
+int nmsort_parallel(void **array, unsigned int n, nmsort_cmp cmp,
+                    unsigned int threads)
+{
+	void **buf, **src, **dst, **tmp;
+	unsigned int *bounds, slices, i, t;
+	size_t width, s;
+	nmsort_task *tasks;
+	pthread_t *tids;
+	int *started;
+	if (array == NULL || cmp == NULL) {
+		return (-1);
+	}
+	if (threads <= 1 || n < NMSORT_PARALLEL_MIN) {
+		return nmsort_intro(array, n, cmp);
+	}
+	slices = (threads < n / NMSORT_SLICE_MIN) ? threads : n / NMSORT_SLICE_MIN;
+	if (slices <= 1) {
+		return nmsort_intro(array, n, cmp);
+	}
+	buf = malloc(n * sizeof(*buf));
+	bounds = malloc((slices + 1) * sizeof(*bounds));
+	tasks = malloc(slices * sizeof(*tasks));
+	tids = malloc(slices * sizeof(*tids));
+	started = malloc(slices * sizeof(*started));
+	if (buf == NULL || bounds == NULL || tasks == NULL || tids == NULL ||
+	        started == NULL) {
+		free(buf);
+		free(bounds);
+		free(tasks);
+		free(tids);
+		free(started);
+		return (-1);
+	}
+	for (i = 0; i <= slices; i++) {
+		bounds[i] = (unsigned int) ((unsigned long long) n * i / slices);
+	}
+	for (i = 0; i < slices; i++) {
+		tasks[i].src = array;
+		tasks[i].dst = NULL;
+		tasks[i].lo = bounds[i];
+		tasks[i].hi = bounds[i + 1];
+		tasks[i].cmp = cmp;
+	}
+	nmsort_run_all(tasks, tids, started, slices);
+	src = array;
+	dst = buf;
+	for (width = 1; width < slices; width *= 2) {
+		for (s = 0, t = 0; s < slices; s += 2 * width, t++) {
+			tasks[t].src = src;
+			tasks[t].dst = dst;
+			tasks[t].lo = bounds[s];
+			tasks[t].mid = bounds[(s + width < slices) ? s + width : slices];
+			tasks[t].hi = bounds[(s + 2 * width < slices) ? s + 2 * width : slices];
+			tasks[t].cmp = cmp;
+		}
+		nmsort_run_all(tasks, tids, started, t);
+		tmp = src;
+		src = dst;
+		dst = tmp;
+	}
+	if (src != array) {
+		memcpy(array, src, n * sizeof(*array));
+	}
+	free(buf);
+	free(bounds);
+	free(tasks);
+	free(tids);
+	free(started);
+	return (0);
+}
+
+/**
+ * Returns the position of the first element of the sorted
+ * 'array' that is not less than 'data' ('n' if there is none).
+ **/
+unsigned int nmsort_lower_bound(void *const *array, unsigned int n, const void *data,
+                                nmsort_cmp cmp)
+{
+	unsigned int lo = 0, half;
+	while (n > 0) {
+		half = n / 2;
+		if (cmp(array[lo + half], data) < 0) {
+			lo += half + 1;
+			n -= half + 1;
+		} else {
+			n = half;
+		}
+	}
+	return lo;
+}
+
+/**
+ * Returns the position of the first element of the sorted
+ * 'array' that is greater than 'data' ('n' if there is none).
+ **/
+unsigned int nmsort_upper_bound(void *const *array, unsigned int n, const void *data,
+                                nmsort_cmp cmp)
+{
+	unsigned int lo = 0, half;
+	while (n > 0) {
+		half = n / 2;
+		if (cmp(data, array[lo + half]) >= 0) {
+			lo += half + 1;
+			n -= half + 1;
+		} else {
+			n = half;
+		}
+	}
+	return lo;
+}
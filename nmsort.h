@@ -0,0 +1,22 @@
+#ifndef __NM__SORT__H__
+#define __NM__SORT__H__
+
+/* Below this many elements 'nmsort_parallel' sorts in the calling
+ * thread. */
+#ifndef NMSORT_PARALLEL_MIN
+#define NMSORT_PARALLEL_MIN 65536
+#endif
+
+int nmsort_intro(void **array, unsigned int n,
+                 int (*cmp)(const void *e1, const void *e2));
+int nmsort_stable(void **array, unsigned int n,
+                  int (*cmp)(const void *e1, const void *e2));
+int nmsort_parallel(void **array, unsigned int n,
+                    int (*cmp)(const void *e1, const void *e2),
+                    unsigned int threads);
+unsigned int nmsort_lower_bound(void *const *array, unsigned int n, const void *data,
+                                int (*cmp)(const void *e1, const void *e2));
+unsigned int nmsort_upper_bound(void *const *array, unsigned int n, const void *data,
+                                int (*cmp)(const void *e1, const void *e2));
+
+#endif
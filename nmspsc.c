@@ -0,0 +1,270 @@
+#include <stdlib.h>
+#include <string.h>
+#include <stdatomic.h>
+#include "nmspsc.h"
+
+/* Single-producer / single-consumer ring.
+ *
+ * 'tail' is only written by the producer and 'head' only by the
+ * consumer, each on its own cache line. Every side also keeps a
+ * private copy of the other side's index ('head_cache' /
+ * 'tail_cache') and only reloads it when the ring looks full (or
+ * empty), so in the common case an operation touches no cache line
+ * written by the other thread except the ring slots themselves. */
+struct nmspsc_s {
+	void (*destructor)(void *data);
+	void **ring;
+	size_t mask;
+	char pad0[NM_CACHE_LINE];
+	atomic_size_t tail;
+	size_t head_cache;
+	char pad1[NM_CACHE_LINE - sizeof(atomic_size_t) - sizeof(size_t)];
+	atomic_size_t head;
+	size_t tail_cache;
+	char pad2[NM_CACHE_LINE - sizeof(atomic_size_t) - sizeof(size_t)];
+};
+
+/**
+ * Allocates memory for a new single-producer / single-consumer
+ * queue.
+ *
+ * Exactly one thread may enqueue and exactly one (other) thread
+ * may dequeue. Neither side ever waits for the other: operations
+ * fail instead when the queue is full (or empty).
+ *
+ * INPUT:
+ * 'capacity'		Maximum number of elements, rounded up to
+ * 					a power of two (at least 2).
+ * 'destructor'		Destructor for 'data' being hold by the queue.
+ *
+ * RETURNS:
+ * NULL				If memory allocation fails.
+ * A new queue.
+ **/
+nmspsc *nmspsc_alloc(unsigned int capacity, void (*destructor)(void *data))
+{
+	nmspsc *queue = NULL;
+	size_t cap = 2;
+	while (cap < capacity) {
+		cap <<= 1;
+	}
+	if ((queue = calloc(1, sizeof(*queue))) == NULL) {
+		return NULL;
+	}
+	if ((queue->ring = malloc(cap * sizeof(*queue->ring))) == NULL) {
+		free(queue);
+		return NULL;
+	}
+	queue->destructor = destructor;
+	queue->mask = cap - 1;
+	atomic_init(&queue->tail, 0);
+	atomic_init(&queue->head, 0);
+	queue->head_cache = 0;
+	queue->tail_cache = 0;
+	return queue;
+}
+
+/**
+ * De-allocates memory for the queue. The data still
+ * being hold by the queue is purged.
+ *
+ * Must not be called while the producer or the consumer
+ * use the queue.
+ *
+ * RETURNS:
+ * 0				If queue was succesfuly de-allocated.
+ * -1				If something went wrong (queue is NULL,
+ * 					destructor is NULL).
+ **/
+int nmspsc_free(nmspsc *queue)
+{
+	void *data;
+	if (queue == NULL || queue->destructor == NULL) {
+		return (-1);
+	}
+	while (nmspsc_dequeue(queue, &data) == 0) {
+		if (data != NULL) {
+			queue->destructor(data);
+		}
+	}
+	free(queue->ring);
+	free(queue);
+	return (0);
+}
+
+/**
+ * THIS FUNCTION IS PRIVATE.
+ * Returns how many slots the producer can fill starting
+ * at 'tail', refreshing 'head_cache' only if less than 'n'
+ * slots seem available.
+ **/
+static size_t nmspsc_room(nmspsc *queue, size_t tail, size_t n)
+{
+	size_t room = queue->mask + 1 - (tail - queue->head_cache);
+	if (room < n) {
+		queue->head_cache = atomic_load_explicit(&queue->head,
+		                    memory_order_acquire);
+		room = queue->mask + 1 - (tail - queue->head_cache);
+	}
+	return room;
+}
+
+/**
+ * THIS FUNCTION IS PRIVATE.
+ * Returns how many elements the consumer can take starting
+ * at 'head', refreshing 'tail_cache' only if less than 'n'
+ * elements seem available.
+ **/
+static size_t nmspsc_avail(nmspsc *queue, size_t head, size_t n)
+{
+	size_t avail = queue->tail_cache - head;
+	if (avail < n) {
+		queue->tail_cache = atomic_load_explicit(&queue->tail,
+		                    memory_order_acquire);
+		avail = queue->tail_cache - head;
+	}
+	return avail;
+}
+
+/**
+ * Enqueue 'data' (producer side).
+ *
+ * RETURNS:
+ * 0				If insertion was succesful.
+ * -1				If the queue is full or NULL.
+ **/
+int nmspsc_enqueue(nmspsc *queue, const void *data)
+{
+	size_t tail;
+	if (queue == NULL) {
+		return (-1);
+	}
+	tail = atomic_load_explicit(&queue->tail, memory_order_relaxed);
+	if (nmspsc_room(queue, tail, 1) == 0) {
+		return (-1);
+	}
+	queue->ring[tail & queue->mask] = (void*) data;
+	atomic_store_explicit(&queue->tail, tail + 1, memory_order_release);
+	return (0);
+}
+
+/**
+ * Dequeue an element (consumer side).
+ *
+ * INPUT:
+ * 'queue'			The queue.
+ * 'data'			Where the dequeued data is stored.
+ *
+ * RETURNS:
+ * 0				If an element was dequeued into '*data'.
+ * -1				If the queue is empty or NULL.
+ **/
+int nmspsc_dequeue(nmspsc *queue, void **data)
+{
+	size_t head;
+	if (queue == NULL || data == NULL) {
+		return (-1);
+	}
+	head = atomic_load_explicit(&queue->head, memory_order_relaxed);
+	if (nmspsc_avail(queue, head, 1) == 0) {
+		return (-1);
+	}
+	*data = queue->ring[head & queue->mask];
+	atomic_store_explicit(&queue->head, head + 1, memory_order_release);
+	return (0);
+}
+
+/**
+ * Enqueue up to 'n' pointers from 'data' (producer side), publishing
+ * them to the consumer with a single store.
+ *
+ * INPUT:
+ * 'queue'			The queue.
+ * 'data'			Array of 'n' pointers to be inserted.
+ * 'n'				Number of pointers.
+ *
+ * RETURNS:
+ * The number of pointers enqueued (less than 'n' if the queue
+ * became full, 0 if queue or data are NULL).
+ **/
+unsigned int nmspsc_enqueue_batch(nmspsc *queue, void *const *data, unsigned int n)
+{
+	size_t tail, room, pos, first;
+	if (queue == NULL || data == NULL || n == 0) {
+		return 0;
+	}
+	tail = atomic_load_explicit(&queue->tail, memory_order_relaxed);
+	room = nmspsc_room(queue, tail, n);
+	if (room < n) {
+		n = (unsigned int) room;
+	}
+	pos = tail & queue->mask;
+	first = queue->mask + 1 - pos;
+	if (first > n) {
+		first = n;
+	}
+	memcpy(queue->ring + pos, data, first * sizeof(*data));
+	memcpy(queue->ring, data + first, (n - first) * sizeof(*data));
+	atomic_store_explicit(&queue->tail, tail + n, memory_order_release);
+	return n;
+}
+
+/**
+ * Dequeue up to 'n' pointers into 'data' (consumer side), releasing
+ * the slots to the producer with a single store.
+ *
+ * INPUT:
+ * 'queue'			The queue.
+ * 'data'			Array with room for 'n' pointers.
+ * 'n'				Maximum number of pointers.
+ *
+ * RETURNS:
+ * The number of pointers dequeued (0 if the queue is empty, or
+ * queue or data are NULL).
+ **/
+unsigned int nmspsc_dequeue_batch(nmspsc *queue, void **data, unsigned int n)
+{
+	size_t head, avail, pos, first;
+	if (queue == NULL || data == NULL || n == 0) {
+		return 0;
+	}
+	head = atomic_load_explicit(&queue->head, memory_order_relaxed);
+	avail = nmspsc_avail(queue, head, n);
+	if (avail < n) {
+		n = (unsigned int) avail;
+	}
+	pos = head & queue->mask;
+	first = queue->mask + 1 - pos;
+	if (first > n) {
+		first = n;
+	}
+	memcpy(data, queue->ring + pos, first * sizeof(*data));
+	memcpy(data + first, queue->ring, (n - first) * sizeof(*data));
+	atomic_store_explicit(&queue->head, head + n, memory_order_release);
+	return n;
+}
+
+/**
+ * Returns the number of elements in the queue.
+ *
+ * While the producer and consumer operate on the queue
+ * the value is only a snapshot.
+ **/
+unsigned int nmspsc_size(nmspsc *queue)
+{
+	size_t head, tail;
+	if (queue == NULL) {
+		return 0;
+	}
+	head = atomic_load_explicit(&queue->head, memory_order_acquire);
+	tail = atomic_load_explicit(&queue->tail, memory_order_acquire);
+	return (unsigned int) (tail - head);
+}
+
+/**
+ * Returns the maximum number of elements the queue can hold.
+ **/
+unsigned int nmspsc_capacity(nmspsc *queue)
+{
+	return (queue == NULL) ? 0 : (unsigned int) (queue->mask + 1);
+}
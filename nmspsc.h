@@ -0,0 +1,17 @@
+#ifndef __NM__SPSC__H__
+#define __NM__SPSC__H__
+#include "nmaux.h"
+
+typedef struct nmspsc_s nmspsc;
+
+nmspsc *nmspsc_alloc(unsigned int capacity, void (*destructor)(void *data));
+int nmspsc_free(nmspsc *queue);
+
+int nmspsc_enqueue(nmspsc *queue, const void *data);
+int nmspsc_dequeue(nmspsc *queue, void **data);
+unsigned int nmspsc_enqueue_batch(nmspsc *queue, void *const *data, unsigned int n);
+unsigned int nmspsc_dequeue_batch(nmspsc *queue, void **data, unsigned int n);
+unsigned int nmspsc_size(nmspsc *queue);
+unsigned int nmspsc_capacity(nmspsc *queue);
+
+#endif
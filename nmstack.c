@@ -1,5 +1,160 @@
 #include <stdlib.h>
 #include "nmstack.h"
+#include "nmvect.h"
+
+/* A stack is either backed by a linked list ('list' != NULL) or
+ * by a vector ('vect' != NULL) whose last element is the top. */
+struct nmstack_s {
+	void (*destructor)(void *data);
+	nmlist *list;
+	nmvect *vect;
+	const nm_allocator *allocator;
+};
+
+/**
+ * THIS FUNCTION IS PRIVATE.
+ * Allocates the stack structure around an already allocated
+ * 'list' or 'vect'. If memory allocation fails the backend is
+ * de-allocated.
+ **/
+static nmstack *nmstack_alloc_backend(nmlist *list, nmvect *vect,
+                                      void (*destructor)(void *data),
+                                      const nm_allocator *allocator)
+{
+	nmstack *stack = NULL;
+	if (list == NULL && vect == NULL) {
+		return NULL;
+	}
+	if ((stack = nm_calloc(allocator, 1, sizeof(*stack))) == NULL) {
+		if (list != NULL) {
+			nmlist_free(list);
+		} else {
+			nmvect_free(vect);
+		}
+		return NULL;
+	}
+	stack->destructor = destructor;
+	stack->list = list;
+	stack->vect = vect;
+	stack->allocator = allocator;
+	return stack;
+}
+
+/**
+ * Allocates memory for a new list backed stack.
+ *
+ * INPUT:
+ * 'destructor'		Destructor for 'data' being hold by the stack.
+ *
+ * RETURNS:
+ * NULL				If memory allocation fails.
+ * A new stack.
+ **/
+nmstack *nmstack_alloc(void (*destructor)(void *data))
+{
+	return nmstack_alloc_with(destructor, NULL);
+}
+
+/**
+ * Allocates memory for a new list backed stack, whose memory
+ * (the stack, the list and its elements) comes from 'allocator'.
+ *
+ * INPUT:
+ * 'destructor'		Destructor for 'data' being hold by the stack.
+ * 'allocator'		The allocator (NULL for malloc / free).
+ *
+ * RETURNS:
+ * NULL				If memory allocation fails.
+ * A new stack.
+ **/
+nmstack *nmstack_alloc_with(void (*destructor)(void *data),
+                            const nm_allocator *allocator)
+{
+	return nmstack_alloc_backend(nmlist_alloc_with(destructor, allocator), NULL,
+	                             destructor, allocator);
+}
+
+/**
+ * Allocates memory for a new list backed stack, whose
+ * elements are taken from 'pool' (see 'nmlist_alloc_pool').
+ *
+ * INPUT:
+ * 'destructor'		Destructor for 'data' being hold by the stack.
+ * 'pool'			Element pool, NULL for a private one.
+ *
+ * RETURNS:
+ * NULL				If memory allocation fails.
+ * A new stack.
+ **/
+nmstack *nmstack_alloc_pool(void (*destructor)(void *data), nmlist_pool *pool)
+{
+	return nmstack_alloc_backend(nmlist_alloc_pool(destructor, pool), NULL,
+	                             destructor, NULL);
+}
+
+/**
+ * Allocates memory for a new stack backed by a vector.
+ *
+ * The elements are stored contiguously, the capacity grows
+ * with 'nmvect_expand' and is never contracted by pops, so
+ * push / pop only re-allocate when the stack grows past its
+ * highest size so far.
+ *
+ * INPUT:
+ * 'icap'			Initial capacity.
+ * 'destructor'		Destructor for 'data' being hold by the stack.
+ *
+ * RETURNS:
+ * NULL				If memory allocation fails.
+ * A new stack.
+ **/
+nmstack *nmstack_alloc_vect(unsigned int icap, void (*destructor)(void *data))
+{
+	return nmstack_alloc_vect_with(icap, destructor, NULL);
+}
+
+/**
+ * Allocates memory for a new vector backed stack, whose memory
+ * (the stack, the vector and its array) comes from 'allocator'.
+ *
+ * INPUT:
+ * 'icap'			Initial capacity.
+ * 'destructor'		Destructor for 'data' being hold by the stack.
+ * 'allocator'		The allocator (NULL for malloc / free).
+ *
+ * RETURNS:
+ * NULL				If memory allocation fails.
+ * A new stack.
+ **/
+nmstack *nmstack_alloc_vect_with(unsigned int icap, void (*destructor)(void *data),
+                                 const nm_allocator *allocator)
+{
+	return nmstack_alloc_backend(NULL, nmvect_alloc_with((icap > 0) ? icap : 1,
+	                             destructor, NULL, allocator), destructor, allocator);
+}
+
+/**
+ * De-allocates memory for the stack. The data still
+ * being hold by the stack is purged.
+ *
+ * RETURNS:
+ * 0				If stack was succesfuly de-allocated.
+ * -1				If something went wrong (stack is NULL,
+ * 					destructor is NULL).
+ **/
+int nmstack_free(nmstack *stack)
+{
+	if (stack == NULL || stack->destructor == NULL) {
+		return (-1);
+	}
+	if (stack->list != NULL) {
+		nmlist_free(stack->list);
+	} else {
+		nmvect_free(stack->vect);
+	}
+	nm_free(stack->allocator, stack);
+	return (0);
+}
 
 /** 
  * Pushes 'data' onto the stack.
@@ -14,7 +169,13 @@
  **/
 int nmstack_push(nmstack *stack, const void *data)
 {
-	return nmlist_insert_next(stack, NULL, data);
+	if (stack == NULL) {
+		return (-1);
+	}
+	if (stack->list != NULL) {
+		return nmlist_insert_next(stack->list, NULL, data);
+	}
+	return nmvect_append(stack->vect, data);
 }
 
 /**
@@ -29,7 +190,13 @@ int nmstack_push(nmstack *stack, const void *data)
  **/ 
 void *nmstack_pop(nmstack *stack)
 {
-	return nmlist_remove_next(stack, NULL);
+	if (stack == NULL) {
+		return NULL;
+	}
+	if (stack->list != NULL) {
+		return nmlist_remove_next(stack->list, NULL);
+	}
+	return nmvect_remove_last(stack->vect);
 }
 
 /**
@@ -45,7 +212,17 @@ void *nmstack_pop(nmstack *stack)
  **/
 int nmstack_purge(nmstack *stack)
 {
-	return nmlist_purge_next(stack, NULL);
+	void *data;
+	if (stack == NULL || stack->destructor == NULL) {
+		return (-1);
+	}
+	if (stack->list != NULL) {
+		return nmlist_purge_next(stack->list, NULL);
+	}
+	if ((data = nmvect_remove_last(stack->vect)) != NULL) {
+		stack->destructor(data);
+	}
+	return (0);
 }
 
 /**
@@ -60,7 +237,13 @@ int nmstack_purge(nmstack *stack)
  **/
 void *nmstack_peek(nmstack *stack)
 {
-	return nmlist_get_data(nmlist_head(stack));
+	if (stack == NULL) {
+		return NULL;
+	}
+	if (stack->list != NULL) {
+		return nmlist_get_data(nmlist_head(stack->list));
+	}
+	return nmvect_get(stack->vect, nmvect_size(stack->vect) - 1);
 }
 
 /**
@@ -74,6 +257,10 @@ void *nmstack_peek(nmstack *stack)
  **/
 unsigned int nmstack_size(nmstack *stack)
 {
-	return nmlist_size(stack);
+	if (stack == NULL) {
+		return 0;
+	}
+	return (stack->list != NULL) ? nmlist_size(stack->list) :
+	       nmvect_size(stack->vect);
 }
 
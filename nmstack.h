@@ -2,10 +2,16 @@
 #define __NM__STACK__H__
 #include "nmlist.h"
 
-typedef nmlist nmstack;
+typedef struct nmstack_s nmstack;
 
-#define nmstack_alloc nmlist_alloc
-#define nmstack_free nmlist_free
+nmstack *nmstack_alloc(void (*destructor)(void *data));
+nmstack *nmstack_alloc_pool(void (*destructor)(void *data), nmlist_pool *pool);
+nmstack *nmstack_alloc_vect(unsigned int icap, void (*destructor)(void *data));
+nmstack *nmstack_alloc_with(void (*destructor)(void *data),
+                            const nm_allocator *allocator);
+nmstack *nmstack_alloc_vect_with(unsigned int icap, void (*destructor)(void *data),
+                                 const nm_allocator *allocator);
+int nmstack_free(nmstack *stack);
 
 int nmstack_push(nmstack *stack, const void *data);
 void *nmstack_pop(nmstack *stack);
@@ -0,0 +1,302 @@
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include "nmtpool.h"
+
+/* Fixed size thread pool.
+ *
+ * 'nmtpool_run' hands the same job to every worker and waits for
+ * all of them; the calling thread is worker 0, so a pool of 'n'
+ * workers owns 'n - 1' threads. The threads sleep on 'wake'
+ * between jobs, a job being published by bumping 'generation'. */
+typedef struct nmtpool_worker_s {
+	nmtpool *pool;
+	unsigned int id;
+} nmtpool_worker;
+
+struct nmtpool_s {
+	pthread_mutex_t run;
+	pthread_mutex_t lock;
+	pthread_cond_t wake;
+	pthread_cond_t done;
+	pthread_t *threads;
+	nmtpool_worker *workers;
+	unsigned int size;
+	void (*job)(void *arg, unsigned int worker);
+	void *arg;
+	unsigned long generation;
+	unsigned int pending;
+	int stop;
+};
+
+/* Slice of the index space of 'nmtpool_for', first handed to one
+ * worker. Its owner and, once their own slice is done, the other
+ * workers claim 'grain' indices at a time from 'next'. Ranges are
+ * cache line aligned (and allocated so), every cursor having its
+ * own line. */
+typedef struct nmtpool_range_s {
+	_Alignas(NM_CACHE_LINE) atomic_size_t next;
+	size_t end;
+} nmtpool_range;
+
+typedef struct nmtpool_for_s {
+	nmtpool_range *ranges;
+	unsigned int nranges;
+	unsigned int grain;
+	void (*body)(void *arg, unsigned int lo, unsigned int hi, unsigned int worker);
+	void *arg;
+} nmtpool_for_ctx;
+
+/**
+ * THIS FUNCTION IS PRIVATE.
+ * Thread body: runs every published job until the pool stops.
+ **/
+static void *nmtpool_loop(void *arg)
+{
+	nmtpool_worker *worker = arg;
+	nmtpool *pool = worker->pool;
+	unsigned long seen = 0;
+	void (*job)(void *arg, unsigned int worker);
+	void *job_arg;
+	for (;;) {
+		pthread_mutex_lock(&pool->lock);
+		while (!pool->stop && pool->generation == seen) {
+			pthread_cond_wait(&pool->wake, &pool->lock);
+		}
+		if (pool->stop) {
+			pthread_mutex_unlock(&pool->lock);
+			return NULL;
+		}
+		seen = pool->generation;
+		job = pool->job;
+		job_arg = pool->arg;
+		pthread_mutex_unlock(&pool->lock);
+		job(job_arg, worker->id);
+		pthread_mutex_lock(&pool->lock);
+		if (--pool->pending == 0) {
+			pthread_cond_signal(&pool->done);
+		}
+		pthread_mutex_unlock(&pool->lock);
+	}
+}
+
+/**
+ * THIS FUNCTION IS PRIVATE.
+ * Stops and joins the first 'n' threads of the pool, then frees it.
+ **/
+static void nmtpool_destroy(nmtpool *pool, unsigned int n)
+{
+	unsigned int i;
+	pthread_mutex_lock(&pool->lock);
+	pool->stop = 1;
+	pthread_cond_broadcast(&pool->wake);
+	pthread_mutex_unlock(&pool->lock);
+	for (i = 0; i < n; i++) {
+		pthread_join(pool->threads[i], NULL);
+	}
+	pthread_cond_destroy(&pool->done);
+	pthread_cond_destroy(&pool->wake);
+	pthread_mutex_destroy(&pool->lock);
+	pthread_mutex_destroy(&pool->run);
+	free(pool->workers);
+	free(pool->threads);
+	free(pool);
+}
+
+/**
+ * Allocates a new thread pool.
+ *
+ * INPUT:
+ * 'nthreads'		Number of workers, the calling thread included
+ * 					(0 for one per online CPU).
+ *
+ * RETURNS:
+ * NULL				If memory allocation or thread creation fails.
+ * A new pool.
+ **/
+nmtpool *nmtpool_alloc(unsigned int nthreads)
+{
+	nmtpool *pool = NULL;
+	unsigned int i;
+	long ncpu;
+	if (nthreads == 0) {
+		ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+		nthreads = (ncpu > 0) ? (unsigned int) ncpu : 1;
+	}
+	if ((pool = calloc(1, sizeof(*pool))) == NULL) {
+		return NULL;
+	}
+	pool->size = nthreads;
+	pool->threads = malloc(nthreads * sizeof(*pool->threads));
+	pool->workers = malloc(nthreads * sizeof(*pool->workers));
+	if (pool->threads == NULL || pool->workers == NULL) {
+		free(pool->threads);
+		free(pool->workers);
+		free(pool);
+		return NULL;
+	}
+	pthread_mutex_init(&pool->run, NULL);
+	pthread_mutex_init(&pool->lock, NULL);
+	pthread_cond_init(&pool->wake, NULL);
+	pthread_cond_init(&pool->done, NULL);
+	for (i = 1; i < nthreads; i++) {
+		pool->workers[i].pool = pool;
+		pool->workers[i].id = i;
+		if (pthread_create(&pool->threads[i - 1], NULL, nmtpool_loop,
+		                   &pool->workers[i]) != 0) {
+			nmtpool_destroy(pool, i - 1);
+			return NULL;
+		}
+	}
+	return pool;
+}
+
+/**
+ * Stops the threads of the pool and frees it.
+ * Must not be called while a job is running.
+ *
+ * RETURNS:
+ * 0				If operation was succesful.
+ * -1				If pool is NULL.
+ **/
+int nmtpool_free(nmtpool *pool)
+{
+	if (pool == NULL) {
+		return (-1);
+	}
+	nmtpool_destroy(pool, pool->size - 1);
+	return (0);
+}
+
+/**
+ * Runs 'job(arg, worker)' once on every worker, 'worker' going
+ * from 0 (the calling thread) to 'nmtpool_size(pool) - 1', and
+ * waits for all of them to return.
+ *
+ * Runs from different threads are serialized. A job must not
+ * run another job on the same pool.
+ *
+ * INPUT:
+ * 'pool'			The pool, NULL to run 'job(arg, 0)' in the
+ * 					calling thread only.
+ * 'job'			The job.
+ * 'arg'			Argument passed to the job.
+ *
+ * RETURNS:
+ * 0				If operation was succesful.
+ * -1				If job is NULL.
+ **/
+int nmtpool_run(nmtpool *pool, void (*job)(void *arg, unsigned int worker), void *arg)
+{
+	if (job == NULL) {
+		return (-1);
+	}
+	if (pool == NULL || pool->size == 1) {
+		job(arg, 0);
+		return (0);
+	}
+	pthread_mutex_lock(&pool->run);
+	pthread_mutex_lock(&pool->lock);
+	pool->job = job;
+	pool->arg = arg;
+	pool->pending = pool->size - 1;
+	pool->generation++;
+	pthread_cond_broadcast(&pool->wake);
+	pthread_mutex_unlock(&pool->lock);
+	job(arg, 0);
+	pthread_mutex_lock(&pool->lock);
+	while (pool->pending > 0) {
+		pthread_cond_wait(&pool->done, &pool->lock);
+	}
+	pthread_mutex_unlock(&pool->lock);
+	pthread_mutex_unlock(&pool->run);
+	return (0);
+}
+
+/**
+ * THIS FUNCTION IS PRIVATE.
+ * Job of 'nmtpool_for': drains the worker's own range, then
+ * steals from the others.
+ **/
+static void nmtpool_for_job(void *arg, unsigned int worker)
+{
+	nmtpool_for_ctx *ctx = arg;
+	nmtpool_range *range;
+	unsigned int i;
+	size_t lo, hi;
+	for (i = 0; i < ctx->nranges; i++) {
+		range = &ctx->ranges[(worker + i) % ctx->nranges];
+		while ((lo = atomic_fetch_add_explicit(&range->next, ctx->grain,
+		                                       memory_order_relaxed)) < range->end) {
+			hi = (range->end - lo < ctx->grain) ? range->end : lo + ctx->grain;
+			ctx->body(ctx->arg, (unsigned int) lo, (unsigned int) hi, worker);
+		}
+	}
+}
+
+/**
+ * Calls 'body(arg, lo, hi, worker)' over chunks [lo, hi) covering
+ * [0, n) exactly once, spread over the workers of the pool.
+ *
+ * Every worker starts with an equal slice of [0, n) and claims it
+ * 'grain' indices at a time; once done it steals chunks from the
+ * slices of the other workers, so uneven chunk costs balance out.
+ *
+ * INPUT:
+ * 'pool'			The pool (NULL to run in the calling thread).
+ * 'n'				Number of indices.
+ * 'grain'			Chunk size (0 to pick one giving every worker
+ * 					about 16 chunks).
+ * 'body'			Function called on every chunk.
+ * 'arg'			Argument passed to 'body'.
+ *
+ * RETURNS:
+ * 0				If operation was succesful.
+ * -1				If body is NULL or memory allocation fails.
+ **/
+int nmtpool_for(nmtpool *pool, unsigned int n, unsigned int grain,
+                void (*body)(void *arg, unsigned int lo, unsigned int hi,
+                             unsigned int worker),
+                void *arg)
+{
+	nmtpool_for_ctx ctx;
+	unsigned int i, workers = nmtpool_size(pool);
+	if (body == NULL) {
+		return (-1);
+	}
+	if (n == 0) {
+		return (0);
+	}
+	if (workers == 1) {
+		body(arg, 0, n, 0);
+		return (0);
+	}
+	if (grain == 0) {
+		grain = n / (workers * 16);
+		grain = (grain > 0) ? grain : 1;
+	}
+	ctx.ranges = aligned_alloc(NM_CACHE_LINE, workers * sizeof(*ctx.ranges));
+	if (ctx.ranges == NULL) {
+		return (-1);
+	}
+	for (i = 0; i < workers; i++) {
+		atomic_init(&ctx.ranges[i].next, (size_t) n * i / workers);
+		ctx.ranges[i].end = (size_t) n * (i + 1) / workers;
+	}
+	ctx.nranges = workers;
+	ctx.grain = grain;
+	ctx.body = body;
+	ctx.arg = arg;
+	nmtpool_run(pool, nmtpool_for_job, &ctx);
+	free(ctx.ranges);
+	return (0);
+}
+
+/**
+ * Returns the number of workers of the pool (1 if pool is NULL).
+ **/
+unsigned int nmtpool_size(nmtpool *pool)
+{
+	return (pool == NULL) ? 1 : pool->size;
+}
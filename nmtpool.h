@@ -0,0 +1,16 @@
+#ifndef __NM__TPOOL__H__
+#define __NM__TPOOL__H__
+#include "nmaux.h"
+
+typedef struct nmtpool_s nmtpool;
+
+nmtpool *nmtpool_alloc(unsigned int nthreads);
+int nmtpool_free(nmtpool *pool);
+int nmtpool_run(nmtpool *pool, void (*job)(void *arg, unsigned int worker), void *arg);
+int nmtpool_for(nmtpool *pool, unsigned int n, unsigned int grain,
+                void (*body)(void *arg, unsigned int lo, unsigned int hi,
+                             unsigned int worker),
+                void *arg);
+unsigned int nmtpool_size(nmtpool *pool);
+
+#endif
@@ -1,6 +1,12 @@
+#include <limits.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
 #include "nmaux.h"
+#include "nmsearch.h"
+#include "nmsort.h"
+#include "nmtpool.h"
 #include "nmvect.h"
 
 struct nmvect_s {
@@ -9,12 +15,51 @@ struct nmvect_s {
 	unsigned int capacity;
 	unsigned int size;
 	nmvect_element *array;
+	nmvect_policy policy;
+	const nm_allocator *allocator;
+#ifdef NM_STATS
+	nm_stats stats;
+#endif
 };
 
+/* Grows by 1.5x, shrinks to twice the size once the vector is
+ * down to a quarter of its capacity. */
+const nmvect_policy nmvect_policy_default = { 3, 2, 1, 4 };
+
+/* Grows by 1.5x, never gives memory back (unless asked to with
+ * 'nmvect_shrink_to_fit'). */
+const nmvect_policy nmvect_policy_noshrink = { 3, 2, 1, 0 };
+
 struct nmvect_element_s {
 	void *data;
 };
 
+/* Comparator handed to 'nmsort' and the counters its calls go to.
+ * 'nmsort' comparators take no context, so with NM_STATS the vector
+ * being sorted or searched is published in a thread local variable
+ * for the duration of the call. */
+typedef int (*nmvect_cmp)(const void *e1, const void *e2);
+
+typedef struct nmvect_counting_s {
+	nmvect_cmp cmp;
+	nm_stats *stats;
+} nmvect_counting;
+
+#ifdef NM_STATS
+static _Thread_local nmvect_counting nmvect_counting_cur;
+#endif
+
+/* Shared state of the 'nmvect_parallel_*' loops. */
+typedef struct nmvect_par_s {
+	nmvect *vect;
+	nmvect *result;
+	void (*each)(void *data, void *arg);
+	void *(*map)(const void *data, void *arg);
+	void *(*reduce)(void *acc, void *data, void *arg);
+	void **partials;
+	void *arg;
+} nmvect_par;
+
 /**
  * Allocates memory for a new empty 'vect'.
  *
@@ -31,21 +76,47 @@ struct nmvect_element_s {
  **/
 nmvect *nmvect_alloc(unsigned int icap, void (*destructor)(void *data),
                      int (*cmp)(const void *e1, const void *e2))
+{
+	return nmvect_alloc_with(icap, destructor, cmp, NULL);
+}
+
+/**
+ * Allocates memory for a new empty 'vect', whose memory (the
+ * vector and its array) comes from 'allocator'. Vectors derived
+ * from it ('nmvect_remove_range', 'nmvect_parallel_map') use the
+ * same allocator.
+ *
+ * INPUT:
+ * 'icap'			Initial capacity.
+ * 'destructor'		Destructor for 'data' being hold by the vector.
+ * 'cmp'			Function needed to compare two elements.
+ * 'allocator'		The allocator (NULL for malloc / free).
+ *
+ * RETURNS:
+ * NULL				If memory allocation fails.
+ * A new vector.
+ **/
+nmvect *nmvect_alloc_with(unsigned int icap, void (*destructor)(void *data),
+                          int (*cmp)(const void *e1, const void *e2),
+                          const nm_allocator *allocator)
 {
 	nmvect *vect = NULL;
-	vect = calloc(1, sizeof(*vect));
+	vect = nm_calloc(allocator, 1, sizeof(*vect));
 	if (vect == NULL) {
 		return NULL;
 	}
 	vect->capacity = icap;
-	vect->array = calloc(icap, sizeof(*vect->array));
+	vect->array = nm_calloc(allocator, icap, sizeof(*vect->array));
 	if (vect->array == NULL) {
-		free(vect);
+		nm_free(allocator, vect);
 		return NULL;
 	}
+	NM_STAT_INC(vect->stats, allocs);
+	vect->allocator = allocator;
 	vect->size = 0;
 	vect->destructor = destructor;
 	vect->cmp = cmp;
+	vect->policy = nmvect_policy_default;
 	return vect;
 }
 
@@ -70,14 +141,114 @@ int nmvect_free(nmvect *vect)
 			vect->destructor(vect->array[i].data);
 		}
 	}
-	free(vect->array);
-	free(vect);
+	nm_free(vect->allocator, vect->array);
+	nm_free(vect->allocator, vect);
 	return (0);
 }
 
 /**
- * Expands 'vect' capacity.
- * New capacity will be 'vect->capacity*3/2+1'.
+ * THIS FUNCTION IS PRIVATE.
+ * Re-allocates 'vect->array' to hold exactly 'cap' elements
+ * ('cap' must not be less than 'vect->size').
+ *
+ * RETURNS:
+ * 0				If the capacity was succesfuly changed.
+ * -1				If memory re-allocation failed.
+ **/
+static int nmvect_setcap(nmvect *vect, unsigned int cap)
+{
+	nmvect_element *tmp_array;
+	if (cap == vect->capacity) {
+		return (0);
+	}
+	tmp_array = nm_realloc(vect->allocator, vect->array,
+	                       ((cap > 0) ? cap : 1) * sizeof(nmvect_element));
+	if (tmp_array == NULL) {
+		return (-1);
+	}
+	NM_STAT_INC(vect->stats, reallocs);
+	vect->array = tmp_array;
+	vect->capacity = cap;
+	return (0);
+}
+
+/**
+ * THIS FUNCTION IS PRIVATE.
+ * Returns the capacity 'vect' grows to when it is full:
+ * 'capacity*grow_num/grow_den+1', but at least 'min_cap'.
+ **/
+static unsigned int nmvect_grown_cap(nmvect *vect)
+{
+	unsigned long long tmp_cap;
+	tmp_cap = (unsigned long long) vect->capacity * vect->policy.grow_num /
+	          vect->policy.grow_den + 1;
+	if (tmp_cap > ~0u) {
+		tmp_cap = ~0u;
+	}
+	return ((unsigned int) tmp_cap < vect->policy.min_cap) ?
+	       vect->policy.min_cap : (unsigned int) tmp_cap;
+}
+
+/**
+ * THIS FUNCTION IS PRIVATE.
+ * Applies the shrink policy after elements were removed: once
+ * 'size <= capacity/shrink_div' the capacity is reduced to twice the
+ * size (but not below 'min_cap'). The gap between the two thresholds
+ * means a vector oscillating around a size never re-allocates on
+ * every operation.
+ **/
+static void nmvect_autoshrink(nmvect *vect)
+{
+	unsigned int tmp_cap;
+	if (vect->policy.shrink_div == 0 ||
+	        vect->capacity <= vect->policy.min_cap ||
+	        vect->size > vect->capacity / vect->policy.shrink_div) {
+		return;
+	}
+	tmp_cap = 2 * vect->size;
+	if (tmp_cap < vect->policy.min_cap) {
+		tmp_cap = vect->policy.min_cap;
+	}
+	if (tmp_cap < vect->capacity) {
+		nmvect_setcap(vect, tmp_cap);
+	}
+}
+
+/**
+ * Sets the growth / shrink policy of 'vect'.
+ *
+ * 'grow_num', 'grow_den'		The capacity of a full vector grows to
+ * 								'capacity*grow_num/grow_den+1'
+ * 								('grow_num >= grow_den > 0').
+ * 'min_cap'					The capacity is never shrunk below this.
+ * 'shrink_div'					When removals bring the size down to
+ * 								'capacity/shrink_div' the capacity is
+ * 								reduced to twice the size. 0 means the
+ * 								vector never shrinks, otherwise it must
+ * 								be at least 3.
+ *
+ * 'nmvect_policy_default' and 'nmvect_policy_noshrink' are predefined.
+ *
+ * RETURNS:
+ * 0				If the policy was set.
+ * -1				If vect or policy are NULL, or the policy is invalid.
+ **/
+int nmvect_set_policy(nmvect *vect, const nmvect_policy *policy)
+{
+	if (vect == NULL || policy == NULL ||
+	        policy->grow_den == 0 ||
+	        policy->grow_num < policy->grow_den ||
+	        policy->shrink_div == 1 || policy->shrink_div == 2) {
+		return (-1);
+	}
+	vect->policy = *policy;
+	return (0);
+}
+
+/**
+ * Expands 'vect' capacity, according to its policy.
+ * New capacity will be 'vect->capacity*grow_num/grow_den+1'
+ * ('vect->capacity*3/2+1' by default).
  *
  * INPUT:
  * 'vect'			The vector.
@@ -89,24 +260,17 @@ int nmvect_free(nmvect *vect)
  **/
 int nmvect_expand(nmvect *vect)
 {
-	unsigned int tmp_cap;
-	nmvect_element *tmp_array;
 	if (vect == NULL) {
 		return (-1);
 	}
-	tmp_cap = vect->capacity * 3 / 2 + 1;
-	tmp_array = realloc(vect->array, tmp_cap * sizeof(nmvect_element));
-	if (tmp_array != NULL) {
-		vect->array = tmp_array;
-		vect->capacity = tmp_cap;
-		return (0);
-	}
-	return (-1);
+	return nmvect_setcap(vect, nmvect_grown_cap(vect));
 }
 
 /**
  * Contracts 'vect' capacity.
- * New capacity will be 'vect->capacity*2/3+1'.
+ * New capacity will be 'vect->capacity*grow_den/grow_num+1'
+ * ('vect->capacity*2/3+1' by default), but never less than
+ * 'vect->size' or the policy 'min_cap'.
  *
  * INPUT:
  * 'vect'			The vector.
@@ -119,18 +283,18 @@ int nmvect_expand(nmvect *vect)
 int nmvect_contract(nmvect *vect)
 {
 	unsigned int tmp_cap;
-	nmvect_element *tmp_array;
 	if (vect == NULL) {
 		return (-1);
 	}
-	tmp_cap = vect->capacity * 2 / 3 + 1;
-	tmp_array = realloc(vect->array, tmp_cap * sizeof(nmvect_element));
-	if (tmp_array != NULL) {
-		vect->array = tmp_array;
-		vect->capacity = tmp_cap;
-		return (0);
+	tmp_cap = (unsigned int) ((unsigned long long) vect->capacity *
+	                          vect->policy.grow_den / vect->policy.grow_num + 1);
+	if (tmp_cap < vect->size) {
+		tmp_cap = vect->size;
 	}
-	return (-1);
+	if (tmp_cap < vect->policy.min_cap) {
+		tmp_cap = vect->policy.min_cap;
+	}
+	return nmvect_setcap(vect, tmp_cap);
 }
 
 /**
@@ -144,22 +308,63 @@ int nmvect_contract(nmvect *vect)
  **/
 int nmvect_modcap(nmvect *vect, int modif)
 {
-	unsigned int tmp_cap;
-	nmvect_element *tmp_array;
-	if (vect == NULL || vect->capacity + modif < 1) {
+	if (vect == NULL || (long long) vect->capacity + modif < 1 ||
+	        (long long) vect->capacity + modif < vect->size) {
 		return (-1);
 	}
-	if (modif == 0) {
-		return (0);
+	return nmvect_setcap(vect, vect->capacity + modif);
+}
+
+/**
+ * Makes sure 'vect' can hold at least 'cap' elements without
+ * re-allocating memory.
+ *
+ * RETURNS:
+ * 0				If the capacity is big enough.
+ * -1				If vect is NULL or memory re-allocation failed.
+ **/
+int nmvect_reserve(nmvect *vect, unsigned int cap)
+{
+	if (vect == NULL) {
+		return (-1);
 	}
-	tmp_cap = vect->capacity + modif;
-	tmp_array = realloc(vect->array, tmp_cap * sizeof(nmvect_element));
-	if (tmp_array != NULL) {
-		vect->array = tmp_array;
-		vect->capacity = tmp_cap;
+	return (cap <= vect->capacity) ? 0 : nmvect_setcap(vect, cap);
+}
+
+/**
+ * Reduces 'vect' capacity to its size (at least 1), regardless
+ * of the policy.
+ *
+ * RETURNS:
+ * 0				If the capacity was reduced.
+ * -1				If vect is NULL or memory re-allocation failed.
+ **/
+int nmvect_shrink_to_fit(nmvect *vect)
+{
+	if (vect == NULL) {
+		return (-1);
+	}
+	return nmvect_setcap(vect, (vect->size > 0) ? vect->size : 1);
+}
+
+/**
+ * THIS FUNCTION IS PRIVATE.
+ * Makes sure 'vect' can hold at least 'cap' elements. The capacity
+ * grows at least as much as 'nmvect_expand' would, so repeated
+ * range insertions stay amortized O(1) per element.
+ *
+ * RETURNS:
+ * 0				If the capacity is big enough.
+ * -1				If memory re-allocation failed.
+ **/
+static int nmvect_grow(nmvect *vect, unsigned int cap)
+{
+	unsigned int tmp_cap;
+	if (cap <= vect->capacity) {
 		return (0);
 	}
-	return (-1);
+	tmp_cap = nmvect_grown_cap(vect);
+	return nmvect_setcap(vect, (tmp_cap < cap) ? cap : tmp_cap);
 }
 
 /**
@@ -181,25 +386,16 @@ int nmvect_modcap(nmvect *vect, int modif)
  **/
 int nmvect_insert(nmvect *vect, unsigned int index, const void *data)
 {
-	int i;
-	unsigned int ilim;
-	void *tmp, *aux;
 	if (vect == NULL || index > vect->size) {
 		return (-1);
 	}
-	if (index == vect->size) {
-		nmvect_append(vect, data);
-	} else {
-		if (vect->size == vect->capacity) {
-			nmvect_expand(vect);
-		}
-		ilim = vect->size + 1;
-		for (i = index, tmp = (void*) data; i < ilim; i++) {
-			aux = vect->array[i].data;
-			vect->array[i].data = tmp;
-			tmp = aux;
-		}
+	if (vect->size == vect->capacity && nmvect_expand(vect) != 0) {
+		return (-1);
 	}
+	memmove(&vect->array[index + 1], &vect->array[index],
+	        (vect->size - index) * sizeof(*vect->array));
+	NM_STAT_ADD(vect->stats, shifted, vect->size - index);
+	vect->array[index].data = (void*) data;
 	vect->size++;
 	return (0);
 }
@@ -223,37 +419,27 @@ int nmvect_insert(nmvect *vect, unsigned int index, const void *data)
  **/
 int nmvect_insert_range(nmvect *vect, unsigned int index, nmvect *addvect)
 {
-	int i;
-	nmvect *moved_data;
+	unsigned int n;
 	if (vect == NULL ||
 	        addvect == NULL ||
 	        index > vect->size ||
-	        nmvect_modcap(vect, vect->capacity + addvect->size) != 0 ||
-	        (moved_data = nmvect_alloc(addvect->size, vect->destructor, NULL)) == NULL) {
+	        nmvect_grow(vect, vect->size + addvect->size) != 0) {
 		return (-1);
 	}
-	for (i = index; i < vect->size; i++) {
-		if (nmvect_append(moved_data, (const void*)vect->array[i].data) != 0) {
-			free(moved_data->array);
-			free(moved_data);
-			return (-1);
-		}
-	}
-	for (i = 0; i < addvect->size; i++) {
-		if (i + index >= vect->size) {
-			vect->size++;
-		}
-		vect->array[i+index].data = addvect->array[i].data;
-	}
-	for (i = 0; i < moved_data->size; i++) {
-		/* At this point append cannot fail. The capacity is big enough
-		 * and was previously expanded. No reason to check.*/
-		nmvect_append(vect, (const void*) nmvect_get(moved_data, i));
+	n = addvect->size;
+	memmove(&vect->array[index + n], &vect->array[index],
+	        (vect->size - index) * sizeof(*vect->array));
+	NM_STAT_ADD(vect->stats, shifted, vect->size - index);
+	if (addvect != vect) {
+		memcpy(&vect->array[index], addvect->array, n * sizeof(*vect->array));
+	} else {
+		/* Inserting the vector into itself: its tail was just moved
+		 * to 'index + n'. */
+		memcpy(&vect->array[index], vect->array, index * sizeof(*vect->array));
+		memcpy(&vect->array[2 * index], &vect->array[index + n],
+		       (n - index) * sizeof(*vect->array));
 	}
-
-	free(moved_data->array);
-	free(moved_data);
-
+	vect->size += n;
 	return (0);
 }
 
@@ -323,12 +509,44 @@ int nmvect_contains(nmvect *vect, const void *data)
 	}
 	for (i = 0; i < vect->size; i++) {
 		if (vect->cmp((const void*) vect->array[i].data, data) == 0) {
+			NM_STAT_ADD(vect->stats, cmps, i + 1);
 			return (0);
 		}
 	}
+	NM_STAT_ADD(vect->stats, cmps, i);
 	return (-1);
 }
 
+/**
+ * Returns the position of the first element that is the very
+ * same pointer as 'data' (no comparator involved).
+ *
+ * The vector stores contiguous pointers, so the search runs on
+ * the 'nmsearch' kernels (8-16 pointers per instruction where
+ * the CPU supports it).
+ *
+ * INPUT:
+ * 'vect'		Vector where to look for 'data'
+ * 'data'		Pointer to be looked for.
+ *
+ * RETURNS:
+ * The index of the first element equal to 'data'.
+ * -1			If not found, vect is NULL or it holds more than
+ * 				INT_MAX elements (the index wouldn't fit).
+ **/
+int nmvect_find_ptr(nmvect *vect, const void *data)
+{
+	if (vect == NULL || vect->size > INT_MAX) {
+		return (-1);
+	}
+	if (sizeof(void*) == sizeof(uint64_t)) {
+		return nmsearch_find64((const uint64_t*) vect->array, vect->size,
+		                       (uint64_t) (uintptr_t) data);
+	}
+	return nmsearch_find32((const uint32_t*) vect->array, vect->size,
+	                       (uint32_t) (uintptr_t) data);
+}
+
 /**
  * Returns an 'array' of integers.
  * Every integer points to the a position in 'vect'
@@ -341,6 +559,9 @@ int nmvect_contains(nmvect *vect, const void *data)
  *
  * OUTPUT:
  * An array containing all the occurences of the array.
+ *
+ * Every match costs a list element and an 'int' allocation,
+ * prefer 'nmvect_find_all' / 'nmvect_find_all_buf'.
  **/
 nmlist *nmvect_occurence(nmvect *vect, const void *data)
 {
@@ -359,9 +580,477 @@ nmlist *nmvect_occurence(nmvect *vect, const void *data)
 			}
 		}
 	}
+	NM_STAT_ADD(vect->stats, cmps, i);
 	return rlist;
 }
 
+/**
+ * Writes the positions of the elements equal to 'data' to
+ * 'indices', in increasing order. No memory is allocated.
+ *
+ * Vector should have the comparator function != NULL.
+ *
+ * INPUT:
+ * 'vect'		The vector where to look for 'data'.
+ * 'data'		The data to look for.
+ * 'indices'	Caller buffer for the positions, NULL to only
+ * 				count the matches.
+ * 'limit'		Capacity of 'indices': the search stops after
+ * 				'limit' matches (ignored if 'indices' is NULL).
+ *
+ * RETURNS:
+ * The number of matches (written to 'indices', if not NULL).
+ * -1			If vect is NULL, has no comparator or holds
+ * 				more than INT_MAX elements (the count
+ * 				wouldn't fit).
+ **/
+int nmvect_find_all(nmvect *vect, const void *data,
+                    unsigned int *indices, unsigned int limit)
+{
+	unsigned int i, count = 0;
+	if (vect == NULL || vect->cmp == NULL || vect->size > INT_MAX) {
+		return (-1);
+	}
+	for (i = 0; i < vect->size; i++) {
+		if (indices != NULL && count == limit) {
+			break;
+		}
+		if (vect->cmp((const void*) vect->array[i].data, data) == 0) {
+			if (indices != NULL) {
+				indices[count] = i;
+			}
+			count++;
+		}
+	}
+	NM_STAT_ADD(vect->stats, cmps, i);
+	return (int) count;
+}
+
+/**
+ * Same as 'nmvect_find_all', but the positions are written to
+ * a buffer grown (with realloc) as needed. The buffer can be
+ * reused across searches, so repeated queries allocate only
+ * when a result doesn't fit.
+ *
+ * INPUT:
+ * 'vect'		The vector where to look for 'data'.
+ * 'data'		The data to look for.
+ * 'buf'		In/out: the buffer (*buf may be NULL). Owned
+ * 				by the caller, who frees it.
+ * 'bufcap'		In/out: capacity of *buf, in elements.
+ * 'limit'		Maximum number of matches, 0 for no limit.
+ *
+ * RETURNS:
+ * The number of matches written to *buf.
+ * -1			If vect, buf or bufcap are NULL, vect has no
+ * 				comparator or holds more than INT_MAX
+ * 				elements, or memory allocation fails (*buf
+ * 				and *bufcap stay valid).
+ **/
+int nmvect_find_all_buf(nmvect *vect, const void *data, unsigned int **buf,
+                        unsigned int *bufcap, unsigned int limit)
+{
+	unsigned int i, count = 0, tmp_cap, *tmp_buf;
+	if (vect == NULL || vect->cmp == NULL || buf == NULL || bufcap == NULL ||
+	        vect->size > INT_MAX) {
+		return (-1);
+	}
+	for (i = 0; i < vect->size; i++) {
+		if (limit != 0 && count == limit) {
+			break;
+		}
+		if (vect->cmp((const void*) vect->array[i].data, data) != 0) {
+			continue;
+		}
+		if (count == *bufcap || *buf == NULL) {
+			tmp_cap = (*buf == NULL || *bufcap == 0) ? 16 : *bufcap + *bufcap / 2 + 1;
+			if ((tmp_buf = realloc(*buf, tmp_cap * sizeof(**buf))) == NULL) {
+				return (-1);
+			}
+			*buf = tmp_buf;
+			*bufcap = tmp_cap;
+		}
+		(*buf)[count++] = i;
+	}
+	NM_STAT_ADD(vect->stats, cmps, i);
+	return (int) count;
+}
+
+#ifdef NM_STATS
+/**
+ * THIS FUNCTION IS PRIVATE.
+ * Comparator counting its calls in the vector being sorted or
+ * searched by the calling thread.
+ **/
+static int nmvect_counting_cmp(const void *e1, const void *e2)
+{
+	nmvect_counting_cur.stats->cmps++;
+	return nmvect_counting_cur.cmp(e1, e2);
+}
+#endif
+
+/**
+ * THIS FUNCTION IS PRIVATE.
+ * Returns the comparator to hand 'nmsort' for 'vect' (NULL if
+ * the vector has none). With NM_STATS its calls are counted
+ * until 'nmvect_counting_end(saved)'.
+ **/
+static nmvect_cmp nmvect_counting_begin(nmvect *vect, nmvect_counting *saved)
+{
+#ifdef NM_STATS
+	*saved = nmvect_counting_cur;
+	if (vect->cmp == NULL) {
+		return NULL;
+	}
+	nmvect_counting_cur.cmp = vect->cmp;
+	nmvect_counting_cur.stats = &vect->stats;
+	return nmvect_counting_cmp;
+#else
+	(void) saved;
+	return vect->cmp;
+#endif
+}
+
+/**
+ * THIS FUNCTION IS PRIVATE.
+ * Stops counting the comparator calls of 'nmvect_counting_begin'.
+ **/
+static void nmvect_counting_end(const nmvect_counting *saved)
+{
+#ifdef NM_STATS
+	nmvect_counting_cur = *saved;
+#else
+	(void) saved;
+#endif
+}
+
+/**
+ * Sorts the vector in place using its comparator (introsort,
+ * equal elements may be reordered).
+ *
+ * 'nmvect_element' only wraps a pointer, so the array is sorted
+ * directly by 'nmsort', no copy is made.
+ *
+ * RETURNS:
+ * 0			If operation was succesful.
+ * -1			If vect is NULL or has no comparator.
+ **/
+int nmvect_sort(nmvect *vect)
+{
+	nmvect_counting saved;
+	int rc;
+	if (vect == NULL) {
+		return (-1);
+	}
+	rc = nmsort_intro((void**) vect->array, vect->size,
+	                  nmvect_counting_begin(vect, &saved));
+	nmvect_counting_end(&saved);
+	return rc;
+}
+
+/**
+ * Sorts the vector in place using its comparator, keeping equal
+ * elements in their original order (merge sort, needs a temporary
+ * buffer of 'size' pointers).
+ *
+ * RETURNS:
+ * 0			If operation was succesful.
+ * -1			If vect is NULL, has no comparator or memory
+ * 				allocation fails (the vector is left untouched).
+ **/
+int nmvect_stable_sort(nmvect *vect)
+{
+	nmvect_counting saved;
+	int rc;
+	if (vect == NULL) {
+		return (-1);
+	}
+	rc = nmsort_stable((void**) vect->array, vect->size,
+	                   nmvect_counting_begin(vect, &saved));
+	nmvect_counting_end(&saved);
+	return rc;
+}
+
+/**
+ * Sorts the vector in place using up to 'threads' threads (see
+ * 'nmsort_parallel'). Vectors shorter than NMSORT_PARALLEL_MIN
+ * are sorted in the calling thread, like 'nmvect_sort'.
+ *
+ * The comparator is called concurrently and must be thread safe.
+ * Its calls are not counted in the NM_STATS counters.
+ *
+ * RETURNS:
+ * 0			If operation was succesful.
+ * -1			If vect is NULL, has no comparator or memory
+ * 				allocation fails (the vector is left untouched).
+ **/
+int nmvect_sort_parallel(nmvect *vect, unsigned int threads)
+{
+	if (vect == NULL) {
+		return (-1);
+	}
+	return nmsort_parallel((void**) vect->array, vect->size, vect->cmp, threads);
+}
+
+/**
+ * Returns the position of the first element not less than 'data'
+ * in a vector sorted by its comparator ('size' if there is none).
+ *
+ * RETURNS:
+ * The position.
+ * -1			If vect is NULL, has no comparator or holds
+ * 				more than INT_MAX elements (the position
+ * 				wouldn't fit).
+ **/
+int nmvect_lower_bound(nmvect *vect, const void *data)
+{
+	nmvect_counting saved;
+	unsigned int index;
+	if (vect == NULL || vect->cmp == NULL || vect->size > INT_MAX) {
+		return (-1);
+	}
+	index = nmsort_lower_bound((void *const*) vect->array, vect->size, data,
+	                           nmvect_counting_begin(vect, &saved));
+	nmvect_counting_end(&saved);
+	return (int) index;
+}
+
+/**
+ * Returns the position of the first element greater than 'data'
+ * in a vector sorted by its comparator ('size' if there is none).
+ *
+ * RETURNS:
+ * The position.
+ * -1			If vect is NULL, has no comparator or holds
+ * 				more than INT_MAX elements (the position
+ * 				wouldn't fit).
+ **/
+int nmvect_upper_bound(nmvect *vect, const void *data)
+{
+	nmvect_counting saved;
+	unsigned int index;
+	if (vect == NULL || vect->cmp == NULL || vect->size > INT_MAX) {
+		return (-1);
+	}
+	index = nmsort_upper_bound((void *const*) vect->array, vect->size, data,
+	                           nmvect_counting_begin(vect, &saved));
+	nmvect_counting_end(&saved);
+	return (int) index;
+}
+
+/**
+ * Binary search for 'data' in a vector sorted by its comparator.
+ *
+ * RETURNS:
+ * The position of the first element equal to 'data'.
+ * -1			If not found, vect is NULL, has no comparator
+ * 				or holds more than INT_MAX elements.
+ **/
+int nmvect_bsearch(nmvect *vect, const void *data)
+{
+	int index = nmvect_lower_bound(vect, data);
+	if (index < 0 || (unsigned int) index == vect->size) {
+		return (-1);
+	}
+	NM_STAT_INC(vect->stats, cmps);
+	if (vect->cmp(vect->array[index].data, data) != 0) {
+		return (-1);
+	}
+	return index;
+}
+
+/**
+ * Inserts 'data' into a vector sorted by its comparator, after
+ * the elements equal to it, so the vector stays sorted.
+ *
+ * RETURNS:
+ * The position where 'data' was inserted.
+ * -1			If vect is NULL, has no comparator, holds more
+ * 				than INT_MAX elements or the insertion wasn't
+ * 				succesful.
+ **/
+int nmvect_insert_sorted(nmvect *vect, const void *data)
+{
+	int index = nmvect_upper_bound(vect, data);
+	if (index < 0 || nmvect_insert(vect, (unsigned int) index, data) != 0) {
+		return (-1);
+	}
+	return index;
+}
+
+/**
+ * THIS FUNCTION IS PRIVATE.
+ * 'nmtpool_for' body of 'nmvect_parallel_for_each'.
+ **/
+static void nmvect_par_each(void *arg, unsigned int lo, unsigned int hi,
+                            unsigned int worker)
+{
+	nmvect_par *par = arg;
+	(void) worker;
+	for (; lo < hi; lo++) {
+		par->each(par->vect->array[lo].data, par->arg);
+	}
+}
+
+/**
+ * THIS FUNCTION IS PRIVATE.
+ * 'nmtpool_for' body of 'nmvect_parallel_map'.
+ **/
+static void nmvect_par_map(void *arg, unsigned int lo, unsigned int hi,
+                           unsigned int worker)
+{
+	nmvect_par *par = arg;
+	(void) worker;
+	for (; lo < hi; lo++) {
+		par->result->array[lo].data = par->map(par->vect->array[lo].data, par->arg);
+	}
+}
+
+/**
+ * THIS FUNCTION IS PRIVATE.
+ * 'nmtpool_for' body of 'nmvect_parallel_reduce'.
+ **/
+static void nmvect_par_reduce(void *arg, unsigned int lo, unsigned int hi,
+                              unsigned int worker)
+{
+	nmvect_par *par = arg;
+	void *acc = par->partials[worker];
+	for (; lo < hi; lo++) {
+		acc = par->reduce(acc, par->vect->array[lo].data, par->arg);
+	}
+	par->partials[worker] = acc;
+}
+
+/**
+ * Calls 'fn(data, arg)' on every element of the vector, spread
+ * over the workers of 'pool' (see 'nmtpool_for').
+ *
+ * 'fn' runs concurrently on different elements, in no particular
+ * order. The vector must not be modified meanwhile.
+ *
+ * INPUT:
+ * 'vect'		The vector.
+ * 'pool'		The thread pool, NULL to run in the calling thread.
+ * 'fn'			Function called on every element.
+ * 'arg'		Argument passed to 'fn'.
+ *
+ * RETURNS:
+ * 0			If operation was succesful.
+ * -1			If vect or fn are NULL, or memory allocation fails.
+ **/
+int nmvect_parallel_for_each(nmvect *vect, nmtpool *pool,
+                             void (*fn)(void *data, void *arg), void *arg)
+{
+	nmvect_par par;
+	if (vect == NULL || fn == NULL) {
+		return (-1);
+	}
+	par.vect = vect;
+	par.each = fn;
+	par.arg = arg;
+	return nmtpool_for(pool, vect->size, 0, nmvect_par_each, &par);
+}
+
+/**
+ * Returns a new vector holding 'fn(data, arg)' for every element
+ * of 'vect', in the same order. The calls are spread over the
+ * workers of 'pool' and run concurrently.
+ *
+ * INPUT:
+ * 'vect'		The source vector.
+ * 'pool'		The thread pool, NULL to run in the calling thread.
+ * 'fn'			Function computing an element of the new vector.
+ * 'arg'		Argument passed to 'fn'.
+ * 'destructor'	Destructor of the new vector.
+ * 'cmp'		Comparator of the new vector.
+ *
+ * RETURNS:
+ * NULL			If vect or fn are NULL, or memory allocation fails.
+ * The new vector.
+ **/
+nmvect *nmvect_parallel_map(nmvect *vect, nmtpool *pool,
+                            void *(*fn)(const void *data, void *arg), void *arg,
+                            void (*destructor)(void *data),
+                            int (*cmp)(const void *e1, const void *e2))
+{
+	nmvect_par par;
+	if (vect == NULL || fn == NULL) {
+		return NULL;
+	}
+	if ((par.result = nmvect_alloc_with((vect->size > 0) ? vect->size : 1,
+	                                    destructor, cmp, vect->allocator)) == NULL) {
+		return NULL;
+	}
+	par.vect = vect;
+	par.map = fn;
+	par.arg = arg;
+	if (nmtpool_for(pool, vect->size, 0, nmvect_par_map, &par) != 0) {
+		nm_free(vect->allocator, par.result->array);
+		nm_free(vect->allocator, par.result);
+		return NULL;
+	}
+	par.result->size = vect->size;
+	return par.result;
+}
+
+/**
+ * Folds the elements of the vector with 'reduce', spread over the
+ * workers of 'pool'.
+ *
+ * Every worker starts from 'identity' and folds the elements it
+ * processes with 'acc = reduce(acc, data, arg)'; the per worker
+ * results are then folded with 'combine(acc1, acc2, arg)' in the
+ * calling thread. Workers process chunks in no particular order,
+ * so 'reduce' / 'combine' must be associative and commutative,
+ * and must not modify 'identity' (it is shared by all workers).
+ *
+ * INPUT:
+ * 'vect'		The vector.
+ * 'pool'		The thread pool, NULL to run in the calling thread.
+ * 'reduce'		Folds an element into an accumulator.
+ * 'combine'	Folds two accumulators.
+ * 'identity'	Initial accumulator.
+ * 'arg'		Argument passed to 'reduce' and 'combine'.
+ * 'result'		Where to store the result.
+ *
+ * RETURNS:
+ * 0			If operation was succesful.
+ * -1			If vect, reduce, combine or result are NULL, or
+ * 				memory allocation fails.
+ **/
+int nmvect_parallel_reduce(nmvect *vect, nmtpool *pool,
+                           void *(*reduce)(void *acc, void *data, void *arg),
+                           void *(*combine)(void *acc1, void *acc2, void *arg),
+                           void *identity, void *arg, void **result)
+{
+	nmvect_par par;
+	unsigned int i, workers = nmtpool_size(pool);
+	void *acc;
+	if (vect == NULL || reduce == NULL || combine == NULL || result == NULL) {
+		return (-1);
+	}
+	if ((par.partials = malloc(workers * sizeof(*par.partials))) == NULL) {
+		return (-1);
+	}
+	for (i = 0; i < workers; i++) {
+		par.partials[i] = identity;
+	}
+	par.vect = vect;
+	par.reduce = reduce;
+	par.arg = arg;
+	if (nmtpool_for(pool, vect->size, 0, nmvect_par_reduce, &par) != 0) {
+		free(par.partials);
+		return (-1);
+	}
+	acc = par.partials[0];
+	for (i = 1; i < workers; i++) {
+		acc = combine(acc, par.partials[i], arg);
+	}
+	free(par.partials);
+	*result = acc;
+	return (0);
+}
+
 /**
  * Returns data contained at the specified index.
  *
@@ -413,22 +1102,43 @@ int nmvect_set(nmvect *vect, unsigned int index, const void *data)
 void *nmvect_remove(nmvect *vect, unsigned int index)
 {
 	void *data;
-	int i;
 	if (vect == NULL || index >= vect->size) {
 		return NULL;
 	}
-	if (vect->size == vect->capacity * 2 / 3 + 1) {
-		/* Eventually contract the vector capacity */
-		nmvect_contract(vect);
-	}
 	data = vect->array[index].data;
 	vect->size--;
-	for (i = index; i < vect->size; i++) {
-		vect->array[i].data = vect->array[i+1].data;
-	}
+	memmove(&vect->array[index], &vect->array[index + 1],
+	        (vect->size - index) * sizeof(*vect->array));
+	NM_STAT_ADD(vect->stats, shifted, vect->size - index);
+	/* Eventually contract the vector capacity */
+	nmvect_autoshrink(vect);
 	return (data);
 }
 
+/**
+ * Removes the last element from 'vect', and returns the 'data'
+ * it contained.
+ *
+ * Unlike 'nmvect_remove' the capacity is never contracted, so
+ * alternating appends and removals at the end of the vector
+ * (eg. using it as a stack) don't re-allocate memory.
+ *
+ * INPUT:
+ * 'vect'		The vector.
+ *
+ * RETURNS:
+ * NULL			If 'vect' is NULL or empty.
+ * 'data'		Data contained by the last element.
+ **/
+void *nmvect_remove_last(nmvect *vect)
+{
+	if (vect == NULL || vect->size == 0) {
+		return NULL;
+	}
+	vect->size--;
+	return vect->array[vect->size].data;
+}
+
 /**
  * Removes a "slice" of the vector starting from 'start' index
  * until the 'stop' index.
@@ -448,30 +1158,24 @@ nmvect *nmvect_remove_range(nmvect *vect, unsigned int start, unsigned int stop)
 {
 	nmvect *rvect = NULL;
 	int dif;
-	int i, ilim;
 	if (vect == NULL ||
 	        start >= vect->size ||
 	        stop > vect->size ||
-	        (stop - start) <= 0 ||
-	        (rvect = nmvect_alloc((stop-start), vect->destructor, vect->cmp)) == NULL) {
+	        stop <= start ||
+	        (rvect = nmvect_alloc_with((stop-start), vect->destructor, vect->cmp,
+	                                   vect->allocator)) == NULL) {
 		return NULL;
 	}
+	dif = stop - start;
 	/* Generating response */
-	for (i = start; i < stop; i++) {
-		if (nmvect_append(rvect, vect->array[i].data) != 0) {
-			free(rvect->array);
-			free(rvect);
-			return NULL;
-		}
-	}
+	memcpy(rvect->array, &vect->array[start], dif * sizeof(*vect->array));
+	rvect->size = dif;
 	/* Removing elements */
-	dif = stop - start;
-	ilim = vect->size - dif;
-	for (i = start; i < ilim; i++) {
-		vect->array[i].data = vect->array[i+dif].data;
-	}
-	nmvect_modcap(vect, -dif);
+	memmove(&vect->array[start], &vect->array[stop],
+	        (vect->size - stop) * sizeof(*vect->array));
+	NM_STAT_ADD(vect->stats, shifted, vect->size - stop);
 	vect->size -= dif;
+	nmvect_autoshrink(vect);
 	return rvect;
 }
 
@@ -540,3 +1244,64 @@ unsigned int nmvect_size(nmvect *vect)
 {
 	return vect->size;
 }
+
+/**
+ * Returns vector destructor.
+ **/
+void (*nmvect_get_destructor(nmvect *vect))(void *data)
+{
+	return vect->destructor;
+}
+
+/**
+ * Returns vector comparator.
+ **/
+int (*nmvect_get_cmp(nmvect *vect))(const void *e1, const void *e2)
+{
+	return vect->cmp;
+}
+
+/**
+ * Copies the instrumentation counters of 'vect' (see 'nm_stats').
+ *
+ * RETURNS:
+ * 0				If the counters were copied to 'stats'.
+ * -1				If 'vect' or 'stats' is NULL, or the library
+ * 					was built without NM_STATS.
+ **/
+int nmvect_stats(nmvect *vect, nm_stats *stats)
+{
+#ifdef NM_STATS
+	if (vect == NULL || stats == NULL) {
+		return (-1);
+	}
+	*stats = vect->stats;
+	return (0);
+#else
+	(void) vect;
+	(void) stats;
+	return (-1);
+#endif
+}
+
+/**
+ * Sets the instrumentation counters of 'vect' back to zero.
+ *
+ * RETURNS:
+ * 0				If the counters were reset.
+ * -1				If 'vect' is NULL, or the library was built
+ * 					without NM_STATS.
+ **/
+int nmvect_stats_reset(nmvect *vect)
+{
+#ifdef NM_STATS
+	if (vect == NULL) {
+		return (-1);
+	}
+	memset(&vect->stats, 0, sizeof(vect->stats));
+	return (0);
+#else
+	(void) vect;
+	return (-1);
+#endif
+}
@@ -3,12 +3,30 @@
 
 #include "nmlist.h"
 #include "nmaux.h"
+#include "nmtpool.h"
 
 typedef struct nmvect_element_s nmvect_element;
 typedef struct nmvect_s nmvect;
 
+/* Capacity growth / shrink policy, see 'nmvect_set_policy'. */
+typedef struct nmvect_policy_s {
+	unsigned int grow_num;
+	unsigned int grow_den;
+	unsigned int min_cap;
+	unsigned int shrink_div;
+} nmvect_policy;
+
+extern const nmvect_policy nmvect_policy_default;
+extern const nmvect_policy nmvect_policy_noshrink;
+
 nmvect *nmvect_alloc(unsigned int icap, void (*destructor)(void *data), int (*cmp)(const void *e1, const void *e2));
+nmvect *nmvect_alloc_with(unsigned int icap, void (*destructor)(void *data),
+                          int (*cmp)(const void *e1, const void *e2),
+                          const nm_allocator *allocator);
 int nmvect_free(nmvect *vect);
+int nmvect_set_policy(nmvect *vect, const nmvect_policy *policy);
+int nmvect_reserve(nmvect *vect, unsigned int cap);
+int nmvect_shrink_to_fit(nmvect *vect);
 int nmvect_modcap(nmvect *vect, int modif);
 int nmvect_expand(nmvect *vect);
 int nmvect_contract(nmvect *vect);
@@ -17,14 +35,42 @@ int nmvect_insert_range(nmvect *vect, unsigned int index, nmvect *addvect);
 int nmvect_append(nmvect *vect, const void *data);
 int nmvect_append_range(nmvect *vect, unsigned int index, nmvect *appvect);
 int nmvect_contains(nmvect *vect, const void *data);
+int nmvect_find_ptr(nmvect *vect, const void *data);
 nmlist *nmvect_occurence(nmvect *vect, const void *data);
+int nmvect_find_all(nmvect *vect, const void *data,
+                    unsigned int *indices, unsigned int limit);
+int nmvect_find_all_buf(nmvect *vect, const void *data, unsigned int **buf,
+                        unsigned int *bufcap, unsigned int limit);
+int nmvect_sort(nmvect *vect);
+int nmvect_stable_sort(nmvect *vect);
+int nmvect_sort_parallel(nmvect *vect, unsigned int threads);
+int nmvect_bsearch(nmvect *vect, const void *data);
+int nmvect_lower_bound(nmvect *vect, const void *data);
+int nmvect_upper_bound(nmvect *vect, const void *data);
+int nmvect_insert_sorted(nmvect *vect, const void *data);
+int nmvect_parallel_for_each(nmvect *vect, nmtpool *pool,
+                             void (*fn)(void *data, void *arg), void *arg);
+nmvect *nmvect_parallel_map(nmvect *vect, nmtpool *pool,
+                            void *(*fn)(const void *data, void *arg), void *arg,
+                            void (*destructor)(void *data),
+                            int (*cmp)(const void *e1, const void *e2));
+int nmvect_parallel_reduce(nmvect *vect, nmtpool *pool,
+                           void *(*reduce)(void *acc, void *data, void *arg),
+                           void *(*combine)(void *acc1, void *acc2, void *arg),
+                           void *identity, void *arg, void **result);
 void *nmvect_get(nmvect *vect, unsigned int index);
 int nmvect_set(nmvect *vect, unsigned int index, const void *data);
 void *nmvect_remove(nmvect *vect, unsigned int index);
+void *nmvect_remove_last(nmvect *vect);
 nmvect *nmvect_remove_range(nmvect *vect, unsigned int start, unsigned int stop);
 int nmvect_purge(nmvect *vect, unsigned int index);
 int nmvect_purge_range(nmvect *vect, unsigned int start, unsigned int stop);
 unsigned int nmvect_capacity(nmvect *vect);
 unsigned int nmvect_size(nmvect *size);
+void (*nmvect_get_destructor(nmvect *vect))(void *data);
+int (*nmvect_get_cmp(nmvect *vect))(const void *e1, const void *e2);
+
+int nmvect_stats(nmvect *vect, nm_stats *stats);
+int nmvect_stats_reset(nmvect *vect);
 
 #endif
\ No newline at end of file
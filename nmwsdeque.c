@@ -0,0 +1,244 @@
+#include <stdatomic.h>
+#include <stdlib.h>
+#include "nmwsdeque.h"
+
+/* Chase-Lev work-stealing deque, with the C11 memory orders of
+ * Le, Pop, Cohen & Zappa Nardelli ("Correct and Efficient
+ * Work-Stealing for Weak Memory Models", PPoPP 2013).
+ *
+ * The owner thread pushes and pops at 'bottom'; any other thread
+ * steals from 'top'. Elements live in a circular array indexed
+ * by the (ever increasing) positions. When full, the owner copies
+ * the live part to an array twice as big; thieves may still be
+ * reading the old one, so it is kept on the 'retired' list until
+ * the deque is freed. */
+typedef struct nmwsdeque_array_s {
+	struct nmwsdeque_array_s *retired;
+	long long mask;
+	_Atomic(void*) slots[];
+} nmwsdeque_array;
+
+struct nmwsdeque_s {
+	void (*destructor)(void *data);
+	char pad0[NM_CACHE_LINE];
+	atomic_llong top;
+	char pad1[NM_CACHE_LINE - sizeof(atomic_llong)];
+	atomic_llong bottom;
+	_Atomic(nmwsdeque_array*) array;
+	char pad2[NM_CACHE_LINE - sizeof(atomic_llong) - sizeof(void*)];
+};
+
+/**
+ * THIS FUNCTION IS PRIVATE.
+ * Allocates an array of 'cap' (a power of two) slots.
+ **/
+static nmwsdeque_array *nmwsdeque_array_alloc(long long cap)
+{
+	nmwsdeque_array *array = NULL;
+	array = malloc(sizeof(*array) + (size_t) cap * sizeof(array->slots[0]));
+	if (array == NULL) {
+		return NULL;
+	}
+	array->retired = NULL;
+	array->mask = cap - 1;
+	return array;
+}
+
+/**
+ * Allocates memory for a new empty deque.
+ *
+ * INPUT:
+ * 'icap'			Initial capacity, rounded up to a power of two
+ * 					(the deque grows as needed).
+ * 'destructor'		Destructor for 'data' being hold by the deque.
+ *
+ * RETURNS:
+ * NULL				If memory allocation fails.
+ * A new deque.
+ **/
+nmwsdeque *nmwsdeque_alloc(unsigned int icap, void (*destructor)(void *data))
+{
+	nmwsdeque *deque = NULL;
+	nmwsdeque_array *array = NULL;
+	long long cap = 2;
+	while (cap < icap) {
+		cap <<= 1;
+	}
+	if ((deque = calloc(1, sizeof(*deque))) == NULL) {
+		return NULL;
+	}
+	if ((array = nmwsdeque_array_alloc(cap)) == NULL) {
+		free(deque);
+		return NULL;
+	}
+	deque->destructor = destructor;
+	atomic_init(&deque->top, 0);
+	atomic_init(&deque->bottom, 0);
+	atomic_init(&deque->array, array);
+	return deque;
+}
+
+/**
+ * De-allocates memory for the deque, and the arrays it outgrew.
+ * The data still being hold by the deque is purged.
+ *
+ * Must not be called while other threads use the deque.
+ *
+ * RETURNS:
+ * 0				If deque was succesfuly de-allocated.
+ * -1				If something went wrong (deque is NULL,
+ * 					destructor is NULL).
+ **/
+int nmwsdeque_free(nmwsdeque *deque)
+{
+	nmwsdeque_array *array, *retired;
+	void *data;
+	if (deque == NULL || deque->destructor == NULL) {
+		return (-1);
+	}
+	while (nmwsdeque_pop(deque, &data) == 0) {
+		if (data != NULL) {
+			deque->destructor(data);
+		}
+	}
+	for (array = atomic_load(&deque->array); array != NULL; array = retired) {
+		retired = array->retired;
+		free(array);
+	}
+	free(deque);
+	return (0);
+}
+
+/**
+ * Pushes 'data' at the bottom of the deque, doubling its
+ * capacity when full. Owner thread only.
+ *
+ * RETURNS:
+ * 0				If operation was succesful.
+ * -1				If deque is NULL or memory allocation fails.
+ **/
+int nmwsdeque_push(nmwsdeque *deque, const void *data)
+{
+	nmwsdeque_array *array, *grown;
+	long long b, t, i;
+	if (deque == NULL) {
+		return (-1);
+	}
+	b = atomic_load_explicit(&deque->bottom, memory_order_relaxed);
+	t = atomic_load_explicit(&deque->top, memory_order_acquire);
+	array = atomic_load_explicit(&deque->array, memory_order_relaxed);
+	if (b - t > array->mask) {
+		if ((grown = nmwsdeque_array_alloc(2 * (array->mask + 1))) == NULL) {
+			return (-1);
+		}
+		for (i = t; i < b; i++) {
+			atomic_store_explicit(&grown->slots[i & grown->mask],
+			                      atomic_load_explicit(&array->slots[i & array->mask],
+			                                           memory_order_relaxed),
+			                      memory_order_relaxed);
+		}
+		grown->retired = array;
+		atomic_store_explicit(&deque->array, grown, memory_order_release);
+		array = grown;
+	}
+	atomic_store_explicit(&array->slots[b & array->mask], (void*) data,
+	                      memory_order_relaxed);
+	atomic_thread_fence(memory_order_release);
+	atomic_store_explicit(&deque->bottom, b + 1, memory_order_relaxed);
+	return (0);
+}
+
+/**
+ * Pops the most recently pushed element (LIFO end). Owner
+ * thread only.
+ *
+ * INPUT:
+ * 'deque'			The deque.
+ * 'data'			Where the element is stored.
+ *
+ * RETURNS:
+ * 0				If an element was popped into '*data'.
+ * -1				If the deque is empty (or the last element was
+ * 					stolen meanwhile), or deque is NULL.
+ **/
+int nmwsdeque_pop(nmwsdeque *deque, void **data)
+{
+	nmwsdeque_array *array;
+	long long b, t;
+	void *tmp;
+	if (deque == NULL || data == NULL) {
+		return (-1);
+	}
+	b = atomic_load_explicit(&deque->bottom, memory_order_relaxed) - 1;
+	array = atomic_load_explicit(&deque->array, memory_order_relaxed);
+	atomic_store_explicit(&deque->bottom, b, memory_order_relaxed);
+	atomic_thread_fence(memory_order_seq_cst);
+	t = atomic_load_explicit(&deque->top, memory_order_relaxed);
+	if (t > b) {
+		atomic_store_explicit(&deque->bottom, b + 1, memory_order_relaxed);
+		return (-1);
+	}
+	tmp = atomic_load_explicit(&array->slots[b & array->mask], memory_order_relaxed);
+	if (t == b) {
+		/* last element: race the thieves for it */
+		atomic_store_explicit(&deque->bottom, b + 1, memory_order_relaxed);
+		if (!atomic_compare_exchange_strong_explicit(&deque->top, &t, t + 1,
+		        memory_order_seq_cst, memory_order_relaxed)) {
+			return (-1);
+		}
+	}
+	*data = tmp;
+	return (0);
+}
+
+/**
+ * Steals the oldest element (FIFO end). Any thread.
+ *
+ * INPUT:
+ * 'deque'			The deque.
+ * 'data'			Where the element is stored.
+ *
+ * RETURNS:
+ * 0				If an element was stolen into '*data'.
+ * 1				If another thread took the element first (the
+ * 					deque may not be empty, try again).
+ * -1				If the deque is empty, or deque is NULL.
+ **/
+int nmwsdeque_steal(nmwsdeque *deque, void **data)
+{
+	nmwsdeque_array *array;
+	long long b, t;
+	void *tmp;
+	if (deque == NULL || data == NULL) {
+		return (-1);
+	}
+	t = atomic_load_explicit(&deque->top, memory_order_acquire);
+	atomic_thread_fence(memory_order_seq_cst);
+	b = atomic_load_explicit(&deque->bottom, memory_order_acquire);
+	if (t >= b) {
+		return (-1);
+	}
+	array = atomic_load_explicit(&deque->array, memory_order_acquire);
+	tmp = atomic_load_explicit(&array->slots[t & array->mask], memory_order_relaxed);
+	if (!atomic_compare_exchange_strong_explicit(&deque->top, &t, t + 1,
+	        memory_order_seq_cst, memory_order_relaxed)) {
+		return (1);
+	}
+	*data = tmp;
+	return (0);
+}
+
+/**
+ * Returns the number of elements of the deque. With concurrent
+ * thieves the result is only a snapshot.
+ **/
+unsigned int nmwsdeque_size(nmwsdeque *deque)
+{
+	long long b, t;
+	if (deque == NULL) {
+		return 0;
+	}
+	t = atomic_load_explicit(&deque->top, memory_order_acquire);
+	b = atomic_load_explicit(&deque->bottom, memory_order_acquire);
+	return (b > t) ? (unsigned int) (b - t) : 0;
+}
@@ -0,0 +1,15 @@
+#ifndef __NM__WSDEQUE__H__
+#define __NM__WSDEQUE__H__
+#include "nmaux.h"
+
+typedef struct nmwsdeque_s nmwsdeque;
+
+nmwsdeque *nmwsdeque_alloc(unsigned int icap, void (*destructor)(void *data));
+int nmwsdeque_free(nmwsdeque *deque);
+
+int nmwsdeque_push(nmwsdeque *deque, const void *data);
+int nmwsdeque_pop(nmwsdeque *deque, void **data);
+int nmwsdeque_steal(nmwsdeque *deque, void **data);
+unsigned int nmwsdeque_size(nmwsdeque *deque);
+
+#endif